@@ -42,5 +42,21 @@ class BashStateMachine : public StateMachine {
          * @return Output of running the given terminal command in bash
          */
         string Apply(string command);
+
+        /**
+         * Commands act on the host (its files, processes, ...) rather than
+         * on state kept in this class, so there is nothing to write to a
+         * snapshot.
+         *
+         * @param output Stream to write the snapshot to
+         */
+        void Serialize(ostream& output) {}
+
+        /**
+         * Nothing to restore, see Serialize.
+         *
+         * @param input Stream to read the snapshot from
+         */
+        void Restore(istream& input) {}
     private:
 };
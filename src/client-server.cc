@@ -1,5 +1,18 @@
 #include "client-server.h"
 
+#include <netinet/tcp.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+// Most bytes read from a client connection at once
+static const int RECEIVE_CHUNK_SIZE = 16384;
+
+ClientServer::ClientConnection::~ClientConnection() {
+    Util::SafeClose(socket);
+}
+
 ClientServer::ClientServer(RequestCallback request_callback) :
     server_state(Waiting), request_callback(request_callback),
     thread_pool(THREAD_POOL_SIZE) {
@@ -53,8 +66,25 @@ void ClientServer::Listen(unsigned short listen_port) {
         debug("Client connection from %s:%d", inet_ntoa(client_info.sin_addr),
             ntohs(client_info.sin_port));
 
-        thread_pool.schedule([this, client_socket]() {
-            HandleClientConnection(client_socket);
+        // Responses are written whole, and shouldn't wait for the client to
+        // acknowledge the ones before them
+        if (setsockopt(client_socket, IPPROTO_TCP, TCP_NODELAY, &val, sizeof(int)) == -1) {
+            warn("Error setting TCP_NODELAY on socket %d (%s)", client_socket, strerror(errno));
+        }
+        // Keep a client that stops reading from holding up the responses of
+        // other clients for long
+        struct timeval send_timeout;
+        send_timeout.tv_sec = CLIENT_SEND_TIMEOUT / 1'000;
+        send_timeout.tv_usec = (CLIENT_SEND_TIMEOUT % 1'000) * 1'000;
+        if (setsockopt(client_socket, SOL_SOCKET, SO_SNDTIMEO, &send_timeout,
+                sizeof(send_timeout)) == -1) {
+            warn("Error setting send timeout on socket %d (%s)", client_socket, strerror(errno));
+        }
+
+        shared_ptr<ClientConnection> connection =
+            make_shared<ClientConnection>(client_socket);
+        event_loop.Watch(client_socket, EVENT_READ, [this, connection](int events) {
+            HandleConnectionEvent(connection);
         });
     }
 
@@ -62,29 +92,28 @@ void ClientServer::Listen(unsigned short listen_port) {
 }
 
 void ClientServer::RespondToClient(int request_id, string& response) {
-    lock_guard<mutex> lock(server_mutex);
+    PendingRequest request;
+    {
+        lock_guard<mutex> lock(server_mutex);
 
-    if (pending_client_sockets.count(request_id) == 0) {
-        warn("Attempting to respond to non-existant request %d", request_id);
-        return;
+        if (pending_requests.count(request_id) == 0) {
+            if (requests_in_callback == 0) {
+                // Not ours, e.g. an entry from an earlier leader's term
+                return;
+            }
+            // The request may have completed before the thread that received
+            // it registered it; hold the response until it does
+            debug("Holding response to unregistered request %d", request_id);
+            early_responses[request_id] = response;
+            return;
+        }
+        request = pending_requests[request_id];
+        pending_requests.erase(request_id);
     }
 
-    int client_socket = pending_client_sockets[request_id];
     debug("Responding to client (request_id: %d, response: %s)", request_id, response.c_str());
-    const char * response_cstr = response.c_str();
-
-    int len = strlen(response_cstr);
-    if (write(client_socket, &len, sizeof(int)) == -1) {
-        warn("Could not write to socket %d (%s)", client_socket, strerror(errno));
-    } else {
-        dprintf(client_socket, "%s", response_cstr);
-
-        shutdown(client_socket, SHUT_WR);
-        char buf[1];
-        recv(client_socket, buf, 1, 0);
-        pending_client_sockets.erase(request_id);
-    }
-    Util::SafeClose(client_socket);
+    SendResponse(*request.connection, request.client_request_id,
+        CLIENT_RESPONSE_OK, response);
 }
 
 void ClientServer::StartServing() {
@@ -97,26 +126,95 @@ void ClientServer::StartServing() {
 }
 
 void ClientServer::StartRedirecting(ServerInfo * new_redirect_server_info) {
-    lock_guard<mutex> lock(server_mutex);
+    map<int, PendingRequest> redirected_requests;
+    string redirect;
+    {
+        lock_guard<mutex> lock(server_mutex);
 
-    redirect_server_info = new_redirect_server_info;
+        redirect_server_info = new_redirect_server_info;
 
-    info("Start redirecting clients to %s:%d",
-        redirect_server_info->ip_addr.c_str(),
-        redirect_server_info->port);
+        info("Start redirecting clients to %s:%d",
+            redirect_server_info->ip_addr.c_str(),
+            redirect_server_info->port);
 
-    server_state = Redirecting;
+        server_state = Redirecting;
+        redirected_requests.swap(pending_requests);
+        redirect = RedirectBody();
+        early_responses.clear();
+        server_cv.notify_all();
+    }
 
-    // Close pending client sockets so clients attempt to find new leader
-    for (pair<int, int> pending_client_socket: pending_client_sockets) {
-        int client_socket = pending_client_socket.second;
-        Util::SafeClose(client_socket);
+    // Send pending requests back so clients retry them with the new leader.
+    // Our caller may be holding up Raft until we return, so leave the writes
+    // (which can wait on slow clients) to the thread pool
+    if (!redirected_requests.empty()) {
+        thread_pool.schedule([this, redirected_requests, redirect]() {
+            for (const pair<const int, PendingRequest>& pending_request :
+                    redirected_requests) {
+                const PendingRequest& request = pending_request.second;
+                SendResponse(*request.connection, request.client_request_id,
+                    CLIENT_RESPONSE_REDIRECT, redirect);
+            }
+        });
+    }
+}
+
+void ClientServer::HandleConnectionEvent(shared_ptr<ClientConnection> connection) {
+    bool hung_up = false;
+    char buf[RECEIVE_CHUNK_SIZE];
+    while (true) {
+        int new_bytes = recv(connection->socket, buf, sizeof(buf), MSG_DONTWAIT);
+        if (new_bytes == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else if (new_bytes == -1 && errno == EINTR) {
+            continue;
+        } else if (new_bytes == -1) {
+            debug("Error reading from socket %d (%s)", connection->socket, strerror(errno));
+            hung_up = true;
+            break;
+        } else if (new_bytes == 0) {
+            debug("Client disconnected from socket %d", connection->socket);
+            hung_up = true;
+            break;
+        }
+        connection->received.append(buf, new_bytes);
+    }
+
+    // Many requests may have arrived at once
+    size_t start = 0;
+    string& received = connection->received;
+    while (received.size() - start >= sizeof(ClientMessageHeader)) {
+        ClientMessageHeader header;
+        memcpy(&header, &received[start], sizeof(header));
+        if (header.len < 0 || header.len > MAX_CLIENT_COMMAND_BYTES) {
+            warn("Malformed request from socket %d", connection->socket);
+            hung_up = true;
+            break;
+        }
+        if (received.size() - start - sizeof(header) < (size_t) header.len) {
+            // The rest of the request comes with a later read
+            break;
+        }
+        string command = received.substr(start + sizeof(header), header.len);
+        start += sizeof(header) + header.len;
+
+        int client_request_id = header.request_id;
+        thread_pool.schedule([this, connection, client_request_id, command]() {
+            HandleRequest(connection, client_request_id, command);
+        });
+    }
+    received.erase(0, start);
+
+    if (hung_up) {
+        // The connection is closed once the requests it is still owed a
+        // response for let go of it
+        event_loop.Unwatch(connection->socket);
+        received.clear();
     }
-    pending_client_sockets.clear();
-    server_cv.notify_all();
 }
 
-void ClientServer::HandleClientConnection(int client_socket) {
+void ClientServer::HandleRequest(shared_ptr<ClientConnection> connection,
+        int client_request_id, string command) {
     server_mutex.lock();
 
     while (server_state == Waiting) {
@@ -127,49 +225,101 @@ void ClientServer::HandleClientConnection(int client_socket) {
     if (server_state == Redirecting) {
         info("Redirecting client to %s:%d",
             redirect_server_info->ip_addr.c_str(), redirect_server_info->port);
-        int redirect_sentinel = -1;
-        write(client_socket, &redirect_sentinel, sizeof(int));
-        write(client_socket, redirect_server_info, sizeof(ServerInfo));
+        string redirect = RedirectBody();
         server_mutex.unlock();
 
-        shutdown(client_socket, SHUT_WR);
-        char buf[1];
-        recv(client_socket, buf, 1, 0);
-        Util::SafeClose(client_socket);
-
+        SendResponse(*connection, client_request_id, CLIENT_RESPONSE_REDIRECT,
+            redirect);
         return;
     }
+    requests_in_callback++;
     server_mutex.unlock();
 
-    int message_size;
-    int bytes_read = 0;
-    while (bytes_read < sizeof(int)) {
-        void * dest = (char *) &message_size + bytes_read;
-        int new_bytes = recv(client_socket, dest, sizeof(int) - bytes_read, 0);
-        if (new_bytes == -1) {
-            warn("Error reading from socket %d (%s)", client_socket, strerror(errno));
-            Util::SafeClose(client_socket);
-            return;
+    int request_id = request_callback(&command[0]);
+    server_mutex.lock();
+    requests_in_callback--;
+    if (request_id == -1 && server_state == Redirecting) {
+        // Lost leadership before the request made it into the log
+        string redirect = RedirectBody();
+        server_mutex.unlock();
+
+        SendResponse(*connection, client_request_id, CLIENT_RESPONSE_REDIRECT,
+            redirect);
+        return;
+    }
+    if (request_id == -1) {
+        server_mutex.unlock();
+
+        SendResponse(*connection, client_request_id, CLIENT_RESPONSE_ERROR,
+            "Server failed to process the request");
+        return;
+    }
+    if (early_responses.count(request_id) != 0) {
+        string response = early_responses[request_id];
+        early_responses.erase(request_id);
+        if (requests_in_callback == 0) {
+            // No other request can claim what's left
+            early_responses.clear();
         }
-        bytes_read += new_bytes;
+        server_mutex.unlock();
+
+        SendResponse(*connection, client_request_id, CLIENT_RESPONSE_OK, response);
+        return;
     }
+    if (server_state == Redirecting) {
+        // Lost leadership before the request could be registered; it would
+        // never be responded to
+        string redirect = RedirectBody();
+        server_mutex.unlock();
 
-    char buf[message_size + 1];
-    bytes_read = 0;
-    while (bytes_read < message_size) {
-        void * dest = buf + bytes_read;
-        int new_bytes = recv(client_socket, dest, message_size - bytes_read, 0);
-        if (new_bytes == 0 || new_bytes == -1) {
-            warn("Error reading from socket %d (%s)", client_socket, strerror(errno));
-            Util::SafeClose(client_socket);
+        SendResponse(*connection, client_request_id, CLIENT_RESPONSE_REDIRECT,
+            redirect);
+        return;
+    }
+    pending_requests[request_id] = {connection, client_request_id};
+    if (requests_in_callback == 0) {
+        // No other request can claim what's left
+        early_responses.clear();
+    }
+    server_mutex.unlock();
+}
+
+void ClientServer::SendResponse(ClientConnection& connection,
+        int client_request_id, int status, const string& body) {
+    ClientMessageHeader header;
+    header.request_id = client_request_id;
+    header.status = status;
+    header.len = body.size();
+    string message((const char *) &header, sizeof(header));
+    message += body;
+
+    lock_guard<mutex> lock(connection.send_mutex);
+    if (connection.broken) {
+        debug("Dropping response to request %d from broken socket %d",
+            client_request_id, connection.socket);
+        return;
+    }
+    size_t bytes_sent = 0;
+    while (bytes_sent < message.size()) {
+        int new_bytes = send(connection.socket, &message[bytes_sent],
+            message.size() - bytes_sent, MSG_NOSIGNAL);
+        if (new_bytes == -1 && errno == EINTR) {
+            continue;
+        }
+        if (new_bytes == -1) {
+            warn("Could not write to socket %d (%s)", connection.socket, strerror(errno));
+            // A partial response can't be followed by another one; the event
+            // loop finds out from its next read and lets go of the connection
+            shutdown(connection.socket, SHUT_RDWR);
+            connection.broken = true;
             return;
         }
-        bytes_read += new_bytes;
+        bytes_sent += new_bytes;
     }
-    // Finished reading complete message from client
-    buf[message_size] = '\0';
-    int request_id = request_callback(buf);
-    server_mutex.lock();
-    pending_client_sockets[request_id] = client_socket;
-    server_mutex.unlock();
+}
+
+string ClientServer::RedirectBody() {
+    unsigned short port = redirect_server_info->port;
+    return string((const char *) &port, sizeof(port)) +
+        redirect_server_info->ip_addr;
 }
@@ -1,23 +1,28 @@
 /**
- * A server that accepts connections from clients, processes a single string
- * command from the client, calls a user-defined callback function, and holds
- * onto the connection until the user is ready to respond to the client. When
- * the user is ready to respond, the response is passed to the appropriate
- * client and the connection is finally closed.
+ * A server that accepts long-lived connections from clients, reads framed
+ * string commands from them, calls a user-defined callback function for each
+ * command, and holds onto the request until the user is ready to respond to
+ * it. When the user is ready to respond, the response is passed back over the
+ * connection the request came from.
+ *
+ * Every message on a connection starts with a ClientMessageHeader. A client
+ * may send many requests without waiting for their responses, and responses
+ * can come back in a different order than their requests were sent, so each
+ * request carries an id chosen by the client that its response echoes back.
  *
  * The server starts out in a "waiting mode" where it merely holds onto incoming
- * connections until the user is ready to process them. (In Raft, this is useful
+ * requests until the user is ready to process them. (In Raft, this is useful
  * at server startup where the server is a follower and does not know which
  * server is the leader.)
  *
- * When the user is ready to accept connections, the server can be put into
- * "serving mode" which unblocks the connections that were waiting and
- * immediately processes new connections by calling the user-defined callback
+ * When the user is ready to accept requests, the server can be put into
+ * "serving mode" which unblocks the requests that were waiting and
+ * immediately processes new requests by calling the user-defined callback
  * function.
  *
  * The server can also be put into a "redirect mode" where it responds to
- * clients with a special "sentinel" response that points them to another server
- * where they should retry their request. The connection is then closed.
+ * requests with a special "redirect" response that points clients to another
+ * server where they should retry them.
  *
  * This class is thread-safe (its methods can safely be called from different
  * threads).
@@ -27,13 +32,16 @@
 
 #include <arpa/inet.h>
 #include <condition_variable>
+#include <cstdint>
 #include <cstring>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <netinet/in.h>
 #include <sys/socket.h>
 #include <unistd.h>
 
+#include "event-loop.h"
 #include "log.h"
 #include "raft-config.h"
 #include "thread-pool.h"
@@ -43,6 +51,32 @@ using namespace std;
 
 const static int THREAD_POOL_SIZE = 8;
 
+// Largest command a client may send in one request
+const static int MAX_CLIENT_COMMAND_BYTES = 1'000'000; // bytes
+
+// Longest a response may wait for room in a client's socket before the
+// connection is given up on
+const static int CLIENT_SEND_TIMEOUT = 1'000; // milliseconds
+
+// Kinds of response, in ClientMessageHeader.status
+const static int32_t CLIENT_RESPONSE_OK = 0;
+// Retry the request at another server, whose port (an unsigned short) and
+// then IP address make up the body
+const static int32_t CLIENT_RESPONSE_REDIRECT = 1;
+// The request could not be processed (its body says why); it may be retried
+const static int32_t CLIENT_RESPONSE_ERROR = 2;
+
+/**
+ * Starts every message on a client connection, and is followed by a body of
+ * `len` bytes: the command of a request, or the output of a response. Like
+ * the rest of the client protocol, integers are in host byte order.
+ */
+struct __attribute__((packed)) ClientMessageHeader {
+    int32_t request_id;
+    int32_t status; // always CLIENT_RESPONSE_OK in requests
+    int32_t len;
+};
+
 typedef function<int(char * command)> RequestCallback;
 
 /**
@@ -73,18 +107,22 @@ class ClientServer {
          * (as a string argument). The callback is expected to handle the
          * client's request asyncronously and return a "request id" integer that
          * will be used to return a response to the client at some point in the
-         * future by calling `RespondToClient`. The connection to the client
-         * will be held open until the user sends a response to the client
-         * using the "request id" they provided when the request was received.
+         * future by calling `RespondToClient`. The request will be held until
+         * the user sends a response to the client using the "request id" they
+         * provided when the request was received. (This id is separate from
+         * the one the client chose for the request.)
          *
-         * Internally, many threads are created to manage the connections, and
-         * the callback function can be called from any of these new threads.
+         * Internally, one thread reads requests from every connection, and
+         * many threads are created to process the requests. The callback
+         * function can be called from any of the latter, and for several
+         * requests from the same connection at once.
          *
          * Server starts out in "waiting mode" until `StartServing` or
          * `StartRedirecting` is called.
          *
          * @param request_callback Function to call when a request is received
-         * from a client. Expects to get a "request id" as return value.
+         * from a client. Expects to get a "request id" as return value, or -1
+         * if the request failed, which is reported to the client right away.
          */
         ClientServer(RequestCallback request_callback);
 
@@ -120,7 +158,8 @@ class ClientServer {
 
         /**
          * Start redirecting clients to the given server. Puts server into
-         * "redirecting mode".
+         * "redirecting mode". Requests still waiting for a response are
+         * redirected as well, as they may never get one from this server.
          *
          * @param new_redirect_server_info Server to redirect clients to.
          */
@@ -128,11 +167,80 @@ class ClientServer {
 
     private:
         /**
-         * Process a client connection. This function runs in its own thread.
+         * A connection from a client. It stays open until the client hangs up
+         * and every request the client sent on it has been responded to (or
+         * given up on), so its socket is closed when the last reference to
+         * it is dropped.
+         */
+        struct ClientConnection {
+            ClientConnection(int socket): socket(socket) {}
+            ~ClientConnection();
+
+            int socket;
+
+            /**
+             * Bytes read from the socket that don't make up a whole request
+             * yet. Only used on the event loop's thread.
+             */
+            string received;
+
+            /**
+             * Held while writing a response, so that responses written from
+             * different threads don't interleave. Guards `broken`, which is
+             * set once a write fails, after which responses are dropped.
+             */
+            mutex send_mutex;
+            bool broken = false;
+        };
+
+        /**
+         * A request that was passed to the callback, and is waiting for the
+         * user to respond to it.
+         */
+        struct PendingRequest {
+            shared_ptr<ClientConnection> connection;
+            int client_request_id;
+        };
+
+        /**
+         * Reads what a client sent on its connection, and schedules every
+         * request completed by it to be processed by HandleRequest. Runs on
+         * the event loop's thread.
          *
-         * @param client_socket The incoming client socket to process
+         * @param connection The connection that is ready to be read
          */
-        void HandleClientConnection(int client_socket);
+        void HandleConnectionEvent(shared_ptr<ClientConnection> connection);
+
+        /**
+         * Process a request read from a client. This function runs on one of
+         * the threads of the thread pool.
+         *
+         * @param connection The connection the request was read from
+         * @param client_request_id The id the client chose for the request
+         * @param command The client's request
+         */
+        void HandleRequest(shared_ptr<ClientConnection> connection,
+            int client_request_id, string command);
+
+        /**
+         * Write a response to a client's connection. Blocks until the whole
+         * response is written, or for at most CLIENT_SEND_TIMEOUT otherwise,
+         * in which case the connection is shut down. Does nothing if an
+         * earlier response to the connection failed.
+         *
+         * @param connection The connection to write to
+         * @param client_request_id The id the client chose for the request
+         * @param status The kind of response (one of CLIENT_RESPONSE_*)
+         * @param body The output of the request, or where it was redirected
+         */
+        void SendResponse(ClientConnection& connection, int client_request_id,
+            int status, const string& body);
+
+        /**
+         * Body of a redirect response, pointing the client to
+         * redirect_server_info. Assumes that server_mutex is held.
+         */
+        string RedirectBody();
 
         /**
          * The state of the client server. Starts out in "waiting mode" and
@@ -151,6 +259,13 @@ class ClientServer {
          */
         ThreadPool thread_pool;
 
+        /**
+         * Waits for requests on all the client connections. Declared after
+         * thread_pool so that it stops before the pool does, as it schedules
+         * requests onto the pool.
+         */
+        EventLoop event_loop;
+
         /**
          * Contact information for the server that we will redirect to. Should
          * be set to NULL when the server is not in "redirecting mode".
@@ -158,10 +273,20 @@ class ClientServer {
         ServerInfo * redirect_server_info = NULL;
 
         /**
-         * Client sockets that are waiting for a response. Maps the "request id"
-         * returned by the callback function to the socket file descriptor.
+         * Requests that are waiting for a response. Maps the "request id"
+         * returned by the callback function to the request.
+         */
+        map<int, PendingRequest> pending_requests;
+
+        /**
+         * Responses for requests that completed before they were added to
+         * pending_requests. Maps "request id" to response. Responses are only
+         * held while requests_in_callback, the number of requests the
+         * callback is processing, is above zero: otherwise no request could
+         * come to claim them.
          */
-        map<int, int> pending_client_sockets;
+        map<int, string> early_responses;
+        int requests_in_callback = 0;
 
         /**
          * Synchronization primatives. The condition variable is used to make
@@ -78,7 +78,8 @@ int main(int argc, char* argv[]) {
 bool send_command(const char * command) {
     int retries = MAX_CLIENT_RETRIES;
     bool redirect_to_leader = false;
-    send_loop: while (retries > 0) {
+    int request_id = next_request_id++;
+    while (retries > 0) {
         info("Attempting to send command (%d retries left)", retries);
         if (retries < MAX_CLIENT_RETRIES && !redirect_to_leader) {
             this_thread::sleep_for(CLIENT_RETRY_DELAY);
@@ -87,99 +88,144 @@ bool send_command(const char * command) {
         redirect_to_leader = false;
         retries--;
 
-        // Populate leader information struct
-        struct sockaddr_in leader_info;
-        memset(&leader_info, 0, sizeof(leader_info));
-        leader_info.sin_family = AF_INET;
-        leader_info.sin_addr.s_addr = inet_addr(leader_server_info.ip_addr.c_str());
-        leader_info.sin_port = htons(leader_server_info.port);
-
-        // Create socket
-        int leader_socket = socket(AF_INET, SOCK_STREAM, 0);
-        if (leader_socket == -1) {
-            error("Error creating server socket (%s)", strerror(errno));
-            Util::SafeClose(leader_socket);
+        if (leader_socket == -1 && !connect_to_leader()) {
             continue;
         }
 
-        // Connect socket
-        if (connect(leader_socket, (struct sockaddr *) &leader_info,
-                sizeof(struct sockaddr_in)) == -1) {
-            error("Error connecting to server (%s)", strerror(errno));
-            Util::SafeClose(leader_socket);
+        ClientMessageHeader header;
+        header.request_id = request_id;
+        header.status = CLIENT_RESPONSE_OK;
+        header.len = strlen(command);
+        string request((const char *) &header, sizeof(header));
+        request += command;
+        if (!send_fully(leader_socket, request.data(), request.size())) {
+            warn("Could not write to socket %d (%s)", leader_socket, strerror(errno));
+            disconnect_from_leader();
             continue;
         }
 
-        // Get information about the local socket
-        struct sockaddr_in local_info;
-        socklen_t size = sizeof(struct sockaddr_in);
-        if (getsockname(leader_socket, (struct sockaddr *) &local_info, &size) == -1) {
-            error("Error getting local socket info (%s)", strerror(errno));
-            Util::SafeClose(leader_socket);
-            continue;
-        }
-        info("Connect to server %s:%d (from %s:%d)",
-            leader_server_info.ip_addr.c_str(), leader_server_info.port,
-            inet_ntoa(local_info.sin_addr), ntohs(local_info.sin_port));
-
-        int len = strlen(command);
-        if (write(leader_socket, &len, sizeof(int)) == -1) {
-            error("Could not write to socket %d (%s)", leader_socket, strerror(errno));
-            return false;
-        }
-        dprintf(leader_socket, "%s", command);
-
-        // Read response from leader server
-        int message_size;
-        int bytes_read = 0;
-        while (bytes_read < sizeof(int)) {
-            void * dest = (char *) &message_size + bytes_read;
-            int new_bytes = recv(leader_socket, dest, sizeof(int) - bytes_read, 0);
-            if (new_bytes == 0 || new_bytes == -1) {
-                warn("Error reading from socket %d (%s)", leader_socket, strerror(errno));
-                Util::SafeClose(leader_socket);
-                goto send_loop;
+        // Read responses from the server until the one to this request, as
+        // responses to requests that were given up on may come first
+        string body;
+        bool received = false;
+        while (!received) {
+            if (!recv_fully(leader_socket, &header, sizeof(header)) || header.len < 0) {
+                break;
             }
-            bytes_read += new_bytes;
+            body.resize(header.len);
+            if (!recv_fully(leader_socket, &body[0], header.len)) {
+                break;
+            }
+            received = header.request_id == request_id;
+        }
+        if (!received) {
+            warn("Error reading from socket %d (%s)", leader_socket, strerror(errno));
+            disconnect_from_leader();
+            continue;
         }
 
-        // int redirect_to_leader = false;
-        if (message_size == -1) {
-            info("%s", "actually got a negative message size as first byte");
+        if (header.status == CLIENT_RESPONSE_REDIRECT &&
+                body.size() >= sizeof(unsigned short)) {
             // Server is redirecting us to the true leader
+            memcpy(&leader_server_info.port, &body[0], sizeof(unsigned short));
+            leader_server_info.ip_addr = body.substr(sizeof(unsigned short));
+            info("Redirecting to leader: %s:%d",
+                leader_server_info.ip_addr.c_str(), leader_server_info.port);
+            disconnect_from_leader();
             redirect_to_leader = true;
-            message_size = sizeof(ServerInfo);
-        } else {
-            info("message size was %d", message_size);
-        }
-
-        char buf[message_size + 1];
-        bytes_read = 0;
-        while (bytes_read < message_size) {
-            void * dest = buf + bytes_read;
-            int new_bytes = recv(leader_socket, dest, message_size - bytes_read, 0);
-            if (new_bytes == 0 || new_bytes == -1) {
-                warn("Error reading from socket %d (%s)", leader_socket, strerror(errno));
-                Util::SafeClose(leader_socket);
-                goto send_loop;
-            }
-            bytes_read += new_bytes;
+            continue;
         }
 
-        if (redirect_to_leader) {
-            leader_server_info = *(ServerInfo *) buf;
-            info("Redirecting to leader: %s:%d",
-                leader_server_info.ip_addr.c_str(), leader_server_info.port);
-            Util::SafeClose(leader_socket);
+        if (header.status == CLIENT_RESPONSE_ERROR) {
+            warn("Server failed the request: %s", body.c_str());
             continue;
         }
 
-        // Finished reading complete message from server
-        Util::SafeClose(leader_socket);
-        buf[message_size] = '\0';
-        printf("%s", buf);
+        // Finished reading complete response from server
+        printf("%s", body.c_str());
 
         return true;
     }
     return false;
 }
+
+bool connect_to_leader() {
+    // Populate leader information struct
+    struct sockaddr_in leader_info;
+    memset(&leader_info, 0, sizeof(leader_info));
+    leader_info.sin_family = AF_INET;
+    leader_info.sin_addr.s_addr = inet_addr(leader_server_info.ip_addr.c_str());
+    leader_info.sin_port = htons(leader_server_info.port);
+
+    // Create socket
+    leader_socket = socket(AF_INET, SOCK_STREAM, 0);
+    if (leader_socket == -1) {
+        error("Error creating server socket (%s)", strerror(errno));
+        return false;
+    }
+
+    // Connect socket
+    if (connect(leader_socket, (struct sockaddr *) &leader_info,
+            sizeof(struct sockaddr_in)) == -1) {
+        error("Error connecting to server (%s)", strerror(errno));
+        disconnect_from_leader();
+        return false;
+    }
+
+    // Get information about the local socket
+    struct sockaddr_in local_info;
+    socklen_t size = sizeof(struct sockaddr_in);
+    if (getsockname(leader_socket, (struct sockaddr *) &local_info, &size) == -1) {
+        error("Error getting local socket info (%s)", strerror(errno));
+        disconnect_from_leader();
+        return false;
+    }
+    info("Connect to server %s:%d (from %s:%d)",
+        leader_server_info.ip_addr.c_str(), leader_server_info.port,
+        inet_ntoa(local_info.sin_addr), ntohs(local_info.sin_port));
+
+    // Requests are written whole, and shouldn't wait for the server to
+    // acknowledge the ones before them
+    int val = 1;
+    if (setsockopt(leader_socket, IPPROTO_TCP, TCP_NODELAY, &val, sizeof(int)) == -1) {
+        warn("Error setting TCP_NODELAY (%s)", strerror(errno));
+    }
+    return true;
+}
+
+void disconnect_from_leader() {
+    Util::SafeClose(leader_socket);
+    leader_socket = -1;
+}
+
+bool send_fully(int socket, const void * buf, int len) {
+    int bytes_sent = 0;
+    while (bytes_sent < len) {
+        int new_bytes = send(socket, (const char *) buf + bytes_sent,
+            len - bytes_sent, MSG_NOSIGNAL);
+        if (new_bytes == -1 && errno == EINTR) {
+            continue;
+        }
+        if (new_bytes == -1) {
+            return false;
+        }
+        bytes_sent += new_bytes;
+    }
+    return true;
+}
+
+bool recv_fully(int socket, void * buf, int len) {
+    int bytes_read = 0;
+    while (bytes_read < len) {
+        int new_bytes = recv(socket, (char *) buf + bytes_read,
+            len - bytes_read, 0);
+        if (new_bytes == -1 && errno == EINTR) {
+            continue;
+        }
+        if (new_bytes == 0 || new_bytes == -1) {
+            return false;
+        }
+        bytes_read += new_bytes;
+    }
+    return true;
+}
@@ -4,17 +4,23 @@
 #include <chrono>
 #include <cstdlib>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <sys/socket.h>
 #include <thread>
 #include <unistd.h>
 
 #include "arguments.h"
+#include "client-server.h"
 #include "log.h"
 #include "raft-config.h"
 
 using namespace std;
 using namespace chrono;
 
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
 /**
  * The number of times to retry a client request before treating it as failure.
  */
@@ -35,6 +41,17 @@ static vector<ServerInfo> server_infos;
  */
 static ServerInfo leader_server_info;
 
+/**
+ * Connection to leader_server_info, kept open from one command to the next.
+ * -1 when there is none.
+ */
+static int leader_socket = -1;
+
+/**
+ * Id to give the next command sent to the cluster, which its response echoes.
+ */
+static int next_request_id = 0;
+
 /**
  * Help text for the ./client command line program.
  */
@@ -64,7 +81,8 @@ Usage:
 )";
 
 /**
- * Send the given `command` to the leader of the Raft cluster. If the request
+ * Send the given `command` to the leader of the Raft cluster, over the
+ * connection left open by the previous command if there is one. If the request
  * fails for any reason it will be retried for a set number of times. If the
  * contacted server redirects us to another server, the client closes the
  * connection and connects to the new server.
@@ -77,3 +95,29 @@ Usage:
  * @return Whether the command succeeded or not.
  */
 bool send_command(const char * command);
+
+/**
+ * Open leader_socket, a connection to leader_server_info.
+ *
+ * @return Whether the connection was opened.
+ */
+bool connect_to_leader();
+
+/**
+ * Close leader_socket, e.g. after it failed.
+ */
+void disconnect_from_leader();
+
+/**
+ * Write all `len` bytes of `buf` to a socket, however many writes it takes.
+ *
+ * @return Whether the bytes were written, or the connection failed.
+ */
+bool send_fully(int socket, const void * buf, int len);
+
+/**
+ * Read exactly `len` bytes from a socket into `buf`.
+ *
+ * @return Whether the bytes were read, or the connection failed or closed.
+ */
+bool recv_fully(int socket, void * buf, int len);
@@ -0,0 +1,223 @@
+#include "event-loop.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#else
+#include <poll.h>
+#endif
+
+// Most ready sockets handled per wait
+static const int MAX_EVENTS = 64;
+
+EventLoop::EventLoop() {
+    if (pipe(wake_pipe) == -1) {
+        error("Error creating event loop pipe: %s", strerror(errno));
+    }
+    fcntl(wake_pipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(wake_pipe[1], F_SETFL, O_NONBLOCK);
+#ifdef __linux__
+    epoll_fd = epoll_create1(0);
+    if (epoll_fd == -1) {
+        error("Error creating epoll instance: %s", strerror(errno));
+    }
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = wake_pipe[0];
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_pipe[0], &event);
+#endif
+    loop_thread = thread([this] () {
+        RunLoopThread();
+    });
+}
+
+EventLoop::~EventLoop() {
+    {
+        lock_guard<mutex> lock(loop_mutex);
+        stopped = true;
+    }
+    Wake();
+    loop_thread.join();
+#ifdef __linux__
+    close(epoll_fd);
+#endif
+    close(wake_pipe[0]);
+    close(wake_pipe[1]);
+}
+
+#ifdef __linux__
+static uint32_t EpollEvents(int events) {
+    return ((events & EVENT_READ) ? EPOLLIN : 0) |
+        ((events & EVENT_WRITE) ? EPOLLOUT : 0);
+}
+#endif
+
+void EventLoop::Watch(int fd, int events, EventHandler handler) {
+    {
+        lock_guard<mutex> lock(loop_mutex);
+        handlers[fd] = make_shared<EventHandler>(handler);
+        watched_events[fd] = events;
+    }
+#ifdef __linux__
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EpollEvents(events);
+    event.data.fd = fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) == -1 &&
+            (errno != EEXIST || epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &event) == -1)) {
+        warn("Error: failed to watch socket %d, %s (%d)", fd, strerror(errno), errno);
+    }
+#else
+    Wake();
+#endif
+}
+
+void EventLoop::Modify(int fd, int events) {
+    {
+        lock_guard<mutex> lock(loop_mutex);
+        watched_events[fd] = events;
+    }
+#ifdef __linux__
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EpollEvents(events);
+    event.data.fd = fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &event) == -1) {
+        warn("Error: failed to modify socket %d, %s (%d)", fd, strerror(errno), errno);
+    }
+#else
+    Wake();
+#endif
+}
+
+void EventLoop::Unwatch(int fd) {
+    {
+        lock_guard<mutex> lock(loop_mutex);
+        handlers.erase(fd);
+        watched_events.erase(fd);
+    }
+#ifdef __linux__
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+#else
+    Wake();
+#endif
+}
+
+int EventLoop::AddTickHandler(TickHandler handler) {
+    lock_guard<mutex> lock(loop_mutex);
+    int handler_id = next_tick_handler_id++;
+    tick_handlers[handler_id] = handler;
+    return handler_id;
+}
+
+void EventLoop::RemoveTickHandler(int handler_id) {
+    lock_guard<mutex> lock(loop_mutex);
+    tick_handlers.erase(handler_id);
+}
+
+void EventLoop::RunLoopThread() {
+    time_point<steady_clock> next_tick = steady_clock::now() +
+        milliseconds(EVENT_LOOP_TICK);
+    while (true) {
+        {
+            lock_guard<mutex> lock(loop_mutex);
+            if (stopped) break;
+        }
+        int timeout = duration_cast<milliseconds>(
+            next_tick - steady_clock::now()).count();
+        for (pair<int, int> ready : WaitForEvents(max(timeout, 0))) {
+            Dispatch(ready.first, ready.second);
+        }
+
+        if (steady_clock::now() >= next_tick) {
+            next_tick = steady_clock::now() + milliseconds(EVENT_LOOP_TICK);
+            vector<TickHandler> handlers_to_call;
+            {
+                lock_guard<mutex> lock(loop_mutex);
+                for (auto& tick_handler : tick_handlers) {
+                    handlers_to_call.push_back(tick_handler.second);
+                }
+            }
+            for (TickHandler& handler : handlers_to_call) {
+                handler();
+            }
+        }
+    }
+}
+
+vector<pair<int, int>> EventLoop::WaitForEvents(int timeout) {
+    vector<pair<int, int>> ready;
+#ifdef __linux__
+    struct epoll_event events[MAX_EVENTS];
+    int num_events = epoll_wait(epoll_fd, events, MAX_EVENTS, timeout);
+    for (int i = 0; i < num_events; i++) {
+        int fd = events[i].data.fd;
+        if (fd == wake_pipe[0]) {
+            char buf[64];
+            while (read(wake_pipe[0], buf, sizeof(buf)) > 0) {}
+            continue;
+        }
+        int ready_events = 0;
+        if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+            ready_events = EVENT_READ | EVENT_WRITE;
+        }
+        if (events[i].events & EPOLLIN) ready_events |= EVENT_READ;
+        if (events[i].events & EPOLLOUT) ready_events |= EVENT_WRITE;
+        ready.push_back({fd, ready_events});
+    }
+#else
+    vector<struct pollfd> poll_fds;
+    poll_fds.push_back({wake_pipe[0], POLLIN, 0});
+    {
+        lock_guard<mutex> lock(loop_mutex);
+        for (pair<int, int> watched : watched_events) {
+            short events = ((watched.second & EVENT_READ) ? POLLIN : 0) |
+                ((watched.second & EVENT_WRITE) ? POLLOUT : 0);
+            poll_fds.push_back({watched.first, events, 0});
+        }
+    }
+    if (poll(poll_fds.data(), poll_fds.size(), timeout) <= 0) {
+        return ready;
+    }
+    if (poll_fds[0].revents != 0) {
+        char buf[64];
+        while (read(wake_pipe[0], buf, sizeof(buf)) > 0) {}
+    }
+    for (size_t i = 1; i < poll_fds.size(); i++) {
+        int ready_events = 0;
+        if (poll_fds[i].revents & (POLLERR | POLLHUP | POLLNVAL)) {
+            ready_events = EVENT_READ | EVENT_WRITE;
+        }
+        if (poll_fds[i].revents & POLLIN) ready_events |= EVENT_READ;
+        if (poll_fds[i].revents & POLLOUT) ready_events |= EVENT_WRITE;
+        if (ready_events != 0) {
+            ready.push_back({poll_fds[i].fd, ready_events});
+        }
+    }
+#endif
+    return ready;
+}
+
+void EventLoop::Dispatch(int fd, int events) {
+    shared_ptr<EventHandler> handler;
+    {
+        lock_guard<mutex> lock(loop_mutex);
+        if (handlers.count(fd) == 0) {
+            // Unwatched by an earlier handler in this batch
+            return;
+        }
+        handler = handlers[fd];
+    }
+    (*handler)(events);
+}
+
+void EventLoop::Wake() {
+    char byte = 0;
+    if (write(wake_pipe[1], &byte, 1) == -1 && errno != EAGAIN) {
+        warn("Error: failed to wake event loop, %s (%d)", strerror(errno), errno);
+    }
+}
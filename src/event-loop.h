@@ -0,0 +1,144 @@
+/**
+ * Event loop that waits on many sockets at once from a single thread, and
+ * calls a handler whenever one of them is ready to be read or written. This
+ * lets all the connections to peers share one thread, instead of blocking a
+ * thread or two on each of them.
+ *
+ * Uses epoll on Linux, and poll elsewhere.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "log.h"
+
+using namespace std;
+using namespace std::chrono;
+
+// Events a handler can wait for, combined with |
+static const int EVENT_READ = 1;
+static const int EVENT_WRITE = 2;
+
+// Interval at which tick handlers are called
+static const int EVENT_LOOP_TICK = 1'000; // milliseconds
+
+/**
+ * Called on the loop thread with the events (EVENT_READ and/or EVENT_WRITE)
+ * that a socket is ready for. Errors and hang-ups are reported as both, so
+ * the handler finds out about them from its next read or write.
+ */
+typedef function<void(int)> EventHandler;
+
+typedef function<void()> TickHandler;
+
+class EventLoop {
+    public:
+        /**
+         * Create an event loop, and start the thread that runs it.
+         */
+        EventLoop();
+
+        /**
+         * Stop the loop thread and cleanup all resources. Handlers are not
+         * called any more once this returns.
+         */
+        ~EventLoop();
+
+        /**
+         * Start waiting for events on a socket, replacing any handler it
+         * already has. Spurious calls are possible, so the socket should be
+         * non-blocking.
+         *
+         * @param fd The socket to wait on
+         * @param events The events to wait for
+         * @param handler The function to call when the socket is ready
+         */
+        void Watch(int fd, int events, EventHandler handler);
+
+        /**
+         * Change the events a watched socket is waited on for.
+         *
+         * @param fd The socket being waited on
+         * @param events The events to wait for
+         */
+        void Modify(int fd, int events);
+
+        /**
+         * Stop waiting for events on a socket. Must be called before the
+         * socket is closed.
+         *
+         * @param fd The socket being waited on
+         */
+        void Unwatch(int fd);
+
+        /**
+         * Call a function on the loop thread every EVENT_LOOP_TICK
+         * milliseconds, e.g. to retry something that failed.
+         *
+         * @param handler The function to call
+         * @return identifier to pass to RemoveTickHandler
+         */
+        int AddTickHandler(TickHandler handler);
+
+        /**
+         * Stop calling a function added with AddTickHandler.
+         *
+         * @param handler_id Identifier returned by AddTickHandler
+         */
+        void RemoveTickHandler(int handler_id);
+
+    private:
+        /**
+         * Main body of the loop thread.
+         */
+        void RunLoopThread();
+
+        /**
+         * Waits until sockets are ready or the timeout passes.
+         *
+         * @param timeout Maximum amount of time to wait (in milliseconds)
+         * @return pairs of ready sockets and the events they are ready for
+         */
+        vector<pair<int, int>> WaitForEvents(int timeout);
+
+        /**
+         * Calls the handler of a ready socket, if it still has one.
+         */
+        void Dispatch(int fd, int events);
+
+        /**
+         * Interrupts WaitForEvents, e.g. so it notices a change to the
+         * sockets being waited on.
+         */
+        void Wake();
+
+        /**
+         * Handlers of the sockets being waited on, and the events they are
+         * waited on for. Guarded by loop_mutex.
+         */
+        map<int, shared_ptr<EventHandler>> handlers;
+        map<int, int> watched_events;
+
+        map<int, TickHandler> tick_handlers;
+        int next_tick_handler_id = 0;
+
+        /**
+         * Written to by Wake, and always waited on for reading
+         */
+        int wake_pipe[2];
+
+#ifdef __linux__
+        int epoll_fd;
+#endif
+
+        bool stopped = false;
+        mutex loop_mutex;
+        thread loop_thread;
+};
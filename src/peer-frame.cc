@@ -0,0 +1,134 @@
+#include "peer-frame.h"
+
+#include <cstring>
+
+/**
+ * Fixed headers of the frames, as laid out on the wire.
+ */
+struct __attribute__((packed)) RequestFrameHeader {
+    uint8_t kind;
+    uint8_t unused[3];
+    int32_t term;
+    int32_t server_id;
+    int32_t prev_log_index;
+    int32_t prev_log_term;
+    int32_t leader_commit;
+    int32_t entry_count;
+};
+
+struct __attribute__((packed)) ResponseFrame {
+    uint8_t kind;
+    uint8_t success;
+    uint8_t unused[2];
+    int32_t term;
+    int32_t server_id;
+    int32_t appended_log_index;
+    int32_t conflict_term;
+    int32_t conflict_first_index;
+};
+
+bool PeerFrame::IsFrame(const char* message, int message_len) {
+    return message_len > 0 &&
+        ((uint8_t) message[0] == FRAME_APPENDENTRIES_REQUEST ||
+         (uint8_t) message[0] == FRAME_APPENDENTRIES_RESPONSE);
+}
+
+string PeerFrame::EncodeRequestHeader(const AppendEntriesRequest& request,
+        int entry_count) {
+    RequestFrameHeader header;
+    memset(&header, 0, sizeof(header));
+    header.kind = FRAME_APPENDENTRIES_REQUEST;
+    header.term = request.term;
+    header.server_id = request.server_id;
+    header.prev_log_index = request.prev_log_index;
+    header.prev_log_term = request.prev_log_term;
+    header.leader_commit = request.leader_commit;
+    header.entry_count = entry_count;
+    return string((const char *) &header, sizeof(header));
+}
+
+string PeerFrame::EncodeEntries(const vector<struct LogEntry>& entries) {
+    size_t size = entries.size() * sizeof(int32_t);
+    for (const struct LogEntry& entry : entries) {
+        size += entry.len;
+    }
+    string encoded(size, '\0');
+    char* lengths = &encoded[0];
+    char* data = lengths + entries.size() * sizeof(int32_t);
+    for (const struct LogEntry& entry : entries) {
+        int32_t len = entry.len;
+        memcpy(lengths, &len, sizeof(int32_t));
+        lengths += sizeof(int32_t);
+        memcpy(data, entry.data, entry.len);
+        data += entry.len;
+    }
+    return encoded;
+}
+
+string PeerFrame::EncodeResponse(const AppendEntriesResponse& response) {
+    ResponseFrame frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.kind = FRAME_APPENDENTRIES_RESPONSE;
+    frame.success = response.success;
+    frame.term = response.term;
+    frame.server_id = response.server_id;
+    frame.appended_log_index = response.appended_log_index;
+    frame.conflict_term = response.conflict_term;
+    frame.conflict_first_index = response.conflict_first_index;
+    return string((const char *) &frame, sizeof(frame));
+}
+
+bool PeerFrame::DecodeRequest(const char* frame, int frame_len,
+        AppendEntriesRequest& request) {
+    RequestFrameHeader header;
+    if (frame_len < (int) sizeof(header)) {
+        return false;
+    }
+    memcpy(&header, frame, sizeof(header));
+    if (header.kind != FRAME_APPENDENTRIES_REQUEST || header.entry_count < 0 ||
+            header.entry_count > (frame_len - (int) sizeof(header)) /
+                (int) sizeof(int32_t)) {
+        return false;
+    }
+    request.term = header.term;
+    request.server_id = header.server_id;
+    request.prev_log_index = header.prev_log_index;
+    request.prev_log_term = header.prev_log_term;
+    request.leader_commit = header.leader_commit;
+
+    const char* lengths = frame + sizeof(header);
+    const char* data = lengths + header.entry_count * sizeof(int32_t);
+    const char* end = frame + frame_len;
+    request.entries.clear();
+    request.entries.reserve(header.entry_count);
+    for (int i = 0; i < header.entry_count; i++) {
+        int32_t len;
+        memcpy(&len, lengths + i * sizeof(int32_t), sizeof(int32_t));
+        // every entry starts with its term
+        if (len < (int) sizeof(int) || len > end - data) {
+            return false;
+        }
+        request.entries.emplace_back(data, len);
+        data += len;
+    }
+    return data == end;
+}
+
+bool PeerFrame::DecodeResponse(const char* frame, int frame_len,
+        AppendEntriesResponse& response) {
+    ResponseFrame decoded;
+    if (frame_len != sizeof(decoded)) {
+        return false;
+    }
+    memcpy(&decoded, frame, sizeof(decoded));
+    if (decoded.kind != FRAME_APPENDENTRIES_RESPONSE) {
+        return false;
+    }
+    response.term = decoded.term;
+    response.server_id = decoded.server_id;
+    response.success = decoded.success != 0;
+    response.appended_log_index = decoded.appended_log_index;
+    response.conflict_term = decoded.conflict_term;
+    response.conflict_first_index = decoded.conflict_first_index;
+    return true;
+}
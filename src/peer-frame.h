@@ -0,0 +1,105 @@
+/**
+ * Compact binary frames for AppendEntries requests and responses, the only
+ * peer messages sent at a high rate. Their fixed layout is encoded and decoded
+ * with a few copies, where a PeerMessage costs allocations and a pass over
+ * every field. The other (rare) message types are always sent as PeerMessages.
+ *
+ * A request frame is a fixed header, then a table of the lengths of its
+ * entries, then the entries back to back. A response frame is just a fixed
+ * header. All integers are little-endian. Frames are told apart from
+ * PeerMessages by their first byte (a serialized PeerMessage always starts
+ * with the tag of its type field), so a server only sends frames to peers
+ * that have told it they can decode them (see PeerMessage.accepts_frames).
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "persistent_log.h"
+
+using namespace std;
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "Peer frames are only implemented for little-endian machines"
+#endif
+
+// First byte of each kind of frame
+static const uint8_t FRAME_APPENDENTRIES_REQUEST = 0xA0;
+static const uint8_t FRAME_APPENDENTRIES_RESPONSE = 0xA1;
+
+/**
+ * AppendEntries request fields, decoded from either a frame or a PeerMessage.
+ */
+struct AppendEntriesRequest {
+    int term;
+    int server_id;
+    int prev_log_index;
+    int prev_log_term;
+    int leader_commit;
+    // Point into the received message, so only valid while it is
+    vector<string_view> entries;
+};
+
+/**
+ * AppendEntries response fields, decoded from either a frame or a PeerMessage.
+ */
+struct AppendEntriesResponse {
+    int term;
+    int server_id;
+    bool success;
+    int appended_log_index;
+    // Where the follower's log stops matching on failure; see PeerMessage
+    int conflict_term;
+    int conflict_first_index;
+};
+
+class PeerFrame {
+    public:
+        /**
+         * Whether a received peer message is a frame rather than a
+         * PeerMessage.
+         */
+        static bool IsFrame(const char* message, int message_len);
+
+        /**
+         * Encodes the header of an AppendEntries request frame. The entries
+         * follow it separately, encoded by EncodeEntries, so that peers
+         * sent the same entries can share them.
+         *
+         * @param request - the request, whose entries are ignored
+         * @param entry_count - number of entries that follow the header
+         * @return the encoded header
+         */
+        static string EncodeRequestHeader(const AppendEntriesRequest& request,
+            int entry_count);
+
+        /**
+         * Encodes the entries of an AppendEntries request frame: their length
+         * table followed by their data.
+         */
+        static string EncodeEntries(const vector<struct LogEntry>& entries);
+
+        static string EncodeResponse(const AppendEntriesResponse& response);
+
+        /**
+         * Decodes an AppendEntries request frame, without copying its
+         * entries.
+         *
+         * @return false if the frame is malformed, including an entry too
+         *     short to hold its term
+         */
+        static bool DecodeRequest(const char* frame, int frame_len,
+            AppendEntriesRequest& request);
+
+        /**
+         * Decodes an AppendEntries response frame.
+         *
+         * @return false if the frame is malformed
+         */
+        static bool DecodeResponse(const char* frame, int frame_len,
+            AppendEntriesResponse& response);
+};
@@ -5,142 +5,154 @@
 
 #include <algorithm>
 
-#include <google/protobuf/stubs/common.h>
-#include <google/protobuf/stubs/port.h>
 #include <google/protobuf/io/coded_stream.h>
-#include <google/protobuf/wire_format_lite_inl.h>
+#include <google/protobuf/extension_set.h>
+#include <google/protobuf/wire_format_lite.h>
 #include <google/protobuf/descriptor.h>
 #include <google/protobuf/generated_message_reflection.h>
 #include <google/protobuf/reflection_ops.h>
 #include <google/protobuf/wire_format.h>
-// This is a temporary google only hack
-#ifdef GOOGLE_PROTOBUF_ENFORCE_UNIQUENESS
-#include "third_party/protobuf/version.h"
-#endif
 // @@protoc_insertion_point(includes)
+#include <google/protobuf/port_def.inc>
 
-namespace proto {
-class PeerMessageDefaultTypeInternal {
- public:
-  ::google::protobuf::internal::ExplicitlyConstructed<PeerMessage>
-      _instance;
-} _PeerMessage_default_instance_;
-}  // namespace proto
-namespace protobuf_peer_2dmessage_2eproto {
-static void InitDefaultsPeerMessage() {
-  GOOGLE_PROTOBUF_VERIFY_VERSION;
+PROTOBUF_PRAGMA_INIT_SEG
 
-  {
-    void* ptr = &::proto::_PeerMessage_default_instance_;
-    new (ptr) ::proto::PeerMessage();
-    ::google::protobuf::internal::OnShutdownDestroyMessage(ptr);
-  }
-  ::proto::PeerMessage::InitAsDefaultInstance();
-}
-
-::google::protobuf::internal::SCCInfo<0> scc_info_PeerMessage =
-    {{ATOMIC_VAR_INIT(::google::protobuf::internal::SCCInfoBase::kUninitialized), 0, InitDefaultsPeerMessage}, {}};
+namespace _pb = ::PROTOBUF_NAMESPACE_ID;
+namespace _pbi = _pb::internal;
 
-void InitDefaults() {
-  ::google::protobuf::internal::InitSCC(&scc_info_PeerMessage.base);
-}
-
-::google::protobuf::Metadata file_level_metadata[1];
-const ::google::protobuf::EnumDescriptor* file_level_enum_descriptors[1];
+namespace proto {
+PROTOBUF_CONSTEXPR PeerMessage::PeerMessage(
+    ::_pbi::ConstantInitialized): _impl_{
+    /*decltype(_impl_._has_bits_)*/{}
+  , /*decltype(_impl_._cached_size_)*/{}
+  , /*decltype(_impl_.entries_)*/{}
+  , /*decltype(_impl_.data_)*/{&::_pbi::fixed_address_empty_string, ::_pbi::ConstantInitialized{}}
+  , /*decltype(_impl_.type_)*/0
+  , /*decltype(_impl_.term_)*/0
+  , /*decltype(_impl_.server_id_)*/0
+  , /*decltype(_impl_.prev_log_index_)*/0
+  , /*decltype(_impl_.prev_log_term_)*/0
+  , /*decltype(_impl_.leader_commit_)*/0
+  , /*decltype(_impl_.appended_log_index_)*/0
+  , /*decltype(_impl_.last_log_index_)*/0
+  , /*decltype(_impl_.last_log_term_)*/0
+  , /*decltype(_impl_.last_included_index_)*/0
+  , /*decltype(_impl_.accepts_frames_)*/false
+  , /*decltype(_impl_.success_)*/false
+  , /*decltype(_impl_.vote_granted_)*/false
+  , /*decltype(_impl_.done_)*/false
+  , /*decltype(_impl_.last_included_term_)*/0
+  , /*decltype(_impl_.offset_)*/int64_t{0}
+  , /*decltype(_impl_.conflict_first_index_)*/0
+  , /*decltype(_impl_.conflict_term_)*/-1} {}
+struct PeerMessageDefaultTypeInternal {
+  PROTOBUF_CONSTEXPR PeerMessageDefaultTypeInternal()
+      : _instance(::_pbi::ConstantInitialized{}) {}
+  ~PeerMessageDefaultTypeInternal() {}
+  union {
+    PeerMessage _instance;
+  };
+};
+PROTOBUF_ATTRIBUTE_NO_DESTROY PROTOBUF_CONSTINIT PROTOBUF_ATTRIBUTE_INIT_PRIORITY1 PeerMessageDefaultTypeInternal _PeerMessage_default_instance_;
+}  // namespace proto
+static ::_pb::Metadata file_level_metadata_peer_2dmessage_2eproto[1];
+static const ::_pb::EnumDescriptor* file_level_enum_descriptors_peer_2dmessage_2eproto[1];
+static constexpr ::_pb::ServiceDescriptor const** file_level_service_descriptors_peer_2dmessage_2eproto = nullptr;
 
-const ::google::protobuf::uint32 TableStruct::offsets[] GOOGLE_PROTOBUF_ATTRIBUTE_SECTION_VARIABLE(protodesc_cold) = {
-  GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(::proto::PeerMessage, _has_bits_),
-  GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(::proto::PeerMessage, _internal_metadata_),
+const uint32_t TableStruct_peer_2dmessage_2eproto::offsets[] PROTOBUF_SECTION_VARIABLE(protodesc_cold) = {
+  PROTOBUF_FIELD_OFFSET(::proto::PeerMessage, _impl_._has_bits_),
+  PROTOBUF_FIELD_OFFSET(::proto::PeerMessage, _internal_metadata_),
   ~0u,  // no _extensions_
   ~0u,  // no _oneof_case_
   ~0u,  // no _weak_field_map_
-  GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(::proto::PeerMessage, type_),
-  GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(::proto::PeerMessage, term_),
-  GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(::proto::PeerMessage, server_id_),
-  GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(::proto::PeerMessage, prev_log_index_),
-  GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(::proto::PeerMessage, prev_log_term_),
-  GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(::proto::PeerMessage, entries_),
-  GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(::proto::PeerMessage, leader_commit_),
-  GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(::proto::PeerMessage, success_),
-  GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(::proto::PeerMessage, appended_log_index_),
-  GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(::proto::PeerMessage, last_log_index_),
-  GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(::proto::PeerMessage, last_log_term_),
-  GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(::proto::PeerMessage, vote_granted_),
-  0,
+  ~0u,  // no _inlined_string_donated_
+  PROTOBUF_FIELD_OFFSET(::proto::PeerMessage, _impl_.type_),
+  PROTOBUF_FIELD_OFFSET(::proto::PeerMessage, _impl_.term_),
+  PROTOBUF_FIELD_OFFSET(::proto::PeerMessage, _impl_.server_id_),
+  PROTOBUF_FIELD_OFFSET(::proto::PeerMessage, _impl_.accepts_frames_),
+  PROTOBUF_FIELD_OFFSET(::proto::PeerMessage, _impl_.prev_log_index_),
+  PROTOBUF_FIELD_OFFSET(::proto::PeerMessage, _impl_.prev_log_term_),
+  PROTOBUF_FIELD_OFFSET(::proto::PeerMessage, _impl_.entries_),
+  PROTOBUF_FIELD_OFFSET(::proto::PeerMessage, _impl_.leader_commit_),
+  PROTOBUF_FIELD_OFFSET(::proto::PeerMessage, _impl_.success_),
+  PROTOBUF_FIELD_OFFSET(::proto::PeerMessage, _impl_.appended_log_index_),
+  PROTOBUF_FIELD_OFFSET(::proto::PeerMessage, _impl_.conflict_term_),
+  PROTOBUF_FIELD_OFFSET(::proto::PeerMessage, _impl_.conflict_first_index_),
+  PROTOBUF_FIELD_OFFSET(::proto::PeerMessage, _impl_.last_log_index_),
+  PROTOBUF_FIELD_OFFSET(::proto::PeerMessage, _impl_.last_log_term_),
+  PROTOBUF_FIELD_OFFSET(::proto::PeerMessage, _impl_.vote_granted_),
+  PROTOBUF_FIELD_OFFSET(::proto::PeerMessage, _impl_.last_included_index_),
+  PROTOBUF_FIELD_OFFSET(::proto::PeerMessage, _impl_.last_included_term_),
+  PROTOBUF_FIELD_OFFSET(::proto::PeerMessage, _impl_.offset_),
+  PROTOBUF_FIELD_OFFSET(::proto::PeerMessage, _impl_.data_),
+  PROTOBUF_FIELD_OFFSET(::proto::PeerMessage, _impl_.done_),
   1,
   2,
   3,
+  11,
   4,
-  ~0u,
   5,
-  8,
+  ~0u,
   6,
+  12,
   7,
-  10,
+  18,
+  17,
+  8,
   9,
+  13,
+  10,
+  15,
+  16,
+  0,
+  14,
 };
-static const ::google::protobuf::internal::MigrationSchema schemas[] GOOGLE_PROTOBUF_ATTRIBUTE_SECTION_VARIABLE(protodesc_cold) = {
-  { 0, 17, sizeof(::proto::PeerMessage)},
+static const ::_pbi::MigrationSchema schemas[] PROTOBUF_SECTION_VARIABLE(protodesc_cold) = {
+  { 0, 26, -1, sizeof(::proto::PeerMessage)},
 };
 
-static ::google::protobuf::Message const * const file_default_instances[] = {
-  reinterpret_cast<const ::google::protobuf::Message*>(&::proto::_PeerMessage_default_instance_),
+static const ::_pb::Message* const file_default_instances[] = {
+  &::proto::_PeerMessage_default_instance_._instance,
 };
 
-void protobuf_AssignDescriptors() {
-  AddDescriptors();
-  AssignDescriptors(
-      "peer-message.proto", schemas, file_default_instances, TableStruct::offsets,
-      file_level_metadata, file_level_enum_descriptors, NULL);
-}
-
-void protobuf_AssignDescriptorsOnce() {
-  static ::google::protobuf::internal::once_flag once;
-  ::google::protobuf::internal::call_once(once, protobuf_AssignDescriptors);
-}
-
-void protobuf_RegisterTypes(const ::std::string&) GOOGLE_PROTOBUF_ATTRIBUTE_COLD;
-void protobuf_RegisterTypes(const ::std::string&) {
-  protobuf_AssignDescriptorsOnce();
-  ::google::protobuf::internal::RegisterAllTypes(file_level_metadata, 1);
-}
-
-void AddDescriptorsImpl() {
-  InitDefaults();
-  static const char descriptor[] GOOGLE_PROTOBUF_ATTRIBUTE_SECTION_VARIABLE(protodesc_cold) = {
-      "\n\022peer-message.proto\022\005proto\"\220\003\n\013PeerMess"
-      "age\022%\n\004type\030\001 \002(\0162\027.proto.PeerMessage.Ty"
-      "pe\022\014\n\004term\030\002 \002(\005\022\021\n\tserver_id\030\003 \002(\005\022\026\n\016p"
-      "rev_log_index\030\004 \001(\005\022\025\n\rprev_log_term\030\005 \001"
-      "(\005\022\017\n\007entries\030\006 \003(\t\022\025\n\rleader_commit\030\007 \001"
-      "(\005\022\017\n\007success\030\010 \001(\010\022\032\n\022appended_log_inde"
-      "x\030\t \001(\005\022\026\n\016last_log_index\030\n \001(\005\022\025\n\rlast_"
-      "log_term\030\013 \001(\005\022\024\n\014vote_granted\030\014 \001(\010\"p\n\004"
-      "Type\022\031\n\025APPENDENTRIES_REQUEST\020\000\022\032\n\026APPEN"
-      "DENTRIES_RESPONSE\020\001\022\027\n\023REQUESTVOTE_REQUE"
-      "ST\020\002\022\030\n\024REQUESTVOTE_RESPONSE\020\003"
-  };
-  ::google::protobuf::DescriptorPool::InternalAddGeneratedFile(
-      descriptor, 430);
-  ::google::protobuf::MessageFactory::InternalRegisterGeneratedFile(
-    "peer-message.proto", &protobuf_RegisterTypes);
+const char descriptor_table_protodef_peer_2dmessage_2eproto[] PROTOBUF_SECTION_VARIABLE(protodesc_cold) =
+  "\n\022peer-message.proto\022\005proto\"\202\005\n\013PeerMess"
+  "age\022%\n\004type\030\001 \002(\0162\027.proto.PeerMessage.Ty"
+  "pe\022\014\n\004term\030\002 \002(\005\022\021\n\tserver_id\030\003 \002(\005\022\026\n\016a"
+  "ccepts_frames\030\022 \001(\010\022\026\n\016prev_log_index\030\004 "
+  "\001(\005\022\025\n\rprev_log_term\030\005 \001(\005\022\017\n\007entries\030\006 "
+  "\003(\t\022\025\n\rleader_commit\030\007 \001(\005\022\017\n\007success\030\010 "
+  "\001(\010\022\032\n\022appended_log_index\030\t \001(\005\022\031\n\rconfl"
+  "ict_term\030\023 \001(\005:\002-1\022\034\n\024conflict_first_ind"
+  "ex\030\024 \001(\005\022\026\n\016last_log_index\030\n \001(\005\022\025\n\rlast"
+  "_log_term\030\013 \001(\005\022\024\n\014vote_granted\030\014 \001(\010\022\033\n"
+  "\023last_included_index\030\r \001(\005\022\032\n\022last_inclu"
+  "ded_term\030\016 \001(\005\022\016\n\006offset\030\017 \001(\003\022\014\n\004data\030\020"
+  " \001(\014\022\014\n\004done\030\021 \001(\010\"\253\001\n\004Type\022\031\n\025APPENDENT"
+  "RIES_REQUEST\020\000\022\032\n\026APPENDENTRIES_RESPONSE"
+  "\020\001\022\027\n\023REQUESTVOTE_REQUEST\020\002\022\030\n\024REQUESTVO"
+  "TE_RESPONSE\020\003\022\033\n\027INSTALLSNAPSHOT_REQUEST"
+  "\020\004\022\034\n\030INSTALLSNAPSHOT_RESPONSE\020\005"
+  ;
+static ::_pbi::once_flag descriptor_table_peer_2dmessage_2eproto_once;
+const ::_pbi::DescriptorTable descriptor_table_peer_2dmessage_2eproto = {
+    false, false, 672, descriptor_table_protodef_peer_2dmessage_2eproto,
+    "peer-message.proto",
+    &descriptor_table_peer_2dmessage_2eproto_once, nullptr, 0, 1,
+    schemas, file_default_instances, TableStruct_peer_2dmessage_2eproto::offsets,
+    file_level_metadata_peer_2dmessage_2eproto, file_level_enum_descriptors_peer_2dmessage_2eproto,
+    file_level_service_descriptors_peer_2dmessage_2eproto,
+};
+PROTOBUF_ATTRIBUTE_WEAK const ::_pbi::DescriptorTable* descriptor_table_peer_2dmessage_2eproto_getter() {
+  return &descriptor_table_peer_2dmessage_2eproto;
 }
 
-void AddDescriptors() {
-  static ::google::protobuf::internal::once_flag once;
-  ::google::protobuf::internal::call_once(once, AddDescriptorsImpl);
-}
-// Force AddDescriptors() to be called at dynamic initialization time.
-struct StaticDescriptorInitializer {
-  StaticDescriptorInitializer() {
-    AddDescriptors();
-  }
-} static_descriptor_initializer;
-}  // namespace protobuf_peer_2dmessage_2eproto
+// Force running AddDescriptors() at dynamic initialization time.
+PROTOBUF_ATTRIBUTE_INIT_PRIORITY2 static ::_pbi::AddDescriptorsRunner dynamic_init_dummy_peer_2dmessage_2eproto(&descriptor_table_peer_2dmessage_2eproto);
 namespace proto {
-const ::google::protobuf::EnumDescriptor* PeerMessage_Type_descriptor() {
-  protobuf_peer_2dmessage_2eproto::protobuf_AssignDescriptorsOnce();
-  return protobuf_peer_2dmessage_2eproto::file_level_enum_descriptors[0];
+const ::PROTOBUF_NAMESPACE_ID::EnumDescriptor* PeerMessage_Type_descriptor() {
+  ::PROTOBUF_NAMESPACE_ID::internal::AssignDescriptors(&descriptor_table_peer_2dmessage_2eproto);
+  return file_level_enum_descriptors_peer_2dmessage_2eproto[0];
 }
 bool PeerMessage_Type_IsValid(int value) {
   switch (value) {
@@ -148,474 +160,583 @@ bool PeerMessage_Type_IsValid(int value) {
     case 1:
     case 2:
     case 3:
+    case 4:
+    case 5:
       return true;
     default:
       return false;
   }
 }
 
-#if !defined(_MSC_VER) || _MSC_VER >= 1900
-const PeerMessage_Type PeerMessage::APPENDENTRIES_REQUEST;
-const PeerMessage_Type PeerMessage::APPENDENTRIES_RESPONSE;
-const PeerMessage_Type PeerMessage::REQUESTVOTE_REQUEST;
-const PeerMessage_Type PeerMessage::REQUESTVOTE_RESPONSE;
-const PeerMessage_Type PeerMessage::Type_MIN;
-const PeerMessage_Type PeerMessage::Type_MAX;
-const int PeerMessage::Type_ARRAYSIZE;
-#endif  // !defined(_MSC_VER) || _MSC_VER >= 1900
+#if (__cplusplus < 201703) && (!defined(_MSC_VER) || (_MSC_VER >= 1900 && _MSC_VER < 1912))
+constexpr PeerMessage_Type PeerMessage::APPENDENTRIES_REQUEST;
+constexpr PeerMessage_Type PeerMessage::APPENDENTRIES_RESPONSE;
+constexpr PeerMessage_Type PeerMessage::REQUESTVOTE_REQUEST;
+constexpr PeerMessage_Type PeerMessage::REQUESTVOTE_RESPONSE;
+constexpr PeerMessage_Type PeerMessage::INSTALLSNAPSHOT_REQUEST;
+constexpr PeerMessage_Type PeerMessage::INSTALLSNAPSHOT_RESPONSE;
+constexpr PeerMessage_Type PeerMessage::Type_MIN;
+constexpr PeerMessage_Type PeerMessage::Type_MAX;
+constexpr int PeerMessage::Type_ARRAYSIZE;
+#endif  // (__cplusplus < 201703) && (!defined(_MSC_VER) || (_MSC_VER >= 1900 && _MSC_VER < 1912))
 
 // ===================================================================
 
-void PeerMessage::InitAsDefaultInstance() {
-}
-#if !defined(_MSC_VER) || _MSC_VER >= 1900
-const int PeerMessage::kTypeFieldNumber;
-const int PeerMessage::kTermFieldNumber;
-const int PeerMessage::kServerIdFieldNumber;
-const int PeerMessage::kPrevLogIndexFieldNumber;
-const int PeerMessage::kPrevLogTermFieldNumber;
-const int PeerMessage::kEntriesFieldNumber;
-const int PeerMessage::kLeaderCommitFieldNumber;
-const int PeerMessage::kSuccessFieldNumber;
-const int PeerMessage::kAppendedLogIndexFieldNumber;
-const int PeerMessage::kLastLogIndexFieldNumber;
-const int PeerMessage::kLastLogTermFieldNumber;
-const int PeerMessage::kVoteGrantedFieldNumber;
-#endif  // !defined(_MSC_VER) || _MSC_VER >= 1900
-
-PeerMessage::PeerMessage()
-  : ::google::protobuf::Message(), _internal_metadata_(NULL) {
-  ::google::protobuf::internal::InitSCC(
-      &protobuf_peer_2dmessage_2eproto::scc_info_PeerMessage.base);
-  SharedCtor();
-  // @@protoc_insertion_point(constructor:proto.PeerMessage)
+class PeerMessage::_Internal {
+ public:
+  using HasBits = decltype(std::declval<PeerMessage>()._impl_._has_bits_);
+  static void set_has_type(HasBits* has_bits) {
+    (*has_bits)[0] |= 2u;
+  }
+  static void set_has_term(HasBits* has_bits) {
+    (*has_bits)[0] |= 4u;
+  }
+  static void set_has_server_id(HasBits* has_bits) {
+    (*has_bits)[0] |= 8u;
+  }
+  static void set_has_accepts_frames(HasBits* has_bits) {
+    (*has_bits)[0] |= 2048u;
+  }
+  static void set_has_prev_log_index(HasBits* has_bits) {
+    (*has_bits)[0] |= 16u;
+  }
+  static void set_has_prev_log_term(HasBits* has_bits) {
+    (*has_bits)[0] |= 32u;
+  }
+  static void set_has_leader_commit(HasBits* has_bits) {
+    (*has_bits)[0] |= 64u;
+  }
+  static void set_has_success(HasBits* has_bits) {
+    (*has_bits)[0] |= 4096u;
+  }
+  static void set_has_appended_log_index(HasBits* has_bits) {
+    (*has_bits)[0] |= 128u;
+  }
+  static void set_has_conflict_term(HasBits* has_bits) {
+    (*has_bits)[0] |= 262144u;
+  }
+  static void set_has_conflict_first_index(HasBits* has_bits) {
+    (*has_bits)[0] |= 131072u;
+  }
+  static void set_has_last_log_index(HasBits* has_bits) {
+    (*has_bits)[0] |= 256u;
+  }
+  static void set_has_last_log_term(HasBits* has_bits) {
+    (*has_bits)[0] |= 512u;
+  }
+  static void set_has_vote_granted(HasBits* has_bits) {
+    (*has_bits)[0] |= 8192u;
+  }
+  static void set_has_last_included_index(HasBits* has_bits) {
+    (*has_bits)[0] |= 1024u;
+  }
+  static void set_has_last_included_term(HasBits* has_bits) {
+    (*has_bits)[0] |= 32768u;
+  }
+  static void set_has_offset(HasBits* has_bits) {
+    (*has_bits)[0] |= 65536u;
+  }
+  static void set_has_data(HasBits* has_bits) {
+    (*has_bits)[0] |= 1u;
+  }
+  static void set_has_done(HasBits* has_bits) {
+    (*has_bits)[0] |= 16384u;
+  }
+  static bool MissingRequiredFields(const HasBits& has_bits) {
+    return ((has_bits[0] & 0x0000000e) ^ 0x0000000e) != 0;
+  }
+};
+
+PeerMessage::PeerMessage(::PROTOBUF_NAMESPACE_ID::Arena* arena,
+                         bool is_message_owned)
+  : ::PROTOBUF_NAMESPACE_ID::Message(arena, is_message_owned) {
+  SharedCtor(arena, is_message_owned);
+  // @@protoc_insertion_point(arena_constructor:proto.PeerMessage)
 }
 PeerMessage::PeerMessage(const PeerMessage& from)
-  : ::google::protobuf::Message(),
-      _internal_metadata_(NULL),
-      _has_bits_(from._has_bits_),
-      entries_(from.entries_) {
-  _internal_metadata_.MergeFrom(from._internal_metadata_);
-  ::memcpy(&type_, &from.type_,
-    static_cast<size_t>(reinterpret_cast<char*>(&last_log_term_) -
-    reinterpret_cast<char*>(&type_)) + sizeof(last_log_term_));
+  : ::PROTOBUF_NAMESPACE_ID::Message() {
+  PeerMessage* const _this = this; (void)_this;
+  new (&_impl_) Impl_{
+      decltype(_impl_._has_bits_){from._impl_._has_bits_}
+    , /*decltype(_impl_._cached_size_)*/{}
+    , decltype(_impl_.entries_){from._impl_.entries_}
+    , decltype(_impl_.data_){}
+    , decltype(_impl_.type_){}
+    , decltype(_impl_.term_){}
+    , decltype(_impl_.server_id_){}
+    , decltype(_impl_.prev_log_index_){}
+    , decltype(_impl_.prev_log_term_){}
+    , decltype(_impl_.leader_commit_){}
+    , decltype(_impl_.appended_log_index_){}
+    , decltype(_impl_.last_log_index_){}
+    , decltype(_impl_.last_log_term_){}
+    , decltype(_impl_.last_included_index_){}
+    , decltype(_impl_.accepts_frames_){}
+    , decltype(_impl_.success_){}
+    , decltype(_impl_.vote_granted_){}
+    , decltype(_impl_.done_){}
+    , decltype(_impl_.last_included_term_){}
+    , decltype(_impl_.offset_){}
+    , decltype(_impl_.conflict_first_index_){}
+    , decltype(_impl_.conflict_term_){}};
+
+  _internal_metadata_.MergeFrom<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(from._internal_metadata_);
+  _impl_.data_.InitDefault();
+  #ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+    _impl_.data_.Set("", GetArenaForAllocation());
+  #endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  if (from._internal_has_data()) {
+    _this->_impl_.data_.Set(from._internal_data(), 
+      _this->GetArenaForAllocation());
+  }
+  ::memcpy(&_impl_.type_, &from._impl_.type_,
+    static_cast<size_t>(reinterpret_cast<char*>(&_impl_.conflict_term_) -
+    reinterpret_cast<char*>(&_impl_.type_)) + sizeof(_impl_.conflict_term_));
   // @@protoc_insertion_point(copy_constructor:proto.PeerMessage)
 }
 
-void PeerMessage::SharedCtor() {
-  ::memset(&type_, 0, static_cast<size_t>(
-      reinterpret_cast<char*>(&last_log_term_) -
-      reinterpret_cast<char*>(&type_)) + sizeof(last_log_term_));
+inline void PeerMessage::SharedCtor(
+    ::_pb::Arena* arena, bool is_message_owned) {
+  (void)arena;
+  (void)is_message_owned;
+  new (&_impl_) Impl_{
+      decltype(_impl_._has_bits_){}
+    , /*decltype(_impl_._cached_size_)*/{}
+    , decltype(_impl_.entries_){arena}
+    , decltype(_impl_.data_){}
+    , decltype(_impl_.type_){0}
+    , decltype(_impl_.term_){0}
+    , decltype(_impl_.server_id_){0}
+    , decltype(_impl_.prev_log_index_){0}
+    , decltype(_impl_.prev_log_term_){0}
+    , decltype(_impl_.leader_commit_){0}
+    , decltype(_impl_.appended_log_index_){0}
+    , decltype(_impl_.last_log_index_){0}
+    , decltype(_impl_.last_log_term_){0}
+    , decltype(_impl_.last_included_index_){0}
+    , decltype(_impl_.accepts_frames_){false}
+    , decltype(_impl_.success_){false}
+    , decltype(_impl_.vote_granted_){false}
+    , decltype(_impl_.done_){false}
+    , decltype(_impl_.last_included_term_){0}
+    , decltype(_impl_.offset_){int64_t{0}}
+    , decltype(_impl_.conflict_first_index_){0}
+    , decltype(_impl_.conflict_term_){-1}
+  };
+  _impl_.data_.InitDefault();
+  #ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+    _impl_.data_.Set("", GetArenaForAllocation());
+  #endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
 }
 
 PeerMessage::~PeerMessage() {
   // @@protoc_insertion_point(destructor:proto.PeerMessage)
+  if (auto *arena = _internal_metadata_.DeleteReturnArena<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>()) {
+  (void)arena;
+    return;
+  }
   SharedDtor();
 }
 
-void PeerMessage::SharedDtor() {
+inline void PeerMessage::SharedDtor() {
+  GOOGLE_DCHECK(GetArenaForAllocation() == nullptr);
+  _impl_.entries_.~RepeatedPtrField();
+  _impl_.data_.Destroy();
 }
 
 void PeerMessage::SetCachedSize(int size) const {
-  _cached_size_.Set(size);
-}
-const ::google::protobuf::Descriptor* PeerMessage::descriptor() {
-  ::protobuf_peer_2dmessage_2eproto::protobuf_AssignDescriptorsOnce();
-  return ::protobuf_peer_2dmessage_2eproto::file_level_metadata[kIndexInFileMessages].descriptor;
+  _impl_._cached_size_.Set(size);
 }
 
-const PeerMessage& PeerMessage::default_instance() {
-  ::google::protobuf::internal::InitSCC(&protobuf_peer_2dmessage_2eproto::scc_info_PeerMessage.base);
-  return *internal_default_instance();
-}
-
-
 void PeerMessage::Clear() {
 // @@protoc_insertion_point(message_clear_start:proto.PeerMessage)
-  ::google::protobuf::uint32 cached_has_bits = 0;
+  uint32_t cached_has_bits = 0;
   // Prevent compiler warnings about cached_has_bits being unused
   (void) cached_has_bits;
 
-  entries_.Clear();
-  cached_has_bits = _has_bits_[0];
-  if (cached_has_bits & 255u) {
-    ::memset(&type_, 0, static_cast<size_t>(
-        reinterpret_cast<char*>(&last_log_index_) -
-        reinterpret_cast<char*>(&type_)) + sizeof(last_log_index_));
+  _impl_.entries_.Clear();
+  cached_has_bits = _impl_._has_bits_[0];
+  if (cached_has_bits & 0x00000001u) {
+    _impl_.data_.ClearNonDefaultToEmpty();
+  }
+  if (cached_has_bits & 0x000000feu) {
+    ::memset(&_impl_.type_, 0, static_cast<size_t>(
+        reinterpret_cast<char*>(&_impl_.appended_log_index_) -
+        reinterpret_cast<char*>(&_impl_.type_)) + sizeof(_impl_.appended_log_index_));
+  }
+  if (cached_has_bits & 0x0000ff00u) {
+    ::memset(&_impl_.last_log_index_, 0, static_cast<size_t>(
+        reinterpret_cast<char*>(&_impl_.last_included_term_) -
+        reinterpret_cast<char*>(&_impl_.last_log_index_)) + sizeof(_impl_.last_included_term_));
   }
-  if (cached_has_bits & 1792u) {
-    ::memset(&success_, 0, static_cast<size_t>(
-        reinterpret_cast<char*>(&last_log_term_) -
-        reinterpret_cast<char*>(&success_)) + sizeof(last_log_term_));
+  if (cached_has_bits & 0x00070000u) {
+    ::memset(&_impl_.offset_, 0, static_cast<size_t>(
+        reinterpret_cast<char*>(&_impl_.conflict_first_index_) -
+        reinterpret_cast<char*>(&_impl_.offset_)) + sizeof(_impl_.conflict_first_index_));
+    _impl_.conflict_term_ = -1;
   }
-  _has_bits_.Clear();
-  _internal_metadata_.Clear();
+  _impl_._has_bits_.Clear();
+  _internal_metadata_.Clear<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>();
 }
 
-bool PeerMessage::MergePartialFromCodedStream(
-    ::google::protobuf::io::CodedInputStream* input) {
-#define DO_(EXPRESSION) if (!GOOGLE_PREDICT_TRUE(EXPRESSION)) goto failure
-  ::google::protobuf::uint32 tag;
-  // @@protoc_insertion_point(parse_start:proto.PeerMessage)
-  for (;;) {
-    ::std::pair<::google::protobuf::uint32, bool> p = input->ReadTagWithCutoffNoLastTag(127u);
-    tag = p.first;
-    if (!p.second) goto handle_unusual;
-    switch (::google::protobuf::internal::WireFormatLite::GetTagFieldNumber(tag)) {
+const char* PeerMessage::_InternalParse(const char* ptr, ::_pbi::ParseContext* ctx) {
+#define CHK_(x) if (PROTOBUF_PREDICT_FALSE(!(x))) goto failure
+  _Internal::HasBits has_bits{};
+  while (!ctx->Done(&ptr)) {
+    uint32_t tag;
+    ptr = ::_pbi::ReadTag(ptr, &tag);
+    switch (tag >> 3) {
       // required .proto.PeerMessage.Type type = 1;
-      case 1: {
-        if (static_cast< ::google::protobuf::uint8>(tag) ==
-            static_cast< ::google::protobuf::uint8>(8u /* 8 & 0xFF */)) {
-          int value;
-          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
-                   int, ::google::protobuf::internal::WireFormatLite::TYPE_ENUM>(
-                 input, &value)));
-          if (::proto::PeerMessage_Type_IsValid(value)) {
-            set_type(static_cast< ::proto::PeerMessage_Type >(value));
+      case 1:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 8)) {
+          uint64_t val = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint64(&ptr);
+          CHK_(ptr);
+          if (PROTOBUF_PREDICT_TRUE(::proto::PeerMessage_Type_IsValid(val))) {
+            _internal_set_type(static_cast<::proto::PeerMessage_Type>(val));
           } else {
-            mutable_unknown_fields()->AddVarint(
-                1, static_cast< ::google::protobuf::uint64>(value));
+            ::PROTOBUF_NAMESPACE_ID::internal::WriteVarint(1, val, mutable_unknown_fields());
           }
-        } else {
+        } else
           goto handle_unusual;
-        }
-        break;
-      }
-
+        continue;
       // required int32 term = 2;
-      case 2: {
-        if (static_cast< ::google::protobuf::uint8>(tag) ==
-            static_cast< ::google::protobuf::uint8>(16u /* 16 & 0xFF */)) {
-          set_has_term();
-          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
-                   ::google::protobuf::int32, ::google::protobuf::internal::WireFormatLite::TYPE_INT32>(
-                 input, &term_)));
-        } else {
+      case 2:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 16)) {
+          _Internal::set_has_term(&has_bits);
+          _impl_.term_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
           goto handle_unusual;
-        }
-        break;
-      }
-
+        continue;
       // required int32 server_id = 3;
-      case 3: {
-        if (static_cast< ::google::protobuf::uint8>(tag) ==
-            static_cast< ::google::protobuf::uint8>(24u /* 24 & 0xFF */)) {
-          set_has_server_id();
-          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
-                   ::google::protobuf::int32, ::google::protobuf::internal::WireFormatLite::TYPE_INT32>(
-                 input, &server_id_)));
-        } else {
+      case 3:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 24)) {
+          _Internal::set_has_server_id(&has_bits);
+          _impl_.server_id_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
           goto handle_unusual;
-        }
-        break;
-      }
-
+        continue;
       // optional int32 prev_log_index = 4;
-      case 4: {
-        if (static_cast< ::google::protobuf::uint8>(tag) ==
-            static_cast< ::google::protobuf::uint8>(32u /* 32 & 0xFF */)) {
-          set_has_prev_log_index();
-          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
-                   ::google::protobuf::int32, ::google::protobuf::internal::WireFormatLite::TYPE_INT32>(
-                 input, &prev_log_index_)));
-        } else {
+      case 4:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 32)) {
+          _Internal::set_has_prev_log_index(&has_bits);
+          _impl_.prev_log_index_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
           goto handle_unusual;
-        }
-        break;
-      }
-
+        continue;
       // optional int32 prev_log_term = 5;
-      case 5: {
-        if (static_cast< ::google::protobuf::uint8>(tag) ==
-            static_cast< ::google::protobuf::uint8>(40u /* 40 & 0xFF */)) {
-          set_has_prev_log_term();
-          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
-                   ::google::protobuf::int32, ::google::protobuf::internal::WireFormatLite::TYPE_INT32>(
-                 input, &prev_log_term_)));
-        } else {
+      case 5:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 40)) {
+          _Internal::set_has_prev_log_term(&has_bits);
+          _impl_.prev_log_term_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
           goto handle_unusual;
-        }
-        break;
-      }
-
+        continue;
       // repeated string entries = 6;
-      case 6: {
-        if (static_cast< ::google::protobuf::uint8>(tag) ==
-            static_cast< ::google::protobuf::uint8>(50u /* 50 & 0xFF */)) {
-          DO_(::google::protobuf::internal::WireFormatLite::ReadString(
-                input, this->add_entries()));
-          ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(
-            this->entries(this->entries_size() - 1).data(),
-            static_cast<int>(this->entries(this->entries_size() - 1).length()),
-            ::google::protobuf::internal::WireFormat::PARSE,
-            "proto.PeerMessage.entries");
-        } else {
+      case 6:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 50)) {
+          ptr -= 1;
+          do {
+            ptr += 1;
+            auto str = _internal_add_entries();
+            ptr = ::_pbi::InlineGreedyStringParser(str, ptr, ctx);
+            CHK_(ptr);
+            #ifndef NDEBUG
+            ::_pbi::VerifyUTF8(str, "proto.PeerMessage.entries");
+            #endif  // !NDEBUG
+            if (!ctx->DataAvailable(ptr)) break;
+          } while (::PROTOBUF_NAMESPACE_ID::internal::ExpectTag<50>(ptr));
+        } else
           goto handle_unusual;
-        }
-        break;
-      }
-
+        continue;
       // optional int32 leader_commit = 7;
-      case 7: {
-        if (static_cast< ::google::protobuf::uint8>(tag) ==
-            static_cast< ::google::protobuf::uint8>(56u /* 56 & 0xFF */)) {
-          set_has_leader_commit();
-          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
-                   ::google::protobuf::int32, ::google::protobuf::internal::WireFormatLite::TYPE_INT32>(
-                 input, &leader_commit_)));
-        } else {
+      case 7:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 56)) {
+          _Internal::set_has_leader_commit(&has_bits);
+          _impl_.leader_commit_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
           goto handle_unusual;
-        }
-        break;
-      }
-
+        continue;
       // optional bool success = 8;
-      case 8: {
-        if (static_cast< ::google::protobuf::uint8>(tag) ==
-            static_cast< ::google::protobuf::uint8>(64u /* 64 & 0xFF */)) {
-          set_has_success();
-          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
-                   bool, ::google::protobuf::internal::WireFormatLite::TYPE_BOOL>(
-                 input, &success_)));
-        } else {
+      case 8:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 64)) {
+          _Internal::set_has_success(&has_bits);
+          _impl_.success_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint64(&ptr);
+          CHK_(ptr);
+        } else
           goto handle_unusual;
-        }
-        break;
-      }
-
+        continue;
       // optional int32 appended_log_index = 9;
-      case 9: {
-        if (static_cast< ::google::protobuf::uint8>(tag) ==
-            static_cast< ::google::protobuf::uint8>(72u /* 72 & 0xFF */)) {
-          set_has_appended_log_index();
-          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
-                   ::google::protobuf::int32, ::google::protobuf::internal::WireFormatLite::TYPE_INT32>(
-                 input, &appended_log_index_)));
-        } else {
+      case 9:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 72)) {
+          _Internal::set_has_appended_log_index(&has_bits);
+          _impl_.appended_log_index_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
           goto handle_unusual;
-        }
-        break;
-      }
-
+        continue;
       // optional int32 last_log_index = 10;
-      case 10: {
-        if (static_cast< ::google::protobuf::uint8>(tag) ==
-            static_cast< ::google::protobuf::uint8>(80u /* 80 & 0xFF */)) {
-          set_has_last_log_index();
-          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
-                   ::google::protobuf::int32, ::google::protobuf::internal::WireFormatLite::TYPE_INT32>(
-                 input, &last_log_index_)));
-        } else {
+      case 10:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 80)) {
+          _Internal::set_has_last_log_index(&has_bits);
+          _impl_.last_log_index_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
           goto handle_unusual;
-        }
-        break;
-      }
-
+        continue;
       // optional int32 last_log_term = 11;
-      case 11: {
-        if (static_cast< ::google::protobuf::uint8>(tag) ==
-            static_cast< ::google::protobuf::uint8>(88u /* 88 & 0xFF */)) {
-          set_has_last_log_term();
-          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
-                   ::google::protobuf::int32, ::google::protobuf::internal::WireFormatLite::TYPE_INT32>(
-                 input, &last_log_term_)));
-        } else {
+      case 11:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 88)) {
+          _Internal::set_has_last_log_term(&has_bits);
+          _impl_.last_log_term_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
           goto handle_unusual;
-        }
-        break;
-      }
-
+        continue;
       // optional bool vote_granted = 12;
-      case 12: {
-        if (static_cast< ::google::protobuf::uint8>(tag) ==
-            static_cast< ::google::protobuf::uint8>(96u /* 96 & 0xFF */)) {
-          set_has_vote_granted();
-          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
-                   bool, ::google::protobuf::internal::WireFormatLite::TYPE_BOOL>(
-                 input, &vote_granted_)));
-        } else {
+      case 12:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 96)) {
+          _Internal::set_has_vote_granted(&has_bits);
+          _impl_.vote_granted_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint64(&ptr);
+          CHK_(ptr);
+        } else
           goto handle_unusual;
-        }
-        break;
-      }
-
-      default: {
-      handle_unusual:
-        if (tag == 0) {
-          goto success;
-        }
-        DO_(::google::protobuf::internal::WireFormat::SkipField(
-              input, tag, _internal_metadata_.mutable_unknown_fields()));
-        break;
-      }
-    }
-  }
-success:
-  // @@protoc_insertion_point(parse_success:proto.PeerMessage)
-  return true;
+        continue;
+      // optional int32 last_included_index = 13;
+      case 13:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 104)) {
+          _Internal::set_has_last_included_index(&has_bits);
+          _impl_.last_included_index_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      // optional int32 last_included_term = 14;
+      case 14:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 112)) {
+          _Internal::set_has_last_included_term(&has_bits);
+          _impl_.last_included_term_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      // optional int64 offset = 15;
+      case 15:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 120)) {
+          _Internal::set_has_offset(&has_bits);
+          _impl_.offset_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint64(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      // optional bytes data = 16;
+      case 16:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 130)) {
+          auto str = _internal_mutable_data();
+          ptr = ::_pbi::InlineGreedyStringParser(str, ptr, ctx);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      // optional bool done = 17;
+      case 17:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 136)) {
+          _Internal::set_has_done(&has_bits);
+          _impl_.done_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint64(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      // optional bool accepts_frames = 18;
+      case 18:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 144)) {
+          _Internal::set_has_accepts_frames(&has_bits);
+          _impl_.accepts_frames_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint64(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      // optional int32 conflict_term = 19 [default = -1];
+      case 19:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 152)) {
+          _Internal::set_has_conflict_term(&has_bits);
+          _impl_.conflict_term_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      // optional int32 conflict_first_index = 20;
+      case 20:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 160)) {
+          _Internal::set_has_conflict_first_index(&has_bits);
+          _impl_.conflict_first_index_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      default:
+        goto handle_unusual;
+    }  // switch
+  handle_unusual:
+    if ((tag == 0) || ((tag & 7) == 4)) {
+      CHK_(ptr);
+      ctx->SetLastTag(tag);
+      goto message_done;
+    }
+    ptr = UnknownFieldParse(
+        tag,
+        _internal_metadata_.mutable_unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(),
+        ptr, ctx);
+    CHK_(ptr != nullptr);
+  }  // while
+message_done:
+  _impl_._has_bits_.Or(has_bits);
+  return ptr;
 failure:
-  // @@protoc_insertion_point(parse_failure:proto.PeerMessage)
-  return false;
-#undef DO_
+  ptr = nullptr;
+  goto message_done;
+#undef CHK_
 }
 
-void PeerMessage::SerializeWithCachedSizes(
-    ::google::protobuf::io::CodedOutputStream* output) const {
-  // @@protoc_insertion_point(serialize_start:proto.PeerMessage)
-  ::google::protobuf::uint32 cached_has_bits = 0;
+uint8_t* PeerMessage::_InternalSerialize(
+    uint8_t* target, ::PROTOBUF_NAMESPACE_ID::io::EpsCopyOutputStream* stream) const {
+  // @@protoc_insertion_point(serialize_to_array_start:proto.PeerMessage)
+  uint32_t cached_has_bits = 0;
   (void) cached_has_bits;
 
-  cached_has_bits = _has_bits_[0];
+  cached_has_bits = _impl_._has_bits_[0];
   // required .proto.PeerMessage.Type type = 1;
-  if (cached_has_bits & 0x00000001u) {
-    ::google::protobuf::internal::WireFormatLite::WriteEnum(
-      1, this->type(), output);
+  if (cached_has_bits & 0x00000002u) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteEnumToArray(
+      1, this->_internal_type(), target);
   }
 
   // required int32 term = 2;
-  if (cached_has_bits & 0x00000002u) {
-    ::google::protobuf::internal::WireFormatLite::WriteInt32(2, this->term(), output);
+  if (cached_has_bits & 0x00000004u) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteInt32ToArray(2, this->_internal_term(), target);
   }
 
   // required int32 server_id = 3;
-  if (cached_has_bits & 0x00000004u) {
-    ::google::protobuf::internal::WireFormatLite::WriteInt32(3, this->server_id(), output);
+  if (cached_has_bits & 0x00000008u) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteInt32ToArray(3, this->_internal_server_id(), target);
   }
 
   // optional int32 prev_log_index = 4;
-  if (cached_has_bits & 0x00000008u) {
-    ::google::protobuf::internal::WireFormatLite::WriteInt32(4, this->prev_log_index(), output);
+  if (cached_has_bits & 0x00000010u) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteInt32ToArray(4, this->_internal_prev_log_index(), target);
   }
 
   // optional int32 prev_log_term = 5;
-  if (cached_has_bits & 0x00000010u) {
-    ::google::protobuf::internal::WireFormatLite::WriteInt32(5, this->prev_log_term(), output);
+  if (cached_has_bits & 0x00000020u) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteInt32ToArray(5, this->_internal_prev_log_term(), target);
   }
 
   // repeated string entries = 6;
-  for (int i = 0, n = this->entries_size(); i < n; i++) {
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(
-      this->entries(i).data(), static_cast<int>(this->entries(i).length()),
-      ::google::protobuf::internal::WireFormat::SERIALIZE,
+  for (int i = 0, n = this->_internal_entries_size(); i < n; i++) {
+    const auto& s = this->_internal_entries(i);
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::VerifyUTF8StringNamedField(
+      s.data(), static_cast<int>(s.length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SERIALIZE,
       "proto.PeerMessage.entries");
-    ::google::protobuf::internal::WireFormatLite::WriteString(
-      6, this->entries(i), output);
+    target = stream->WriteString(6, s, target);
   }
 
   // optional int32 leader_commit = 7;
-  if (cached_has_bits & 0x00000020u) {
-    ::google::protobuf::internal::WireFormatLite::WriteInt32(7, this->leader_commit(), output);
+  if (cached_has_bits & 0x00000040u) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteInt32ToArray(7, this->_internal_leader_commit(), target);
   }
 
   // optional bool success = 8;
-  if (cached_has_bits & 0x00000100u) {
-    ::google::protobuf::internal::WireFormatLite::WriteBool(8, this->success(), output);
+  if (cached_has_bits & 0x00001000u) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteBoolToArray(8, this->_internal_success(), target);
   }
 
   // optional int32 appended_log_index = 9;
-  if (cached_has_bits & 0x00000040u) {
-    ::google::protobuf::internal::WireFormatLite::WriteInt32(9, this->appended_log_index(), output);
+  if (cached_has_bits & 0x00000080u) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteInt32ToArray(9, this->_internal_appended_log_index(), target);
   }
 
   // optional int32 last_log_index = 10;
-  if (cached_has_bits & 0x00000080u) {
-    ::google::protobuf::internal::WireFormatLite::WriteInt32(10, this->last_log_index(), output);
+  if (cached_has_bits & 0x00000100u) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteInt32ToArray(10, this->_internal_last_log_index(), target);
   }
 
   // optional int32 last_log_term = 11;
-  if (cached_has_bits & 0x00000400u) {
-    ::google::protobuf::internal::WireFormatLite::WriteInt32(11, this->last_log_term(), output);
-  }
-
-  // optional bool vote_granted = 12;
   if (cached_has_bits & 0x00000200u) {
-    ::google::protobuf::internal::WireFormatLite::WriteBool(12, this->vote_granted(), output);
-  }
-
-  if (_internal_metadata_.have_unknown_fields()) {
-    ::google::protobuf::internal::WireFormat::SerializeUnknownFields(
-        _internal_metadata_.unknown_fields(), output);
-  }
-  // @@protoc_insertion_point(serialize_end:proto.PeerMessage)
-}
-
-::google::protobuf::uint8* PeerMessage::InternalSerializeWithCachedSizesToArray(
-    bool deterministic, ::google::protobuf::uint8* target) const {
-  (void)deterministic; // Unused
-  // @@protoc_insertion_point(serialize_to_array_start:proto.PeerMessage)
-  ::google::protobuf::uint32 cached_has_bits = 0;
-  (void) cached_has_bits;
-
-  cached_has_bits = _has_bits_[0];
-  // required .proto.PeerMessage.Type type = 1;
-  if (cached_has_bits & 0x00000001u) {
-    target = ::google::protobuf::internal::WireFormatLite::WriteEnumToArray(
-      1, this->type(), target);
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteInt32ToArray(11, this->_internal_last_log_term(), target);
   }
 
-  // required int32 term = 2;
-  if (cached_has_bits & 0x00000002u) {
-    target = ::google::protobuf::internal::WireFormatLite::WriteInt32ToArray(2, this->term(), target);
-  }
-
-  // required int32 server_id = 3;
-  if (cached_has_bits & 0x00000004u) {
-    target = ::google::protobuf::internal::WireFormatLite::WriteInt32ToArray(3, this->server_id(), target);
-  }
-
-  // optional int32 prev_log_index = 4;
-  if (cached_has_bits & 0x00000008u) {
-    target = ::google::protobuf::internal::WireFormatLite::WriteInt32ToArray(4, this->prev_log_index(), target);
+  // optional bool vote_granted = 12;
+  if (cached_has_bits & 0x00002000u) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteBoolToArray(12, this->_internal_vote_granted(), target);
   }
 
-  // optional int32 prev_log_term = 5;
-  if (cached_has_bits & 0x00000010u) {
-    target = ::google::protobuf::internal::WireFormatLite::WriteInt32ToArray(5, this->prev_log_term(), target);
+  // optional int32 last_included_index = 13;
+  if (cached_has_bits & 0x00000400u) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteInt32ToArray(13, this->_internal_last_included_index(), target);
   }
 
-  // repeated string entries = 6;
-  for (int i = 0, n = this->entries_size(); i < n; i++) {
-    ::google::protobuf::internal::WireFormat::VerifyUTF8StringNamedField(
-      this->entries(i).data(), static_cast<int>(this->entries(i).length()),
-      ::google::protobuf::internal::WireFormat::SERIALIZE,
-      "proto.PeerMessage.entries");
-    target = ::google::protobuf::internal::WireFormatLite::
-      WriteStringToArray(6, this->entries(i), target);
+  // optional int32 last_included_term = 14;
+  if (cached_has_bits & 0x00008000u) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteInt32ToArray(14, this->_internal_last_included_term(), target);
   }
 
-  // optional int32 leader_commit = 7;
-  if (cached_has_bits & 0x00000020u) {
-    target = ::google::protobuf::internal::WireFormatLite::WriteInt32ToArray(7, this->leader_commit(), target);
+  // optional int64 offset = 15;
+  if (cached_has_bits & 0x00010000u) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteInt64ToArray(15, this->_internal_offset(), target);
   }
 
-  // optional bool success = 8;
-  if (cached_has_bits & 0x00000100u) {
-    target = ::google::protobuf::internal::WireFormatLite::WriteBoolToArray(8, this->success(), target);
+  // optional bytes data = 16;
+  if (cached_has_bits & 0x00000001u) {
+    target = stream->WriteBytesMaybeAliased(
+        16, this->_internal_data(), target);
   }
 
-  // optional int32 appended_log_index = 9;
-  if (cached_has_bits & 0x00000040u) {
-    target = ::google::protobuf::internal::WireFormatLite::WriteInt32ToArray(9, this->appended_log_index(), target);
+  // optional bool done = 17;
+  if (cached_has_bits & 0x00004000u) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteBoolToArray(17, this->_internal_done(), target);
   }
 
-  // optional int32 last_log_index = 10;
-  if (cached_has_bits & 0x00000080u) {
-    target = ::google::protobuf::internal::WireFormatLite::WriteInt32ToArray(10, this->last_log_index(), target);
+  // optional bool accepts_frames = 18;
+  if (cached_has_bits & 0x00000800u) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteBoolToArray(18, this->_internal_accepts_frames(), target);
   }
 
-  // optional int32 last_log_term = 11;
-  if (cached_has_bits & 0x00000400u) {
-    target = ::google::protobuf::internal::WireFormatLite::WriteInt32ToArray(11, this->last_log_term(), target);
+  // optional int32 conflict_term = 19 [default = -1];
+  if (cached_has_bits & 0x00040000u) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteInt32ToArray(19, this->_internal_conflict_term(), target);
   }
 
-  // optional bool vote_granted = 12;
-  if (cached_has_bits & 0x00000200u) {
-    target = ::google::protobuf::internal::WireFormatLite::WriteBoolToArray(12, this->vote_granted(), target);
+  // optional int32 conflict_first_index = 20;
+  if (cached_has_bits & 0x00020000u) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteInt32ToArray(20, this->_internal_conflict_first_index(), target);
   }
 
-  if (_internal_metadata_.have_unknown_fields()) {
-    target = ::google::protobuf::internal::WireFormat::SerializeUnknownFieldsToArray(
-        _internal_metadata_.unknown_fields(), target);
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    target = ::_pbi::WireFormat::InternalSerializeUnknownFieldsToArray(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), target, stream);
   }
   // @@protoc_insertion_point(serialize_to_array_end:proto.PeerMessage)
   return target;
@@ -625,24 +746,20 @@ size_t PeerMessage::RequiredFieldsByteSizeFallback() const {
 // @@protoc_insertion_point(required_fields_byte_size_fallback_start:proto.PeerMessage)
   size_t total_size = 0;
 
-  if (has_type()) {
+  if (_internal_has_type()) {
     // required .proto.PeerMessage.Type type = 1;
     total_size += 1 +
-      ::google::protobuf::internal::WireFormatLite::EnumSize(this->type());
+      ::_pbi::WireFormatLite::EnumSize(this->_internal_type());
   }
 
-  if (has_term()) {
+  if (_internal_has_term()) {
     // required int32 term = 2;
-    total_size += 1 +
-      ::google::protobuf::internal::WireFormatLite::Int32Size(
-        this->term());
+    total_size += ::_pbi::WireFormatLite::Int32SizePlusOne(this->_internal_term());
   }
 
-  if (has_server_id()) {
+  if (_internal_has_server_id()) {
     // required int32 server_id = 3;
-    total_size += 1 +
-      ::google::protobuf::internal::WireFormatLite::Int32Size(
-        this->server_id());
+    total_size += ::_pbi::WireFormatLite::Int32SizePlusOne(this->_internal_server_id());
   }
 
   return total_size;
@@ -651,168 +768,212 @@ size_t PeerMessage::ByteSizeLong() const {
 // @@protoc_insertion_point(message_byte_size_start:proto.PeerMessage)
   size_t total_size = 0;
 
-  if (_internal_metadata_.have_unknown_fields()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormat::ComputeUnknownFieldsSize(
-        _internal_metadata_.unknown_fields());
-  }
-  if (((_has_bits_[0] & 0x00000007) ^ 0x00000007) == 0) {  // All required fields are present.
+  if (((_impl_._has_bits_[0] & 0x0000000e) ^ 0x0000000e) == 0) {  // All required fields are present.
     // required .proto.PeerMessage.Type type = 1;
     total_size += 1 +
-      ::google::protobuf::internal::WireFormatLite::EnumSize(this->type());
+      ::_pbi::WireFormatLite::EnumSize(this->_internal_type());
 
     // required int32 term = 2;
-    total_size += 1 +
-      ::google::protobuf::internal::WireFormatLite::Int32Size(
-        this->term());
+    total_size += ::_pbi::WireFormatLite::Int32SizePlusOne(this->_internal_term());
 
     // required int32 server_id = 3;
-    total_size += 1 +
-      ::google::protobuf::internal::WireFormatLite::Int32Size(
-        this->server_id());
+    total_size += ::_pbi::WireFormatLite::Int32SizePlusOne(this->_internal_server_id());
 
   } else {
     total_size += RequiredFieldsByteSizeFallback();
   }
+  uint32_t cached_has_bits = 0;
+  // Prevent compiler warnings about cached_has_bits being unused
+  (void) cached_has_bits;
+
   // repeated string entries = 6;
   total_size += 1 *
-      ::google::protobuf::internal::FromIntSize(this->entries_size());
-  for (int i = 0, n = this->entries_size(); i < n; i++) {
-    total_size += ::google::protobuf::internal::WireFormatLite::StringSize(
-      this->entries(i));
+      ::PROTOBUF_NAMESPACE_ID::internal::FromIntSize(_impl_.entries_.size());
+  for (int i = 0, n = _impl_.entries_.size(); i < n; i++) {
+    total_size += ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::StringSize(
+      _impl_.entries_.Get(i));
+  }
+
+  // optional bytes data = 16;
+  cached_has_bits = _impl_._has_bits_[0];
+  if (cached_has_bits & 0x00000001u) {
+    total_size += 2 +
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::BytesSize(
+        this->_internal_data());
   }
 
-  if (_has_bits_[0 / 32] & 248u) {
+  if (cached_has_bits & 0x000000f0u) {
     // optional int32 prev_log_index = 4;
-    if (has_prev_log_index()) {
-      total_size += 1 +
-        ::google::protobuf::internal::WireFormatLite::Int32Size(
-          this->prev_log_index());
+    if (cached_has_bits & 0x00000010u) {
+      total_size += ::_pbi::WireFormatLite::Int32SizePlusOne(this->_internal_prev_log_index());
     }
 
     // optional int32 prev_log_term = 5;
-    if (has_prev_log_term()) {
-      total_size += 1 +
-        ::google::protobuf::internal::WireFormatLite::Int32Size(
-          this->prev_log_term());
+    if (cached_has_bits & 0x00000020u) {
+      total_size += ::_pbi::WireFormatLite::Int32SizePlusOne(this->_internal_prev_log_term());
     }
 
     // optional int32 leader_commit = 7;
-    if (has_leader_commit()) {
-      total_size += 1 +
-        ::google::protobuf::internal::WireFormatLite::Int32Size(
-          this->leader_commit());
+    if (cached_has_bits & 0x00000040u) {
+      total_size += ::_pbi::WireFormatLite::Int32SizePlusOne(this->_internal_leader_commit());
     }
 
     // optional int32 appended_log_index = 9;
-    if (has_appended_log_index()) {
-      total_size += 1 +
-        ::google::protobuf::internal::WireFormatLite::Int32Size(
-          this->appended_log_index());
+    if (cached_has_bits & 0x00000080u) {
+      total_size += ::_pbi::WireFormatLite::Int32SizePlusOne(this->_internal_appended_log_index());
     }
 
+  }
+  if (cached_has_bits & 0x0000ff00u) {
     // optional int32 last_log_index = 10;
-    if (has_last_log_index()) {
-      total_size += 1 +
-        ::google::protobuf::internal::WireFormatLite::Int32Size(
-          this->last_log_index());
+    if (cached_has_bits & 0x00000100u) {
+      total_size += ::_pbi::WireFormatLite::Int32SizePlusOne(this->_internal_last_log_index());
+    }
+
+    // optional int32 last_log_term = 11;
+    if (cached_has_bits & 0x00000200u) {
+      total_size += ::_pbi::WireFormatLite::Int32SizePlusOne(this->_internal_last_log_term());
+    }
+
+    // optional int32 last_included_index = 13;
+    if (cached_has_bits & 0x00000400u) {
+      total_size += ::_pbi::WireFormatLite::Int32SizePlusOne(this->_internal_last_included_index());
+    }
+
+    // optional bool accepts_frames = 18;
+    if (cached_has_bits & 0x00000800u) {
+      total_size += 2 + 1;
     }
 
-  }
-  if (_has_bits_[8 / 32] & 1792u) {
     // optional bool success = 8;
-    if (has_success()) {
+    if (cached_has_bits & 0x00001000u) {
       total_size += 1 + 1;
     }
 
     // optional bool vote_granted = 12;
-    if (has_vote_granted()) {
+    if (cached_has_bits & 0x00002000u) {
       total_size += 1 + 1;
     }
 
-    // optional int32 last_log_term = 11;
-    if (has_last_log_term()) {
-      total_size += 1 +
-        ::google::protobuf::internal::WireFormatLite::Int32Size(
-          this->last_log_term());
+    // optional bool done = 17;
+    if (cached_has_bits & 0x00004000u) {
+      total_size += 2 + 1;
+    }
+
+    // optional int32 last_included_term = 14;
+    if (cached_has_bits & 0x00008000u) {
+      total_size += ::_pbi::WireFormatLite::Int32SizePlusOne(this->_internal_last_included_term());
     }
 
   }
-  int cached_size = ::google::protobuf::internal::ToCachedSize(total_size);
-  SetCachedSize(cached_size);
-  return total_size;
-}
+  if (cached_has_bits & 0x00070000u) {
+    // optional int64 offset = 15;
+    if (cached_has_bits & 0x00010000u) {
+      total_size += ::_pbi::WireFormatLite::Int64SizePlusOne(this->_internal_offset());
+    }
+
+    // optional int32 conflict_first_index = 20;
+    if (cached_has_bits & 0x00020000u) {
+      total_size += 2 +
+        ::_pbi::WireFormatLite::Int32Size(
+          this->_internal_conflict_first_index());
+    }
+
+    // optional int32 conflict_term = 19 [default = -1];
+    if (cached_has_bits & 0x00040000u) {
+      total_size += 2 +
+        ::_pbi::WireFormatLite::Int32Size(
+          this->_internal_conflict_term());
+    }
 
-void PeerMessage::MergeFrom(const ::google::protobuf::Message& from) {
-// @@protoc_insertion_point(generalized_merge_from_start:proto.PeerMessage)
-  GOOGLE_DCHECK_NE(&from, this);
-  const PeerMessage* source =
-      ::google::protobuf::internal::DynamicCastToGenerated<const PeerMessage>(
-          &from);
-  if (source == NULL) {
-  // @@protoc_insertion_point(generalized_merge_from_cast_fail:proto.PeerMessage)
-    ::google::protobuf::internal::ReflectionOps::Merge(from, this);
-  } else {
-  // @@protoc_insertion_point(generalized_merge_from_cast_success:proto.PeerMessage)
-    MergeFrom(*source);
   }
+  return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
-void PeerMessage::MergeFrom(const PeerMessage& from) {
-// @@protoc_insertion_point(class_specific_merge_from_start:proto.PeerMessage)
-  GOOGLE_DCHECK_NE(&from, this);
-  _internal_metadata_.MergeFrom(from._internal_metadata_);
-  ::google::protobuf::uint32 cached_has_bits = 0;
+const ::PROTOBUF_NAMESPACE_ID::Message::ClassData PeerMessage::_class_data_ = {
+    ::PROTOBUF_NAMESPACE_ID::Message::CopyWithSourceCheck,
+    PeerMessage::MergeImpl
+};
+const ::PROTOBUF_NAMESPACE_ID::Message::ClassData*PeerMessage::GetClassData() const { return &_class_data_; }
+
+
+void PeerMessage::MergeImpl(::PROTOBUF_NAMESPACE_ID::Message& to_msg, const ::PROTOBUF_NAMESPACE_ID::Message& from_msg) {
+  auto* const _this = static_cast<PeerMessage*>(&to_msg);
+  auto& from = static_cast<const PeerMessage&>(from_msg);
+  // @@protoc_insertion_point(class_specific_merge_from_start:proto.PeerMessage)
+  GOOGLE_DCHECK_NE(&from, _this);
+  uint32_t cached_has_bits = 0;
   (void) cached_has_bits;
 
-  entries_.MergeFrom(from.entries_);
-  cached_has_bits = from._has_bits_[0];
-  if (cached_has_bits & 255u) {
+  _this->_impl_.entries_.MergeFrom(from._impl_.entries_);
+  cached_has_bits = from._impl_._has_bits_[0];
+  if (cached_has_bits & 0x000000ffu) {
     if (cached_has_bits & 0x00000001u) {
-      type_ = from.type_;
+      _this->_internal_set_data(from._internal_data());
     }
     if (cached_has_bits & 0x00000002u) {
-      term_ = from.term_;
+      _this->_impl_.type_ = from._impl_.type_;
     }
     if (cached_has_bits & 0x00000004u) {
-      server_id_ = from.server_id_;
+      _this->_impl_.term_ = from._impl_.term_;
     }
     if (cached_has_bits & 0x00000008u) {
-      prev_log_index_ = from.prev_log_index_;
+      _this->_impl_.server_id_ = from._impl_.server_id_;
     }
     if (cached_has_bits & 0x00000010u) {
-      prev_log_term_ = from.prev_log_term_;
+      _this->_impl_.prev_log_index_ = from._impl_.prev_log_index_;
     }
     if (cached_has_bits & 0x00000020u) {
-      leader_commit_ = from.leader_commit_;
+      _this->_impl_.prev_log_term_ = from._impl_.prev_log_term_;
     }
     if (cached_has_bits & 0x00000040u) {
-      appended_log_index_ = from.appended_log_index_;
+      _this->_impl_.leader_commit_ = from._impl_.leader_commit_;
     }
     if (cached_has_bits & 0x00000080u) {
-      last_log_index_ = from.last_log_index_;
+      _this->_impl_.appended_log_index_ = from._impl_.appended_log_index_;
     }
-    _has_bits_[0] |= cached_has_bits;
+    _this->_impl_._has_bits_[0] |= cached_has_bits;
   }
-  if (cached_has_bits & 1792u) {
+  if (cached_has_bits & 0x0000ff00u) {
     if (cached_has_bits & 0x00000100u) {
-      success_ = from.success_;
+      _this->_impl_.last_log_index_ = from._impl_.last_log_index_;
     }
     if (cached_has_bits & 0x00000200u) {
-      vote_granted_ = from.vote_granted_;
+      _this->_impl_.last_log_term_ = from._impl_.last_log_term_;
     }
     if (cached_has_bits & 0x00000400u) {
-      last_log_term_ = from.last_log_term_;
+      _this->_impl_.last_included_index_ = from._impl_.last_included_index_;
+    }
+    if (cached_has_bits & 0x00000800u) {
+      _this->_impl_.accepts_frames_ = from._impl_.accepts_frames_;
+    }
+    if (cached_has_bits & 0x00001000u) {
+      _this->_impl_.success_ = from._impl_.success_;
+    }
+    if (cached_has_bits & 0x00002000u) {
+      _this->_impl_.vote_granted_ = from._impl_.vote_granted_;
+    }
+    if (cached_has_bits & 0x00004000u) {
+      _this->_impl_.done_ = from._impl_.done_;
     }
-    _has_bits_[0] |= cached_has_bits;
+    if (cached_has_bits & 0x00008000u) {
+      _this->_impl_.last_included_term_ = from._impl_.last_included_term_;
+    }
+    _this->_impl_._has_bits_[0] |= cached_has_bits;
   }
-}
-
-void PeerMessage::CopyFrom(const ::google::protobuf::Message& from) {
-// @@protoc_insertion_point(generalized_copy_from_start:proto.PeerMessage)
-  if (&from == this) return;
-  Clear();
-  MergeFrom(from);
+  if (cached_has_bits & 0x00070000u) {
+    if (cached_has_bits & 0x00010000u) {
+      _this->_impl_.offset_ = from._impl_.offset_;
+    }
+    if (cached_has_bits & 0x00020000u) {
+      _this->_impl_.conflict_first_index_ = from._impl_.conflict_first_index_;
+    }
+    if (cached_has_bits & 0x00040000u) {
+      _this->_impl_.conflict_term_ = from._impl_.conflict_term_;
+    }
+    _this->_impl_._has_bits_[0] |= cached_has_bits;
+  }
+  _this->_internal_metadata_.MergeFrom<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(from._internal_metadata_);
 }
 
 void PeerMessage::CopyFrom(const PeerMessage& from) {
@@ -823,46 +984,44 @@ void PeerMessage::CopyFrom(const PeerMessage& from) {
 }
 
 bool PeerMessage::IsInitialized() const {
-  if ((_has_bits_[0] & 0x00000007) != 0x00000007) return false;
+  if (_Internal::MissingRequiredFields(_impl_._has_bits_)) return false;
   return true;
 }
 
-void PeerMessage::Swap(PeerMessage* other) {
-  if (other == this) return;
-  InternalSwap(other);
-}
 void PeerMessage::InternalSwap(PeerMessage* other) {
   using std::swap;
-  entries_.InternalSwap(CastToBase(&other->entries_));
-  swap(type_, other->type_);
-  swap(term_, other->term_);
-  swap(server_id_, other->server_id_);
-  swap(prev_log_index_, other->prev_log_index_);
-  swap(prev_log_term_, other->prev_log_term_);
-  swap(leader_commit_, other->leader_commit_);
-  swap(appended_log_index_, other->appended_log_index_);
-  swap(last_log_index_, other->last_log_index_);
-  swap(success_, other->success_);
-  swap(vote_granted_, other->vote_granted_);
-  swap(last_log_term_, other->last_log_term_);
-  swap(_has_bits_[0], other->_has_bits_[0]);
-  _internal_metadata_.Swap(&other->_internal_metadata_);
+  auto* lhs_arena = GetArenaForAllocation();
+  auto* rhs_arena = other->GetArenaForAllocation();
+  _internal_metadata_.InternalSwap(&other->_internal_metadata_);
+  swap(_impl_._has_bits_[0], other->_impl_._has_bits_[0]);
+  _impl_.entries_.InternalSwap(&other->_impl_.entries_);
+  ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr::InternalSwap(
+      &_impl_.data_, lhs_arena,
+      &other->_impl_.data_, rhs_arena
+  );
+  ::PROTOBUF_NAMESPACE_ID::internal::memswap<
+      PROTOBUF_FIELD_OFFSET(PeerMessage, _impl_.conflict_first_index_)
+      + sizeof(PeerMessage::_impl_.conflict_first_index_)
+      - PROTOBUF_FIELD_OFFSET(PeerMessage, _impl_.type_)>(
+          reinterpret_cast<char*>(&_impl_.type_),
+          reinterpret_cast<char*>(&other->_impl_.type_));
+  swap(_impl_.conflict_term_, other->_impl_.conflict_term_);
 }
 
-::google::protobuf::Metadata PeerMessage::GetMetadata() const {
-  protobuf_peer_2dmessage_2eproto::protobuf_AssignDescriptorsOnce();
-  return ::protobuf_peer_2dmessage_2eproto::file_level_metadata[kIndexInFileMessages];
+::PROTOBUF_NAMESPACE_ID::Metadata PeerMessage::GetMetadata() const {
+  return ::_pbi::AssignDescriptors(
+      &descriptor_table_peer_2dmessage_2eproto_getter, &descriptor_table_peer_2dmessage_2eproto_once,
+      file_level_metadata_peer_2dmessage_2eproto[0]);
 }
 
-
 // @@protoc_insertion_point(namespace_scope)
 }  // namespace proto
-namespace google {
-namespace protobuf {
-template<> GOOGLE_PROTOBUF_ATTRIBUTE_NOINLINE ::proto::PeerMessage* Arena::CreateMaybeMessage< ::proto::PeerMessage >(Arena* arena) {
-  return Arena::CreateInternal< ::proto::PeerMessage >(arena);
+PROTOBUF_NAMESPACE_OPEN
+template<> PROTOBUF_NOINLINE ::proto::PeerMessage*
+Arena::CreateMaybeMessage< ::proto::PeerMessage >(Arena* arena) {
+  return Arena::CreateMessageInternal< ::proto::PeerMessage >(arena);
 }
-}  // namespace protobuf
-}  // namespace google
+PROTOBUF_NAMESPACE_CLOSE
 
 // @@protoc_insertion_point(global_scope)
+#include <google/protobuf/port_undef.inc>
@@ -1,123 +1,139 @@
 // Generated by the protocol buffer compiler.  DO NOT EDIT!
 // source: peer-message.proto
 
-#ifndef PROTOBUF_INCLUDED_peer_2dmessage_2eproto
-#define PROTOBUF_INCLUDED_peer_2dmessage_2eproto
+#ifndef GOOGLE_PROTOBUF_INCLUDED_peer_2dmessage_2eproto
+#define GOOGLE_PROTOBUF_INCLUDED_peer_2dmessage_2eproto
 
+#include <limits>
 #include <string>
 
-#include <google/protobuf/stubs/common.h>
-
-#if GOOGLE_PROTOBUF_VERSION < 3006001
+#include <google/protobuf/port_def.inc>
+#if PROTOBUF_VERSION < 3021000
 #error This file was generated by a newer version of protoc which is
-#error incompatible with your Protocol Buffer headers.  Please update
+#error incompatible with your Protocol Buffer headers. Please update
 #error your headers.
 #endif
-#if 3006001 < GOOGLE_PROTOBUF_MIN_PROTOC_VERSION
+#if 3021012 < PROTOBUF_MIN_PROTOC_VERSION
 #error This file was generated by an older version of protoc which is
-#error incompatible with your Protocol Buffer headers.  Please
+#error incompatible with your Protocol Buffer headers. Please
 #error regenerate this file with a newer version of protoc.
 #endif
 
+#include <google/protobuf/port_undef.inc>
 #include <google/protobuf/io/coded_stream.h>
 #include <google/protobuf/arena.h>
 #include <google/protobuf/arenastring.h>
-#include <google/protobuf/generated_message_table_driven.h>
 #include <google/protobuf/generated_message_util.h>
-#include <google/protobuf/inlined_string_field.h>
-#include <google/protobuf/metadata.h>
+#include <google/protobuf/metadata_lite.h>
+#include <google/protobuf/generated_message_reflection.h>
 #include <google/protobuf/message.h>
 #include <google/protobuf/repeated_field.h>  // IWYU pragma: export
 #include <google/protobuf/extension_set.h>  // IWYU pragma: export
 #include <google/protobuf/generated_enum_reflection.h>
 #include <google/protobuf/unknown_field_set.h>
 // @@protoc_insertion_point(includes)
-#define PROTOBUF_INTERNAL_EXPORT_protobuf_peer_2dmessage_2eproto 
+#include <google/protobuf/port_def.inc>
+#define PROTOBUF_INTERNAL_EXPORT_peer_2dmessage_2eproto
+PROTOBUF_NAMESPACE_OPEN
+namespace internal {
+class AnyMetadata;
+}  // namespace internal
+PROTOBUF_NAMESPACE_CLOSE
 
-namespace protobuf_peer_2dmessage_2eproto {
 // Internal implementation detail -- do not use these members.
-struct TableStruct {
-  static const ::google::protobuf::internal::ParseTableField entries[];
-  static const ::google::protobuf::internal::AuxillaryParseTableField aux[];
-  static const ::google::protobuf::internal::ParseTable schema[1];
-  static const ::google::protobuf::internal::FieldMetadata field_metadata[];
-  static const ::google::protobuf::internal::SerializationTable serialization_table[];
-  static const ::google::protobuf::uint32 offsets[];
+struct TableStruct_peer_2dmessage_2eproto {
+  static const uint32_t offsets[];
 };
-void AddDescriptors();
-}  // namespace protobuf_peer_2dmessage_2eproto
+extern const ::PROTOBUF_NAMESPACE_ID::internal::DescriptorTable descriptor_table_peer_2dmessage_2eproto;
 namespace proto {
 class PeerMessage;
-class PeerMessageDefaultTypeInternal;
+struct PeerMessageDefaultTypeInternal;
 extern PeerMessageDefaultTypeInternal _PeerMessage_default_instance_;
 }  // namespace proto
-namespace google {
-namespace protobuf {
+PROTOBUF_NAMESPACE_OPEN
 template<> ::proto::PeerMessage* Arena::CreateMaybeMessage<::proto::PeerMessage>(Arena*);
-}  // namespace protobuf
-}  // namespace google
+PROTOBUF_NAMESPACE_CLOSE
 namespace proto {
 
-enum PeerMessage_Type {
+enum PeerMessage_Type : int {
   PeerMessage_Type_APPENDENTRIES_REQUEST = 0,
   PeerMessage_Type_APPENDENTRIES_RESPONSE = 1,
   PeerMessage_Type_REQUESTVOTE_REQUEST = 2,
-  PeerMessage_Type_REQUESTVOTE_RESPONSE = 3
+  PeerMessage_Type_REQUESTVOTE_RESPONSE = 3,
+  PeerMessage_Type_INSTALLSNAPSHOT_REQUEST = 4,
+  PeerMessage_Type_INSTALLSNAPSHOT_RESPONSE = 5
 };
 bool PeerMessage_Type_IsValid(int value);
-const PeerMessage_Type PeerMessage_Type_Type_MIN = PeerMessage_Type_APPENDENTRIES_REQUEST;
-const PeerMessage_Type PeerMessage_Type_Type_MAX = PeerMessage_Type_REQUESTVOTE_RESPONSE;
-const int PeerMessage_Type_Type_ARRAYSIZE = PeerMessage_Type_Type_MAX + 1;
+constexpr PeerMessage_Type PeerMessage_Type_Type_MIN = PeerMessage_Type_APPENDENTRIES_REQUEST;
+constexpr PeerMessage_Type PeerMessage_Type_Type_MAX = PeerMessage_Type_INSTALLSNAPSHOT_RESPONSE;
+constexpr int PeerMessage_Type_Type_ARRAYSIZE = PeerMessage_Type_Type_MAX + 1;
 
-const ::google::protobuf::EnumDescriptor* PeerMessage_Type_descriptor();
-inline const ::std::string& PeerMessage_Type_Name(PeerMessage_Type value) {
-  return ::google::protobuf::internal::NameOfEnum(
-    PeerMessage_Type_descriptor(), value);
+const ::PROTOBUF_NAMESPACE_ID::EnumDescriptor* PeerMessage_Type_descriptor();
+template<typename T>
+inline const std::string& PeerMessage_Type_Name(T enum_t_value) {
+  static_assert(::std::is_same<T, PeerMessage_Type>::value ||
+    ::std::is_integral<T>::value,
+    "Incorrect type passed to function PeerMessage_Type_Name.");
+  return ::PROTOBUF_NAMESPACE_ID::internal::NameOfEnum(
+    PeerMessage_Type_descriptor(), enum_t_value);
 }
 inline bool PeerMessage_Type_Parse(
-    const ::std::string& name, PeerMessage_Type* value) {
-  return ::google::protobuf::internal::ParseNamedEnum<PeerMessage_Type>(
+    ::PROTOBUF_NAMESPACE_ID::ConstStringParam name, PeerMessage_Type* value) {
+  return ::PROTOBUF_NAMESPACE_ID::internal::ParseNamedEnum<PeerMessage_Type>(
     PeerMessage_Type_descriptor(), name, value);
 }
 // ===================================================================
 
-class PeerMessage : public ::google::protobuf::Message /* @@protoc_insertion_point(class_definition:proto.PeerMessage) */ {
+class PeerMessage final :
+    public ::PROTOBUF_NAMESPACE_ID::Message /* @@protoc_insertion_point(class_definition:proto.PeerMessage) */ {
  public:
-  PeerMessage();
-  virtual ~PeerMessage();
+  inline PeerMessage() : PeerMessage(nullptr) {}
+  ~PeerMessage() override;
+  explicit PROTOBUF_CONSTEXPR PeerMessage(::PROTOBUF_NAMESPACE_ID::internal::ConstantInitialized);
 
   PeerMessage(const PeerMessage& from);
-
-  inline PeerMessage& operator=(const PeerMessage& from) {
-    CopyFrom(from);
-    return *this;
-  }
-  #if LANG_CXX11
   PeerMessage(PeerMessage&& from) noexcept
     : PeerMessage() {
     *this = ::std::move(from);
   }
 
+  inline PeerMessage& operator=(const PeerMessage& from) {
+    CopyFrom(from);
+    return *this;
+  }
   inline PeerMessage& operator=(PeerMessage&& from) noexcept {
-    if (GetArenaNoVirtual() == from.GetArenaNoVirtual()) {
-      if (this != &from) InternalSwap(&from);
+    if (this == &from) return *this;
+    if (GetOwningArena() == from.GetOwningArena()
+  #ifdef PROTOBUF_FORCE_COPY_IN_MOVE
+        && GetOwningArena() != nullptr
+  #endif  // !PROTOBUF_FORCE_COPY_IN_MOVE
+    ) {
+      InternalSwap(&from);
     } else {
       CopyFrom(from);
     }
     return *this;
   }
-  #endif
-  inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
-    return _internal_metadata_.unknown_fields();
+
+  inline const ::PROTOBUF_NAMESPACE_ID::UnknownFieldSet& unknown_fields() const {
+    return _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance);
   }
-  inline ::google::protobuf::UnknownFieldSet* mutable_unknown_fields() {
-    return _internal_metadata_.mutable_unknown_fields();
+  inline ::PROTOBUF_NAMESPACE_ID::UnknownFieldSet* mutable_unknown_fields() {
+    return _internal_metadata_.mutable_unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>();
   }
 
-  static const ::google::protobuf::Descriptor* descriptor();
-  static const PeerMessage& default_instance();
-
-  static void InitAsDefaultInstance();  // FOR INTERNAL USE ONLY
+  static const ::PROTOBUF_NAMESPACE_ID::Descriptor* descriptor() {
+    return GetDescriptor();
+  }
+  static const ::PROTOBUF_NAMESPACE_ID::Descriptor* GetDescriptor() {
+    return default_instance().GetMetadata().descriptor;
+  }
+  static const ::PROTOBUF_NAMESPACE_ID::Reflection* GetReflection() {
+    return default_instance().GetMetadata().reflection;
+  }
+  static const PeerMessage& default_instance() {
+    return *internal_default_instance();
+  }
   static inline const PeerMessage* internal_default_instance() {
     return reinterpret_cast<const PeerMessage*>(
                &_PeerMessage_default_instance_);
@@ -125,229 +141,448 @@ class PeerMessage : public ::google::protobuf::Message /* @@protoc_insertion_poi
   static constexpr int kIndexInFileMessages =
     0;
 
-  void Swap(PeerMessage* other);
   friend void swap(PeerMessage& a, PeerMessage& b) {
     a.Swap(&b);
   }
+  inline void Swap(PeerMessage* other) {
+    if (other == this) return;
+  #ifdef PROTOBUF_FORCE_COPY_IN_SWAP
+    if (GetOwningArena() != nullptr &&
+        GetOwningArena() == other->GetOwningArena()) {
+   #else  // PROTOBUF_FORCE_COPY_IN_SWAP
+    if (GetOwningArena() == other->GetOwningArena()) {
+  #endif  // !PROTOBUF_FORCE_COPY_IN_SWAP
+      InternalSwap(other);
+    } else {
+      ::PROTOBUF_NAMESPACE_ID::internal::GenericSwap(this, other);
+    }
+  }
+  void UnsafeArenaSwap(PeerMessage* other) {
+    if (other == this) return;
+    GOOGLE_DCHECK(GetOwningArena() == other->GetOwningArena());
+    InternalSwap(other);
+  }
 
   // implements Message ----------------------------------------------
 
-  inline PeerMessage* New() const final {
-    return CreateMaybeMessage<PeerMessage>(NULL);
-  }
-
-  PeerMessage* New(::google::protobuf::Arena* arena) const final {
+  PeerMessage* New(::PROTOBUF_NAMESPACE_ID::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<PeerMessage>(arena);
   }
-  void CopyFrom(const ::google::protobuf::Message& from) final;
-  void MergeFrom(const ::google::protobuf::Message& from) final;
+  using ::PROTOBUF_NAMESPACE_ID::Message::CopyFrom;
   void CopyFrom(const PeerMessage& from);
-  void MergeFrom(const PeerMessage& from);
-  void Clear() final;
+  using ::PROTOBUF_NAMESPACE_ID::Message::MergeFrom;
+  void MergeFrom( const PeerMessage& from) {
+    PeerMessage::MergeImpl(*this, from);
+  }
+  private:
+  static void MergeImpl(::PROTOBUF_NAMESPACE_ID::Message& to_msg, const ::PROTOBUF_NAMESPACE_ID::Message& from_msg);
+  public:
+  PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
   bool IsInitialized() const final;
 
   size_t ByteSizeLong() const final;
-  bool MergePartialFromCodedStream(
-      ::google::protobuf::io::CodedInputStream* input) final;
-  void SerializeWithCachedSizes(
-      ::google::protobuf::io::CodedOutputStream* output) const final;
-  ::google::protobuf::uint8* InternalSerializeWithCachedSizesToArray(
-      bool deterministic, ::google::protobuf::uint8* target) const final;
-  int GetCachedSize() const final { return _cached_size_.Get(); }
+  const char* _InternalParse(const char* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ParseContext* ctx) final;
+  uint8_t* _InternalSerialize(
+      uint8_t* target, ::PROTOBUF_NAMESPACE_ID::io::EpsCopyOutputStream* stream) const final;
+  int GetCachedSize() const final { return _impl_._cached_size_.Get(); }
 
   private:
-  void SharedCtor();
+  void SharedCtor(::PROTOBUF_NAMESPACE_ID::Arena* arena, bool is_message_owned);
   void SharedDtor();
   void SetCachedSize(int size) const final;
   void InternalSwap(PeerMessage* other);
+
   private:
-  inline ::google::protobuf::Arena* GetArenaNoVirtual() const {
-    return NULL;
-  }
-  inline void* MaybeArenaPtr() const {
-    return NULL;
+  friend class ::PROTOBUF_NAMESPACE_ID::internal::AnyMetadata;
+  static ::PROTOBUF_NAMESPACE_ID::StringPiece FullMessageName() {
+    return "proto.PeerMessage";
   }
+  protected:
+  explicit PeerMessage(::PROTOBUF_NAMESPACE_ID::Arena* arena,
+                       bool is_message_owned = false);
   public:
 
-  ::google::protobuf::Metadata GetMetadata() const final;
+  static const ClassData _class_data_;
+  const ::PROTOBUF_NAMESPACE_ID::Message::ClassData*GetClassData() const final;
+
+  ::PROTOBUF_NAMESPACE_ID::Metadata GetMetadata() const final;
 
   // nested types ----------------------------------------------------
 
   typedef PeerMessage_Type Type;
-  static const Type APPENDENTRIES_REQUEST =
+  static constexpr Type APPENDENTRIES_REQUEST =
     PeerMessage_Type_APPENDENTRIES_REQUEST;
-  static const Type APPENDENTRIES_RESPONSE =
+  static constexpr Type APPENDENTRIES_RESPONSE =
     PeerMessage_Type_APPENDENTRIES_RESPONSE;
-  static const Type REQUESTVOTE_REQUEST =
+  static constexpr Type REQUESTVOTE_REQUEST =
     PeerMessage_Type_REQUESTVOTE_REQUEST;
-  static const Type REQUESTVOTE_RESPONSE =
+  static constexpr Type REQUESTVOTE_RESPONSE =
     PeerMessage_Type_REQUESTVOTE_RESPONSE;
+  static constexpr Type INSTALLSNAPSHOT_REQUEST =
+    PeerMessage_Type_INSTALLSNAPSHOT_REQUEST;
+  static constexpr Type INSTALLSNAPSHOT_RESPONSE =
+    PeerMessage_Type_INSTALLSNAPSHOT_RESPONSE;
   static inline bool Type_IsValid(int value) {
     return PeerMessage_Type_IsValid(value);
   }
-  static const Type Type_MIN =
+  static constexpr Type Type_MIN =
     PeerMessage_Type_Type_MIN;
-  static const Type Type_MAX =
+  static constexpr Type Type_MAX =
     PeerMessage_Type_Type_MAX;
-  static const int Type_ARRAYSIZE =
+  static constexpr int Type_ARRAYSIZE =
     PeerMessage_Type_Type_ARRAYSIZE;
-  static inline const ::google::protobuf::EnumDescriptor*
+  static inline const ::PROTOBUF_NAMESPACE_ID::EnumDescriptor*
   Type_descriptor() {
     return PeerMessage_Type_descriptor();
   }
-  static inline const ::std::string& Type_Name(Type value) {
-    return PeerMessage_Type_Name(value);
+  template<typename T>
+  static inline const std::string& Type_Name(T enum_t_value) {
+    static_assert(::std::is_same<T, Type>::value ||
+      ::std::is_integral<T>::value,
+      "Incorrect type passed to function Type_Name.");
+    return PeerMessage_Type_Name(enum_t_value);
   }
-  static inline bool Type_Parse(const ::std::string& name,
+  static inline bool Type_Parse(::PROTOBUF_NAMESPACE_ID::ConstStringParam name,
       Type* value) {
     return PeerMessage_Type_Parse(name, value);
   }
 
   // accessors -------------------------------------------------------
 
+  enum : int {
+    kEntriesFieldNumber = 6,
+    kDataFieldNumber = 16,
+    kTypeFieldNumber = 1,
+    kTermFieldNumber = 2,
+    kServerIdFieldNumber = 3,
+    kPrevLogIndexFieldNumber = 4,
+    kPrevLogTermFieldNumber = 5,
+    kLeaderCommitFieldNumber = 7,
+    kAppendedLogIndexFieldNumber = 9,
+    kLastLogIndexFieldNumber = 10,
+    kLastLogTermFieldNumber = 11,
+    kLastIncludedIndexFieldNumber = 13,
+    kAcceptsFramesFieldNumber = 18,
+    kSuccessFieldNumber = 8,
+    kVoteGrantedFieldNumber = 12,
+    kDoneFieldNumber = 17,
+    kLastIncludedTermFieldNumber = 14,
+    kOffsetFieldNumber = 15,
+    kConflictFirstIndexFieldNumber = 20,
+    kConflictTermFieldNumber = 19,
+  };
   // repeated string entries = 6;
   int entries_size() const;
+  private:
+  int _internal_entries_size() const;
+  public:
   void clear_entries();
-  static const int kEntriesFieldNumber = 6;
-  const ::std::string& entries(int index) const;
-  ::std::string* mutable_entries(int index);
-  void set_entries(int index, const ::std::string& value);
-  #if LANG_CXX11
-  void set_entries(int index, ::std::string&& value);
-  #endif
+  const std::string& entries(int index) const;
+  std::string* mutable_entries(int index);
+  void set_entries(int index, const std::string& value);
+  void set_entries(int index, std::string&& value);
   void set_entries(int index, const char* value);
   void set_entries(int index, const char* value, size_t size);
-  ::std::string* add_entries();
-  void add_entries(const ::std::string& value);
-  #if LANG_CXX11
-  void add_entries(::std::string&& value);
-  #endif
+  std::string* add_entries();
+  void add_entries(const std::string& value);
+  void add_entries(std::string&& value);
   void add_entries(const char* value);
   void add_entries(const char* value, size_t size);
-  const ::google::protobuf::RepeatedPtrField< ::std::string>& entries() const;
-  ::google::protobuf::RepeatedPtrField< ::std::string>* mutable_entries();
+  const ::PROTOBUF_NAMESPACE_ID::RepeatedPtrField<std::string>& entries() const;
+  ::PROTOBUF_NAMESPACE_ID::RepeatedPtrField<std::string>* mutable_entries();
+  private:
+  const std::string& _internal_entries(int index) const;
+  std::string* _internal_add_entries();
+  public:
+
+  // optional bytes data = 16;
+  bool has_data() const;
+  private:
+  bool _internal_has_data() const;
+  public:
+  void clear_data();
+  const std::string& data() const;
+  template <typename ArgT0 = const std::string&, typename... ArgT>
+  void set_data(ArgT0&& arg0, ArgT... args);
+  std::string* mutable_data();
+  PROTOBUF_NODISCARD std::string* release_data();
+  void set_allocated_data(std::string* data);
+  private:
+  const std::string& _internal_data() const;
+  inline PROTOBUF_ALWAYS_INLINE void _internal_set_data(const std::string& value);
+  std::string* _internal_mutable_data();
+  public:
 
   // required .proto.PeerMessage.Type type = 1;
   bool has_type() const;
+  private:
+  bool _internal_has_type() const;
+  public:
   void clear_type();
-  static const int kTypeFieldNumber = 1;
   ::proto::PeerMessage_Type type() const;
   void set_type(::proto::PeerMessage_Type value);
+  private:
+  ::proto::PeerMessage_Type _internal_type() const;
+  void _internal_set_type(::proto::PeerMessage_Type value);
+  public:
 
   // required int32 term = 2;
   bool has_term() const;
+  private:
+  bool _internal_has_term() const;
+  public:
   void clear_term();
-  static const int kTermFieldNumber = 2;
-  ::google::protobuf::int32 term() const;
-  void set_term(::google::protobuf::int32 value);
+  int32_t term() const;
+  void set_term(int32_t value);
+  private:
+  int32_t _internal_term() const;
+  void _internal_set_term(int32_t value);
+  public:
 
   // required int32 server_id = 3;
   bool has_server_id() const;
+  private:
+  bool _internal_has_server_id() const;
+  public:
   void clear_server_id();
-  static const int kServerIdFieldNumber = 3;
-  ::google::protobuf::int32 server_id() const;
-  void set_server_id(::google::protobuf::int32 value);
+  int32_t server_id() const;
+  void set_server_id(int32_t value);
+  private:
+  int32_t _internal_server_id() const;
+  void _internal_set_server_id(int32_t value);
+  public:
 
   // optional int32 prev_log_index = 4;
   bool has_prev_log_index() const;
+  private:
+  bool _internal_has_prev_log_index() const;
+  public:
   void clear_prev_log_index();
-  static const int kPrevLogIndexFieldNumber = 4;
-  ::google::protobuf::int32 prev_log_index() const;
-  void set_prev_log_index(::google::protobuf::int32 value);
+  int32_t prev_log_index() const;
+  void set_prev_log_index(int32_t value);
+  private:
+  int32_t _internal_prev_log_index() const;
+  void _internal_set_prev_log_index(int32_t value);
+  public:
 
   // optional int32 prev_log_term = 5;
   bool has_prev_log_term() const;
+  private:
+  bool _internal_has_prev_log_term() const;
+  public:
   void clear_prev_log_term();
-  static const int kPrevLogTermFieldNumber = 5;
-  ::google::protobuf::int32 prev_log_term() const;
-  void set_prev_log_term(::google::protobuf::int32 value);
+  int32_t prev_log_term() const;
+  void set_prev_log_term(int32_t value);
+  private:
+  int32_t _internal_prev_log_term() const;
+  void _internal_set_prev_log_term(int32_t value);
+  public:
 
   // optional int32 leader_commit = 7;
   bool has_leader_commit() const;
+  private:
+  bool _internal_has_leader_commit() const;
+  public:
   void clear_leader_commit();
-  static const int kLeaderCommitFieldNumber = 7;
-  ::google::protobuf::int32 leader_commit() const;
-  void set_leader_commit(::google::protobuf::int32 value);
+  int32_t leader_commit() const;
+  void set_leader_commit(int32_t value);
+  private:
+  int32_t _internal_leader_commit() const;
+  void _internal_set_leader_commit(int32_t value);
+  public:
 
   // optional int32 appended_log_index = 9;
   bool has_appended_log_index() const;
+  private:
+  bool _internal_has_appended_log_index() const;
+  public:
   void clear_appended_log_index();
-  static const int kAppendedLogIndexFieldNumber = 9;
-  ::google::protobuf::int32 appended_log_index() const;
-  void set_appended_log_index(::google::protobuf::int32 value);
+  int32_t appended_log_index() const;
+  void set_appended_log_index(int32_t value);
+  private:
+  int32_t _internal_appended_log_index() const;
+  void _internal_set_appended_log_index(int32_t value);
+  public:
 
   // optional int32 last_log_index = 10;
   bool has_last_log_index() const;
+  private:
+  bool _internal_has_last_log_index() const;
+  public:
   void clear_last_log_index();
-  static const int kLastLogIndexFieldNumber = 10;
-  ::google::protobuf::int32 last_log_index() const;
-  void set_last_log_index(::google::protobuf::int32 value);
+  int32_t last_log_index() const;
+  void set_last_log_index(int32_t value);
+  private:
+  int32_t _internal_last_log_index() const;
+  void _internal_set_last_log_index(int32_t value);
+  public:
+
+  // optional int32 last_log_term = 11;
+  bool has_last_log_term() const;
+  private:
+  bool _internal_has_last_log_term() const;
+  public:
+  void clear_last_log_term();
+  int32_t last_log_term() const;
+  void set_last_log_term(int32_t value);
+  private:
+  int32_t _internal_last_log_term() const;
+  void _internal_set_last_log_term(int32_t value);
+  public:
+
+  // optional int32 last_included_index = 13;
+  bool has_last_included_index() const;
+  private:
+  bool _internal_has_last_included_index() const;
+  public:
+  void clear_last_included_index();
+  int32_t last_included_index() const;
+  void set_last_included_index(int32_t value);
+  private:
+  int32_t _internal_last_included_index() const;
+  void _internal_set_last_included_index(int32_t value);
+  public:
+
+  // optional bool accepts_frames = 18;
+  bool has_accepts_frames() const;
+  private:
+  bool _internal_has_accepts_frames() const;
+  public:
+  void clear_accepts_frames();
+  bool accepts_frames() const;
+  void set_accepts_frames(bool value);
+  private:
+  bool _internal_accepts_frames() const;
+  void _internal_set_accepts_frames(bool value);
+  public:
 
   // optional bool success = 8;
   bool has_success() const;
+  private:
+  bool _internal_has_success() const;
+  public:
   void clear_success();
-  static const int kSuccessFieldNumber = 8;
   bool success() const;
   void set_success(bool value);
+  private:
+  bool _internal_success() const;
+  void _internal_set_success(bool value);
+  public:
 
   // optional bool vote_granted = 12;
   bool has_vote_granted() const;
+  private:
+  bool _internal_has_vote_granted() const;
+  public:
   void clear_vote_granted();
-  static const int kVoteGrantedFieldNumber = 12;
   bool vote_granted() const;
   void set_vote_granted(bool value);
+  private:
+  bool _internal_vote_granted() const;
+  void _internal_set_vote_granted(bool value);
+  public:
 
-  // optional int32 last_log_term = 11;
-  bool has_last_log_term() const;
-  void clear_last_log_term();
-  static const int kLastLogTermFieldNumber = 11;
-  ::google::protobuf::int32 last_log_term() const;
-  void set_last_log_term(::google::protobuf::int32 value);
+  // optional bool done = 17;
+  bool has_done() const;
+  private:
+  bool _internal_has_done() const;
+  public:
+  void clear_done();
+  bool done() const;
+  void set_done(bool value);
+  private:
+  bool _internal_done() const;
+  void _internal_set_done(bool value);
+  public:
+
+  // optional int32 last_included_term = 14;
+  bool has_last_included_term() const;
+  private:
+  bool _internal_has_last_included_term() const;
+  public:
+  void clear_last_included_term();
+  int32_t last_included_term() const;
+  void set_last_included_term(int32_t value);
+  private:
+  int32_t _internal_last_included_term() const;
+  void _internal_set_last_included_term(int32_t value);
+  public:
+
+  // optional int64 offset = 15;
+  bool has_offset() const;
+  private:
+  bool _internal_has_offset() const;
+  public:
+  void clear_offset();
+  int64_t offset() const;
+  void set_offset(int64_t value);
+  private:
+  int64_t _internal_offset() const;
+  void _internal_set_offset(int64_t value);
+  public:
+
+  // optional int32 conflict_first_index = 20;
+  bool has_conflict_first_index() const;
+  private:
+  bool _internal_has_conflict_first_index() const;
+  public:
+  void clear_conflict_first_index();
+  int32_t conflict_first_index() const;
+  void set_conflict_first_index(int32_t value);
+  private:
+  int32_t _internal_conflict_first_index() const;
+  void _internal_set_conflict_first_index(int32_t value);
+  public:
+
+  // optional int32 conflict_term = 19 [default = -1];
+  bool has_conflict_term() const;
+  private:
+  bool _internal_has_conflict_term() const;
+  public:
+  void clear_conflict_term();
+  int32_t conflict_term() const;
+  void set_conflict_term(int32_t value);
+  private:
+  int32_t _internal_conflict_term() const;
+  void _internal_set_conflict_term(int32_t value);
+  public:
 
   // @@protoc_insertion_point(class_scope:proto.PeerMessage)
  private:
-  void set_has_type();
-  void clear_has_type();
-  void set_has_term();
-  void clear_has_term();
-  void set_has_server_id();
-  void clear_has_server_id();
-  void set_has_prev_log_index();
-  void clear_has_prev_log_index();
-  void set_has_prev_log_term();
-  void clear_has_prev_log_term();
-  void set_has_leader_commit();
-  void clear_has_leader_commit();
-  void set_has_success();
-  void clear_has_success();
-  void set_has_appended_log_index();
-  void clear_has_appended_log_index();
-  void set_has_last_log_index();
-  void clear_has_last_log_index();
-  void set_has_last_log_term();
-  void clear_has_last_log_term();
-  void set_has_vote_granted();
-  void clear_has_vote_granted();
+  class _Internal;
 
   // helper for ByteSizeLong()
   size_t RequiredFieldsByteSizeFallback() const;
 
-  ::google::protobuf::internal::InternalMetadataWithArena _internal_metadata_;
-  ::google::protobuf::internal::HasBits<1> _has_bits_;
-  mutable ::google::protobuf::internal::CachedSize _cached_size_;
-  ::google::protobuf::RepeatedPtrField< ::std::string> entries_;
-  int type_;
-  ::google::protobuf::int32 term_;
-  ::google::protobuf::int32 server_id_;
-  ::google::protobuf::int32 prev_log_index_;
-  ::google::protobuf::int32 prev_log_term_;
-  ::google::protobuf::int32 leader_commit_;
-  ::google::protobuf::int32 appended_log_index_;
-  ::google::protobuf::int32 last_log_index_;
-  bool success_;
-  bool vote_granted_;
-  ::google::protobuf::int32 last_log_term_;
-  friend struct ::protobuf_peer_2dmessage_2eproto::TableStruct;
+  template <typename T> friend class ::PROTOBUF_NAMESPACE_ID::Arena::InternalHelper;
+  typedef void InternalArenaConstructable_;
+  typedef void DestructorSkippable_;
+  struct Impl_ {
+    ::PROTOBUF_NAMESPACE_ID::internal::HasBits<1> _has_bits_;
+    mutable ::PROTOBUF_NAMESPACE_ID::internal::CachedSize _cached_size_;
+    ::PROTOBUF_NAMESPACE_ID::RepeatedPtrField<std::string> entries_;
+    ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr data_;
+    int type_;
+    int32_t term_;
+    int32_t server_id_;
+    int32_t prev_log_index_;
+    int32_t prev_log_term_;
+    int32_t leader_commit_;
+    int32_t appended_log_index_;
+    int32_t last_log_index_;
+    int32_t last_log_term_;
+    int32_t last_included_index_;
+    bool accepts_frames_;
+    bool success_;
+    bool vote_granted_;
+    bool done_;
+    int32_t last_included_term_;
+    int64_t offset_;
+    int32_t conflict_first_index_;
+    int32_t conflict_term_;
+  };
+  union { Impl_ _impl_; };
+  friend struct ::TableStruct_peer_2dmessage_2eproto;
 };
 // ===================================================================
 
@@ -361,339 +596,653 @@ class PeerMessage : public ::google::protobuf::Message /* @@protoc_insertion_poi
 // PeerMessage
 
 // required .proto.PeerMessage.Type type = 1;
-inline bool PeerMessage::has_type() const {
-  return (_has_bits_[0] & 0x00000001u) != 0;
-}
-inline void PeerMessage::set_has_type() {
-  _has_bits_[0] |= 0x00000001u;
+inline bool PeerMessage::_internal_has_type() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000002u) != 0;
+  return value;
 }
-inline void PeerMessage::clear_has_type() {
-  _has_bits_[0] &= ~0x00000001u;
+inline bool PeerMessage::has_type() const {
+  return _internal_has_type();
 }
 inline void PeerMessage::clear_type() {
-  type_ = 0;
-  clear_has_type();
+  _impl_.type_ = 0;
+  _impl_._has_bits_[0] &= ~0x00000002u;
+}
+inline ::proto::PeerMessage_Type PeerMessage::_internal_type() const {
+  return static_cast< ::proto::PeerMessage_Type >(_impl_.type_);
 }
 inline ::proto::PeerMessage_Type PeerMessage::type() const {
   // @@protoc_insertion_point(field_get:proto.PeerMessage.type)
-  return static_cast< ::proto::PeerMessage_Type >(type_);
+  return _internal_type();
 }
-inline void PeerMessage::set_type(::proto::PeerMessage_Type value) {
+inline void PeerMessage::_internal_set_type(::proto::PeerMessage_Type value) {
   assert(::proto::PeerMessage_Type_IsValid(value));
-  set_has_type();
-  type_ = value;
+  _impl_._has_bits_[0] |= 0x00000002u;
+  _impl_.type_ = value;
+}
+inline void PeerMessage::set_type(::proto::PeerMessage_Type value) {
+  _internal_set_type(value);
   // @@protoc_insertion_point(field_set:proto.PeerMessage.type)
 }
 
 // required int32 term = 2;
-inline bool PeerMessage::has_term() const {
-  return (_has_bits_[0] & 0x00000002u) != 0;
+inline bool PeerMessage::_internal_has_term() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000004u) != 0;
+  return value;
 }
-inline void PeerMessage::set_has_term() {
-  _has_bits_[0] |= 0x00000002u;
-}
-inline void PeerMessage::clear_has_term() {
-  _has_bits_[0] &= ~0x00000002u;
+inline bool PeerMessage::has_term() const {
+  return _internal_has_term();
 }
 inline void PeerMessage::clear_term() {
-  term_ = 0;
-  clear_has_term();
+  _impl_.term_ = 0;
+  _impl_._has_bits_[0] &= ~0x00000004u;
 }
-inline ::google::protobuf::int32 PeerMessage::term() const {
+inline int32_t PeerMessage::_internal_term() const {
+  return _impl_.term_;
+}
+inline int32_t PeerMessage::term() const {
   // @@protoc_insertion_point(field_get:proto.PeerMessage.term)
-  return term_;
+  return _internal_term();
+}
+inline void PeerMessage::_internal_set_term(int32_t value) {
+  _impl_._has_bits_[0] |= 0x00000004u;
+  _impl_.term_ = value;
 }
-inline void PeerMessage::set_term(::google::protobuf::int32 value) {
-  set_has_term();
-  term_ = value;
+inline void PeerMessage::set_term(int32_t value) {
+  _internal_set_term(value);
   // @@protoc_insertion_point(field_set:proto.PeerMessage.term)
 }
 
 // required int32 server_id = 3;
-inline bool PeerMessage::has_server_id() const {
-  return (_has_bits_[0] & 0x00000004u) != 0;
-}
-inline void PeerMessage::set_has_server_id() {
-  _has_bits_[0] |= 0x00000004u;
+inline bool PeerMessage::_internal_has_server_id() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000008u) != 0;
+  return value;
 }
-inline void PeerMessage::clear_has_server_id() {
-  _has_bits_[0] &= ~0x00000004u;
+inline bool PeerMessage::has_server_id() const {
+  return _internal_has_server_id();
 }
 inline void PeerMessage::clear_server_id() {
-  server_id_ = 0;
-  clear_has_server_id();
+  _impl_.server_id_ = 0;
+  _impl_._has_bits_[0] &= ~0x00000008u;
+}
+inline int32_t PeerMessage::_internal_server_id() const {
+  return _impl_.server_id_;
 }
-inline ::google::protobuf::int32 PeerMessage::server_id() const {
+inline int32_t PeerMessage::server_id() const {
   // @@protoc_insertion_point(field_get:proto.PeerMessage.server_id)
-  return server_id_;
+  return _internal_server_id();
 }
-inline void PeerMessage::set_server_id(::google::protobuf::int32 value) {
-  set_has_server_id();
-  server_id_ = value;
+inline void PeerMessage::_internal_set_server_id(int32_t value) {
+  _impl_._has_bits_[0] |= 0x00000008u;
+  _impl_.server_id_ = value;
+}
+inline void PeerMessage::set_server_id(int32_t value) {
+  _internal_set_server_id(value);
   // @@protoc_insertion_point(field_set:proto.PeerMessage.server_id)
 }
 
-// optional int32 prev_log_index = 4;
-inline bool PeerMessage::has_prev_log_index() const {
-  return (_has_bits_[0] & 0x00000008u) != 0;
+// optional bool accepts_frames = 18;
+inline bool PeerMessage::_internal_has_accepts_frames() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000800u) != 0;
+  return value;
+}
+inline bool PeerMessage::has_accepts_frames() const {
+  return _internal_has_accepts_frames();
+}
+inline void PeerMessage::clear_accepts_frames() {
+  _impl_.accepts_frames_ = false;
+  _impl_._has_bits_[0] &= ~0x00000800u;
+}
+inline bool PeerMessage::_internal_accepts_frames() const {
+  return _impl_.accepts_frames_;
 }
-inline void PeerMessage::set_has_prev_log_index() {
-  _has_bits_[0] |= 0x00000008u;
+inline bool PeerMessage::accepts_frames() const {
+  // @@protoc_insertion_point(field_get:proto.PeerMessage.accepts_frames)
+  return _internal_accepts_frames();
 }
-inline void PeerMessage::clear_has_prev_log_index() {
-  _has_bits_[0] &= ~0x00000008u;
+inline void PeerMessage::_internal_set_accepts_frames(bool value) {
+  _impl_._has_bits_[0] |= 0x00000800u;
+  _impl_.accepts_frames_ = value;
+}
+inline void PeerMessage::set_accepts_frames(bool value) {
+  _internal_set_accepts_frames(value);
+  // @@protoc_insertion_point(field_set:proto.PeerMessage.accepts_frames)
+}
+
+// optional int32 prev_log_index = 4;
+inline bool PeerMessage::_internal_has_prev_log_index() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000010u) != 0;
+  return value;
+}
+inline bool PeerMessage::has_prev_log_index() const {
+  return _internal_has_prev_log_index();
 }
 inline void PeerMessage::clear_prev_log_index() {
-  prev_log_index_ = 0;
-  clear_has_prev_log_index();
+  _impl_.prev_log_index_ = 0;
+  _impl_._has_bits_[0] &= ~0x00000010u;
 }
-inline ::google::protobuf::int32 PeerMessage::prev_log_index() const {
+inline int32_t PeerMessage::_internal_prev_log_index() const {
+  return _impl_.prev_log_index_;
+}
+inline int32_t PeerMessage::prev_log_index() const {
   // @@protoc_insertion_point(field_get:proto.PeerMessage.prev_log_index)
-  return prev_log_index_;
+  return _internal_prev_log_index();
+}
+inline void PeerMessage::_internal_set_prev_log_index(int32_t value) {
+  _impl_._has_bits_[0] |= 0x00000010u;
+  _impl_.prev_log_index_ = value;
 }
-inline void PeerMessage::set_prev_log_index(::google::protobuf::int32 value) {
-  set_has_prev_log_index();
-  prev_log_index_ = value;
+inline void PeerMessage::set_prev_log_index(int32_t value) {
+  _internal_set_prev_log_index(value);
   // @@protoc_insertion_point(field_set:proto.PeerMessage.prev_log_index)
 }
 
 // optional int32 prev_log_term = 5;
-inline bool PeerMessage::has_prev_log_term() const {
-  return (_has_bits_[0] & 0x00000010u) != 0;
-}
-inline void PeerMessage::set_has_prev_log_term() {
-  _has_bits_[0] |= 0x00000010u;
+inline bool PeerMessage::_internal_has_prev_log_term() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000020u) != 0;
+  return value;
 }
-inline void PeerMessage::clear_has_prev_log_term() {
-  _has_bits_[0] &= ~0x00000010u;
+inline bool PeerMessage::has_prev_log_term() const {
+  return _internal_has_prev_log_term();
 }
 inline void PeerMessage::clear_prev_log_term() {
-  prev_log_term_ = 0;
-  clear_has_prev_log_term();
+  _impl_.prev_log_term_ = 0;
+  _impl_._has_bits_[0] &= ~0x00000020u;
 }
-inline ::google::protobuf::int32 PeerMessage::prev_log_term() const {
+inline int32_t PeerMessage::_internal_prev_log_term() const {
+  return _impl_.prev_log_term_;
+}
+inline int32_t PeerMessage::prev_log_term() const {
   // @@protoc_insertion_point(field_get:proto.PeerMessage.prev_log_term)
-  return prev_log_term_;
+  return _internal_prev_log_term();
+}
+inline void PeerMessage::_internal_set_prev_log_term(int32_t value) {
+  _impl_._has_bits_[0] |= 0x00000020u;
+  _impl_.prev_log_term_ = value;
 }
-inline void PeerMessage::set_prev_log_term(::google::protobuf::int32 value) {
-  set_has_prev_log_term();
-  prev_log_term_ = value;
+inline void PeerMessage::set_prev_log_term(int32_t value) {
+  _internal_set_prev_log_term(value);
   // @@protoc_insertion_point(field_set:proto.PeerMessage.prev_log_term)
 }
 
 // repeated string entries = 6;
+inline int PeerMessage::_internal_entries_size() const {
+  return _impl_.entries_.size();
+}
 inline int PeerMessage::entries_size() const {
-  return entries_.size();
+  return _internal_entries_size();
 }
 inline void PeerMessage::clear_entries() {
-  entries_.Clear();
+  _impl_.entries_.Clear();
+}
+inline std::string* PeerMessage::add_entries() {
+  std::string* _s = _internal_add_entries();
+  // @@protoc_insertion_point(field_add_mutable:proto.PeerMessage.entries)
+  return _s;
+}
+inline const std::string& PeerMessage::_internal_entries(int index) const {
+  return _impl_.entries_.Get(index);
 }
-inline const ::std::string& PeerMessage::entries(int index) const {
+inline const std::string& PeerMessage::entries(int index) const {
   // @@protoc_insertion_point(field_get:proto.PeerMessage.entries)
-  return entries_.Get(index);
+  return _internal_entries(index);
 }
-inline ::std::string* PeerMessage::mutable_entries(int index) {
+inline std::string* PeerMessage::mutable_entries(int index) {
   // @@protoc_insertion_point(field_mutable:proto.PeerMessage.entries)
-  return entries_.Mutable(index);
+  return _impl_.entries_.Mutable(index);
 }
-inline void PeerMessage::set_entries(int index, const ::std::string& value) {
+inline void PeerMessage::set_entries(int index, const std::string& value) {
+  _impl_.entries_.Mutable(index)->assign(value);
   // @@protoc_insertion_point(field_set:proto.PeerMessage.entries)
-  entries_.Mutable(index)->assign(value);
 }
-#if LANG_CXX11
-inline void PeerMessage::set_entries(int index, ::std::string&& value) {
+inline void PeerMessage::set_entries(int index, std::string&& value) {
+  _impl_.entries_.Mutable(index)->assign(std::move(value));
   // @@protoc_insertion_point(field_set:proto.PeerMessage.entries)
-  entries_.Mutable(index)->assign(std::move(value));
 }
-#endif
 inline void PeerMessage::set_entries(int index, const char* value) {
-  GOOGLE_DCHECK(value != NULL);
-  entries_.Mutable(index)->assign(value);
+  GOOGLE_DCHECK(value != nullptr);
+  _impl_.entries_.Mutable(index)->assign(value);
   // @@protoc_insertion_point(field_set_char:proto.PeerMessage.entries)
 }
 inline void PeerMessage::set_entries(int index, const char* value, size_t size) {
-  entries_.Mutable(index)->assign(
+  _impl_.entries_.Mutable(index)->assign(
     reinterpret_cast<const char*>(value), size);
   // @@protoc_insertion_point(field_set_pointer:proto.PeerMessage.entries)
 }
-inline ::std::string* PeerMessage::add_entries() {
-  // @@protoc_insertion_point(field_add_mutable:proto.PeerMessage.entries)
-  return entries_.Add();
+inline std::string* PeerMessage::_internal_add_entries() {
+  return _impl_.entries_.Add();
 }
-inline void PeerMessage::add_entries(const ::std::string& value) {
-  entries_.Add()->assign(value);
+inline void PeerMessage::add_entries(const std::string& value) {
+  _impl_.entries_.Add()->assign(value);
   // @@protoc_insertion_point(field_add:proto.PeerMessage.entries)
 }
-#if LANG_CXX11
-inline void PeerMessage::add_entries(::std::string&& value) {
-  entries_.Add(std::move(value));
+inline void PeerMessage::add_entries(std::string&& value) {
+  _impl_.entries_.Add(std::move(value));
   // @@protoc_insertion_point(field_add:proto.PeerMessage.entries)
 }
-#endif
 inline void PeerMessage::add_entries(const char* value) {
-  GOOGLE_DCHECK(value != NULL);
-  entries_.Add()->assign(value);
+  GOOGLE_DCHECK(value != nullptr);
+  _impl_.entries_.Add()->assign(value);
   // @@protoc_insertion_point(field_add_char:proto.PeerMessage.entries)
 }
 inline void PeerMessage::add_entries(const char* value, size_t size) {
-  entries_.Add()->assign(reinterpret_cast<const char*>(value), size);
+  _impl_.entries_.Add()->assign(reinterpret_cast<const char*>(value), size);
   // @@protoc_insertion_point(field_add_pointer:proto.PeerMessage.entries)
 }
-inline const ::google::protobuf::RepeatedPtrField< ::std::string>&
+inline const ::PROTOBUF_NAMESPACE_ID::RepeatedPtrField<std::string>&
 PeerMessage::entries() const {
   // @@protoc_insertion_point(field_list:proto.PeerMessage.entries)
-  return entries_;
+  return _impl_.entries_;
 }
-inline ::google::protobuf::RepeatedPtrField< ::std::string>*
+inline ::PROTOBUF_NAMESPACE_ID::RepeatedPtrField<std::string>*
 PeerMessage::mutable_entries() {
   // @@protoc_insertion_point(field_mutable_list:proto.PeerMessage.entries)
-  return &entries_;
+  return &_impl_.entries_;
 }
 
 // optional int32 leader_commit = 7;
-inline bool PeerMessage::has_leader_commit() const {
-  return (_has_bits_[0] & 0x00000020u) != 0;
+inline bool PeerMessage::_internal_has_leader_commit() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000040u) != 0;
+  return value;
 }
-inline void PeerMessage::set_has_leader_commit() {
-  _has_bits_[0] |= 0x00000020u;
-}
-inline void PeerMessage::clear_has_leader_commit() {
-  _has_bits_[0] &= ~0x00000020u;
+inline bool PeerMessage::has_leader_commit() const {
+  return _internal_has_leader_commit();
 }
 inline void PeerMessage::clear_leader_commit() {
-  leader_commit_ = 0;
-  clear_has_leader_commit();
+  _impl_.leader_commit_ = 0;
+  _impl_._has_bits_[0] &= ~0x00000040u;
 }
-inline ::google::protobuf::int32 PeerMessage::leader_commit() const {
+inline int32_t PeerMessage::_internal_leader_commit() const {
+  return _impl_.leader_commit_;
+}
+inline int32_t PeerMessage::leader_commit() const {
   // @@protoc_insertion_point(field_get:proto.PeerMessage.leader_commit)
-  return leader_commit_;
+  return _internal_leader_commit();
+}
+inline void PeerMessage::_internal_set_leader_commit(int32_t value) {
+  _impl_._has_bits_[0] |= 0x00000040u;
+  _impl_.leader_commit_ = value;
 }
-inline void PeerMessage::set_leader_commit(::google::protobuf::int32 value) {
-  set_has_leader_commit();
-  leader_commit_ = value;
+inline void PeerMessage::set_leader_commit(int32_t value) {
+  _internal_set_leader_commit(value);
   // @@protoc_insertion_point(field_set:proto.PeerMessage.leader_commit)
 }
 
 // optional bool success = 8;
-inline bool PeerMessage::has_success() const {
-  return (_has_bits_[0] & 0x00000100u) != 0;
-}
-inline void PeerMessage::set_has_success() {
-  _has_bits_[0] |= 0x00000100u;
+inline bool PeerMessage::_internal_has_success() const {
+  bool value = (_impl_._has_bits_[0] & 0x00001000u) != 0;
+  return value;
 }
-inline void PeerMessage::clear_has_success() {
-  _has_bits_[0] &= ~0x00000100u;
+inline bool PeerMessage::has_success() const {
+  return _internal_has_success();
 }
 inline void PeerMessage::clear_success() {
-  success_ = false;
-  clear_has_success();
+  _impl_.success_ = false;
+  _impl_._has_bits_[0] &= ~0x00001000u;
+}
+inline bool PeerMessage::_internal_success() const {
+  return _impl_.success_;
 }
 inline bool PeerMessage::success() const {
   // @@protoc_insertion_point(field_get:proto.PeerMessage.success)
-  return success_;
+  return _internal_success();
+}
+inline void PeerMessage::_internal_set_success(bool value) {
+  _impl_._has_bits_[0] |= 0x00001000u;
+  _impl_.success_ = value;
 }
 inline void PeerMessage::set_success(bool value) {
-  set_has_success();
-  success_ = value;
+  _internal_set_success(value);
   // @@protoc_insertion_point(field_set:proto.PeerMessage.success)
 }
 
 // optional int32 appended_log_index = 9;
-inline bool PeerMessage::has_appended_log_index() const {
-  return (_has_bits_[0] & 0x00000040u) != 0;
+inline bool PeerMessage::_internal_has_appended_log_index() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000080u) != 0;
+  return value;
 }
-inline void PeerMessage::set_has_appended_log_index() {
-  _has_bits_[0] |= 0x00000040u;
-}
-inline void PeerMessage::clear_has_appended_log_index() {
-  _has_bits_[0] &= ~0x00000040u;
+inline bool PeerMessage::has_appended_log_index() const {
+  return _internal_has_appended_log_index();
 }
 inline void PeerMessage::clear_appended_log_index() {
-  appended_log_index_ = 0;
-  clear_has_appended_log_index();
+  _impl_.appended_log_index_ = 0;
+  _impl_._has_bits_[0] &= ~0x00000080u;
 }
-inline ::google::protobuf::int32 PeerMessage::appended_log_index() const {
+inline int32_t PeerMessage::_internal_appended_log_index() const {
+  return _impl_.appended_log_index_;
+}
+inline int32_t PeerMessage::appended_log_index() const {
   // @@protoc_insertion_point(field_get:proto.PeerMessage.appended_log_index)
-  return appended_log_index_;
+  return _internal_appended_log_index();
+}
+inline void PeerMessage::_internal_set_appended_log_index(int32_t value) {
+  _impl_._has_bits_[0] |= 0x00000080u;
+  _impl_.appended_log_index_ = value;
 }
-inline void PeerMessage::set_appended_log_index(::google::protobuf::int32 value) {
-  set_has_appended_log_index();
-  appended_log_index_ = value;
+inline void PeerMessage::set_appended_log_index(int32_t value) {
+  _internal_set_appended_log_index(value);
   // @@protoc_insertion_point(field_set:proto.PeerMessage.appended_log_index)
 }
 
-// optional int32 last_log_index = 10;
-inline bool PeerMessage::has_last_log_index() const {
-  return (_has_bits_[0] & 0x00000080u) != 0;
+// optional int32 conflict_term = 19 [default = -1];
+inline bool PeerMessage::_internal_has_conflict_term() const {
+  bool value = (_impl_._has_bits_[0] & 0x00040000u) != 0;
+  return value;
+}
+inline bool PeerMessage::has_conflict_term() const {
+  return _internal_has_conflict_term();
+}
+inline void PeerMessage::clear_conflict_term() {
+  _impl_.conflict_term_ = -1;
+  _impl_._has_bits_[0] &= ~0x00040000u;
+}
+inline int32_t PeerMessage::_internal_conflict_term() const {
+  return _impl_.conflict_term_;
+}
+inline int32_t PeerMessage::conflict_term() const {
+  // @@protoc_insertion_point(field_get:proto.PeerMessage.conflict_term)
+  return _internal_conflict_term();
+}
+inline void PeerMessage::_internal_set_conflict_term(int32_t value) {
+  _impl_._has_bits_[0] |= 0x00040000u;
+  _impl_.conflict_term_ = value;
 }
-inline void PeerMessage::set_has_last_log_index() {
-  _has_bits_[0] |= 0x00000080u;
+inline void PeerMessage::set_conflict_term(int32_t value) {
+  _internal_set_conflict_term(value);
+  // @@protoc_insertion_point(field_set:proto.PeerMessage.conflict_term)
 }
-inline void PeerMessage::clear_has_last_log_index() {
-  _has_bits_[0] &= ~0x00000080u;
+
+// optional int32 conflict_first_index = 20;
+inline bool PeerMessage::_internal_has_conflict_first_index() const {
+  bool value = (_impl_._has_bits_[0] & 0x00020000u) != 0;
+  return value;
+}
+inline bool PeerMessage::has_conflict_first_index() const {
+  return _internal_has_conflict_first_index();
+}
+inline void PeerMessage::clear_conflict_first_index() {
+  _impl_.conflict_first_index_ = 0;
+  _impl_._has_bits_[0] &= ~0x00020000u;
+}
+inline int32_t PeerMessage::_internal_conflict_first_index() const {
+  return _impl_.conflict_first_index_;
+}
+inline int32_t PeerMessage::conflict_first_index() const {
+  // @@protoc_insertion_point(field_get:proto.PeerMessage.conflict_first_index)
+  return _internal_conflict_first_index();
+}
+inline void PeerMessage::_internal_set_conflict_first_index(int32_t value) {
+  _impl_._has_bits_[0] |= 0x00020000u;
+  _impl_.conflict_first_index_ = value;
+}
+inline void PeerMessage::set_conflict_first_index(int32_t value) {
+  _internal_set_conflict_first_index(value);
+  // @@protoc_insertion_point(field_set:proto.PeerMessage.conflict_first_index)
+}
+
+// optional int32 last_log_index = 10;
+inline bool PeerMessage::_internal_has_last_log_index() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000100u) != 0;
+  return value;
+}
+inline bool PeerMessage::has_last_log_index() const {
+  return _internal_has_last_log_index();
 }
 inline void PeerMessage::clear_last_log_index() {
-  last_log_index_ = 0;
-  clear_has_last_log_index();
+  _impl_.last_log_index_ = 0;
+  _impl_._has_bits_[0] &= ~0x00000100u;
 }
-inline ::google::protobuf::int32 PeerMessage::last_log_index() const {
+inline int32_t PeerMessage::_internal_last_log_index() const {
+  return _impl_.last_log_index_;
+}
+inline int32_t PeerMessage::last_log_index() const {
   // @@protoc_insertion_point(field_get:proto.PeerMessage.last_log_index)
-  return last_log_index_;
+  return _internal_last_log_index();
+}
+inline void PeerMessage::_internal_set_last_log_index(int32_t value) {
+  _impl_._has_bits_[0] |= 0x00000100u;
+  _impl_.last_log_index_ = value;
 }
-inline void PeerMessage::set_last_log_index(::google::protobuf::int32 value) {
-  set_has_last_log_index();
-  last_log_index_ = value;
+inline void PeerMessage::set_last_log_index(int32_t value) {
+  _internal_set_last_log_index(value);
   // @@protoc_insertion_point(field_set:proto.PeerMessage.last_log_index)
 }
 
 // optional int32 last_log_term = 11;
-inline bool PeerMessage::has_last_log_term() const {
-  return (_has_bits_[0] & 0x00000400u) != 0;
-}
-inline void PeerMessage::set_has_last_log_term() {
-  _has_bits_[0] |= 0x00000400u;
+inline bool PeerMessage::_internal_has_last_log_term() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000200u) != 0;
+  return value;
 }
-inline void PeerMessage::clear_has_last_log_term() {
-  _has_bits_[0] &= ~0x00000400u;
+inline bool PeerMessage::has_last_log_term() const {
+  return _internal_has_last_log_term();
 }
 inline void PeerMessage::clear_last_log_term() {
-  last_log_term_ = 0;
-  clear_has_last_log_term();
+  _impl_.last_log_term_ = 0;
+  _impl_._has_bits_[0] &= ~0x00000200u;
+}
+inline int32_t PeerMessage::_internal_last_log_term() const {
+  return _impl_.last_log_term_;
 }
-inline ::google::protobuf::int32 PeerMessage::last_log_term() const {
+inline int32_t PeerMessage::last_log_term() const {
   // @@protoc_insertion_point(field_get:proto.PeerMessage.last_log_term)
-  return last_log_term_;
+  return _internal_last_log_term();
 }
-inline void PeerMessage::set_last_log_term(::google::protobuf::int32 value) {
-  set_has_last_log_term();
-  last_log_term_ = value;
+inline void PeerMessage::_internal_set_last_log_term(int32_t value) {
+  _impl_._has_bits_[0] |= 0x00000200u;
+  _impl_.last_log_term_ = value;
+}
+inline void PeerMessage::set_last_log_term(int32_t value) {
+  _internal_set_last_log_term(value);
   // @@protoc_insertion_point(field_set:proto.PeerMessage.last_log_term)
 }
 
 // optional bool vote_granted = 12;
-inline bool PeerMessage::has_vote_granted() const {
-  return (_has_bits_[0] & 0x00000200u) != 0;
+inline bool PeerMessage::_internal_has_vote_granted() const {
+  bool value = (_impl_._has_bits_[0] & 0x00002000u) != 0;
+  return value;
 }
-inline void PeerMessage::set_has_vote_granted() {
-  _has_bits_[0] |= 0x00000200u;
-}
-inline void PeerMessage::clear_has_vote_granted() {
-  _has_bits_[0] &= ~0x00000200u;
+inline bool PeerMessage::has_vote_granted() const {
+  return _internal_has_vote_granted();
 }
 inline void PeerMessage::clear_vote_granted() {
-  vote_granted_ = false;
-  clear_has_vote_granted();
+  _impl_.vote_granted_ = false;
+  _impl_._has_bits_[0] &= ~0x00002000u;
+}
+inline bool PeerMessage::_internal_vote_granted() const {
+  return _impl_.vote_granted_;
 }
 inline bool PeerMessage::vote_granted() const {
   // @@protoc_insertion_point(field_get:proto.PeerMessage.vote_granted)
-  return vote_granted_;
+  return _internal_vote_granted();
+}
+inline void PeerMessage::_internal_set_vote_granted(bool value) {
+  _impl_._has_bits_[0] |= 0x00002000u;
+  _impl_.vote_granted_ = value;
 }
 inline void PeerMessage::set_vote_granted(bool value) {
-  set_has_vote_granted();
-  vote_granted_ = value;
+  _internal_set_vote_granted(value);
   // @@protoc_insertion_point(field_set:proto.PeerMessage.vote_granted)
 }
 
+// optional int32 last_included_index = 13;
+inline bool PeerMessage::_internal_has_last_included_index() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000400u) != 0;
+  return value;
+}
+inline bool PeerMessage::has_last_included_index() const {
+  return _internal_has_last_included_index();
+}
+inline void PeerMessage::clear_last_included_index() {
+  _impl_.last_included_index_ = 0;
+  _impl_._has_bits_[0] &= ~0x00000400u;
+}
+inline int32_t PeerMessage::_internal_last_included_index() const {
+  return _impl_.last_included_index_;
+}
+inline int32_t PeerMessage::last_included_index() const {
+  // @@protoc_insertion_point(field_get:proto.PeerMessage.last_included_index)
+  return _internal_last_included_index();
+}
+inline void PeerMessage::_internal_set_last_included_index(int32_t value) {
+  _impl_._has_bits_[0] |= 0x00000400u;
+  _impl_.last_included_index_ = value;
+}
+inline void PeerMessage::set_last_included_index(int32_t value) {
+  _internal_set_last_included_index(value);
+  // @@protoc_insertion_point(field_set:proto.PeerMessage.last_included_index)
+}
+
+// optional int32 last_included_term = 14;
+inline bool PeerMessage::_internal_has_last_included_term() const {
+  bool value = (_impl_._has_bits_[0] & 0x00008000u) != 0;
+  return value;
+}
+inline bool PeerMessage::has_last_included_term() const {
+  return _internal_has_last_included_term();
+}
+inline void PeerMessage::clear_last_included_term() {
+  _impl_.last_included_term_ = 0;
+  _impl_._has_bits_[0] &= ~0x00008000u;
+}
+inline int32_t PeerMessage::_internal_last_included_term() const {
+  return _impl_.last_included_term_;
+}
+inline int32_t PeerMessage::last_included_term() const {
+  // @@protoc_insertion_point(field_get:proto.PeerMessage.last_included_term)
+  return _internal_last_included_term();
+}
+inline void PeerMessage::_internal_set_last_included_term(int32_t value) {
+  _impl_._has_bits_[0] |= 0x00008000u;
+  _impl_.last_included_term_ = value;
+}
+inline void PeerMessage::set_last_included_term(int32_t value) {
+  _internal_set_last_included_term(value);
+  // @@protoc_insertion_point(field_set:proto.PeerMessage.last_included_term)
+}
+
+// optional int64 offset = 15;
+inline bool PeerMessage::_internal_has_offset() const {
+  bool value = (_impl_._has_bits_[0] & 0x00010000u) != 0;
+  return value;
+}
+inline bool PeerMessage::has_offset() const {
+  return _internal_has_offset();
+}
+inline void PeerMessage::clear_offset() {
+  _impl_.offset_ = int64_t{0};
+  _impl_._has_bits_[0] &= ~0x00010000u;
+}
+inline int64_t PeerMessage::_internal_offset() const {
+  return _impl_.offset_;
+}
+inline int64_t PeerMessage::offset() const {
+  // @@protoc_insertion_point(field_get:proto.PeerMessage.offset)
+  return _internal_offset();
+}
+inline void PeerMessage::_internal_set_offset(int64_t value) {
+  _impl_._has_bits_[0] |= 0x00010000u;
+  _impl_.offset_ = value;
+}
+inline void PeerMessage::set_offset(int64_t value) {
+  _internal_set_offset(value);
+  // @@protoc_insertion_point(field_set:proto.PeerMessage.offset)
+}
+
+// optional bytes data = 16;
+inline bool PeerMessage::_internal_has_data() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000001u) != 0;
+  return value;
+}
+inline bool PeerMessage::has_data() const {
+  return _internal_has_data();
+}
+inline void PeerMessage::clear_data() {
+  _impl_.data_.ClearToEmpty();
+  _impl_._has_bits_[0] &= ~0x00000001u;
+}
+inline const std::string& PeerMessage::data() const {
+  // @@protoc_insertion_point(field_get:proto.PeerMessage.data)
+  return _internal_data();
+}
+template <typename ArgT0, typename... ArgT>
+inline PROTOBUF_ALWAYS_INLINE
+void PeerMessage::set_data(ArgT0&& arg0, ArgT... args) {
+ _impl_._has_bits_[0] |= 0x00000001u;
+ _impl_.data_.SetBytes(static_cast<ArgT0 &&>(arg0), args..., GetArenaForAllocation());
+  // @@protoc_insertion_point(field_set:proto.PeerMessage.data)
+}
+inline std::string* PeerMessage::mutable_data() {
+  std::string* _s = _internal_mutable_data();
+  // @@protoc_insertion_point(field_mutable:proto.PeerMessage.data)
+  return _s;
+}
+inline const std::string& PeerMessage::_internal_data() const {
+  return _impl_.data_.Get();
+}
+inline void PeerMessage::_internal_set_data(const std::string& value) {
+  _impl_._has_bits_[0] |= 0x00000001u;
+  _impl_.data_.Set(value, GetArenaForAllocation());
+}
+inline std::string* PeerMessage::_internal_mutable_data() {
+  _impl_._has_bits_[0] |= 0x00000001u;
+  return _impl_.data_.Mutable(GetArenaForAllocation());
+}
+inline std::string* PeerMessage::release_data() {
+  // @@protoc_insertion_point(field_release:proto.PeerMessage.data)
+  if (!_internal_has_data()) {
+    return nullptr;
+  }
+  _impl_._has_bits_[0] &= ~0x00000001u;
+  auto* p = _impl_.data_.Release();
+#ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  if (_impl_.data_.IsDefault()) {
+    _impl_.data_.Set("", GetArenaForAllocation());
+  }
+#endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  return p;
+}
+inline void PeerMessage::set_allocated_data(std::string* data) {
+  if (data != nullptr) {
+    _impl_._has_bits_[0] |= 0x00000001u;
+  } else {
+    _impl_._has_bits_[0] &= ~0x00000001u;
+  }
+  _impl_.data_.SetAllocated(data, GetArenaForAllocation());
+#ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  if (_impl_.data_.IsDefault()) {
+    _impl_.data_.Set("", GetArenaForAllocation());
+  }
+#endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  // @@protoc_insertion_point(field_set_allocated:proto.PeerMessage.data)
+}
+
+// optional bool done = 17;
+inline bool PeerMessage::_internal_has_done() const {
+  bool value = (_impl_._has_bits_[0] & 0x00004000u) != 0;
+  return value;
+}
+inline bool PeerMessage::has_done() const {
+  return _internal_has_done();
+}
+inline void PeerMessage::clear_done() {
+  _impl_.done_ = false;
+  _impl_._has_bits_[0] &= ~0x00004000u;
+}
+inline bool PeerMessage::_internal_done() const {
+  return _impl_.done_;
+}
+inline bool PeerMessage::done() const {
+  // @@protoc_insertion_point(field_get:proto.PeerMessage.done)
+  return _internal_done();
+}
+inline void PeerMessage::_internal_set_done(bool value) {
+  _impl_._has_bits_[0] |= 0x00004000u;
+  _impl_.done_ = value;
+}
+inline void PeerMessage::set_done(bool value) {
+  _internal_set_done(value);
+  // @@protoc_insertion_point(field_set:proto.PeerMessage.done)
+}
+
 #ifdef __GNUC__
   #pragma GCC diagnostic pop
 #endif  // __GNUC__
@@ -702,8 +1251,7 @@ inline void PeerMessage::set_vote_granted(bool value) {
 
 }  // namespace proto
 
-namespace google {
-namespace protobuf {
+PROTOBUF_NAMESPACE_OPEN
 
 template <> struct is_proto_enum< ::proto::PeerMessage_Type> : ::std::true_type {};
 template <>
@@ -711,9 +1259,9 @@ inline const EnumDescriptor* GetEnumDescriptor< ::proto::PeerMessage_Type>() {
   return ::proto::PeerMessage_Type_descriptor();
 }
 
-}  // namespace protobuf
-}  // namespace google
+PROTOBUF_NAMESPACE_CLOSE
 
 // @@protoc_insertion_point(global_scope)
 
-#endif  // PROTOBUF_INCLUDED_peer_2dmessage_2eproto
+#include <google/protobuf/port_undef.inc>
+#endif  // GOOGLE_PROTOBUF_INCLUDED_GOOGLE_PROTOBUF_INCLUDED_peer_2dmessage_2eproto
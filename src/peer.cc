@@ -1,5 +1,24 @@
 #include "peer.h"
+
+#include <climits>
+#include <fcntl.h>
+#include <netinet/tcp.h>
+#include <sys/uio.h>
+
 #define RECEIVE_BUFFER_SIZE 100000
+// Smallest read worth making before moving a partial message to the front
+#define MIN_RECEIVE_SPACE 16384
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+// Size of the introduction that starts a duplex connection: a message
+// holding the connecting server's id, prefixed with its length
+static const int HANDSHAKE_BYTES = 2 * sizeof(int);
 
 static void ErrorCheckSysCall(int success, const char* unique_error_message) {
     if (success == -1) {
@@ -7,235 +26,636 @@ static void ErrorCheckSysCall(int success, const char* unique_error_message) {
     }
 }
 
+/**
+ * Opens a non-blocking socket listening on any interface at port.
+ *
+ * @return the socket, or -1 on failure (e.g. the port is still in use)
+ */
+static int ListenOnPort(unsigned short port) {
+    struct sockaddr_in serv; /* socket info about our server */
+    memset(&serv, 0, sizeof(serv));             /* zero the struct */
+    serv.sin_family = AF_INET;                  /* set connection type TCP/IP */
+    serv.sin_addr.s_addr = htonl(INADDR_ANY);   /* accept on any interface */
+    serv.sin_port = htons(port);                /* set the server port number */
+
+    int mysocket = socket(AF_INET, SOCK_STREAM, 0);
+    ErrorCheckSysCall(mysocket, "socket creation failed");
+    if (mysocket == -1) return -1;
+    debug("listen_port: %d, mysocket: %d", port, mysocket);
+
+    int val = 1; //required for setsockopt
+    ErrorCheckSysCall(setsockopt(mysocket, SOL_SOCKET, SO_REUSEADDR, &val,
+        sizeof(int)), "setsockopt failed to set SO_REUSEADDR for socket/port");
+
+    /* bind serv information to mysocket */
+    int success = bind(mysocket, (struct sockaddr *)&serv, sizeof(struct sockaddr));
+    if (success == 0) {
+        success = listen(mysocket, 1);
+        ErrorCheckSysCall(success, "listen attempt on mysocket failed");
+    } else {
+        ErrorCheckSysCall(success, "bind attempt failed on mysocket");
+    }
+    if (success == -1) {
+        close(mysocket);
+        return -1;
+    }
+    ErrorCheckSysCall(fcntl(mysocket, F_SETFL, O_NONBLOCK),
+        "fcntl failed to make mysocket non-blocking");
+    return mysocket;
+}
+
 Peer::Peer(unsigned short listening_port, std::string destination_ip_address,
-        unsigned short destination_port,
-        std::function<void(Peer*, char*, int)> peer_message_received_callback) {
+        unsigned short destination_port, EventLoop& event_loop,
+        std::function<void(Peer*, const char*, int)> peer_message_received_callback,
+        PeerOptions options) : event_loop(event_loop), options(options) {
     assert(listening_port != destination_port);
     my_port = listening_port;
     dest_port = destination_port;
     dest_ip_addr = destination_ip_address;
-    connection_reset = false;
-    running = true;
+    duplex = false;
+    dial = true;
+    my_server_id = -1;
+    listen_socket = -1;
     send_socket = -1;
     receive_socket = -1;
+    send_connecting = false;
+    send_waiting = false;
+    send_queue_bytes = 0;
+    send_offset = 0;
+    handshake_queued = false;
+
+    receive_buffer.resize(RECEIVE_BUFFER_SIZE);
+    receive_start = 0;
+    receive_end = 0;
+    message_received_callback = peer_message_received_callback;
 
-    debug("%s", "creating a new inbound listening thread");
-    in_listener = std::thread([this] () {ReceiveListener();});
+    Listen();
+    retry_handler = event_loop.AddTickHandler([this] () {
+        if (listen_socket == -1) {
+            Listen();
+        }
+    });
+}
 
-    partial_number_bytes = 0;
-    current_message_length = 0;
-    target_message_length = -1;
-    message_under_construction = NULL;
+Peer::Peer(int my_server_id, bool dial, std::string destination_ip_address,
+        unsigned short destination_port, EventLoop& event_loop,
+        std::function<void(Peer*, const char*, int)> peer_message_received_callback,
+        PeerOptions options) : event_loop(event_loop), options(options) {
+    my_port = 0;
+    dest_port = destination_port;
+    dest_ip_addr = destination_ip_address;
+    duplex = true;
+    this->dial = dial;
+    this->my_server_id = my_server_id;
+    listen_socket = -1;
+    send_socket = -1;
+    receive_socket = -1;
+    send_connecting = false;
+    send_waiting = false;
+    send_queue_bytes = 0;
+    send_offset = 0;
+    handshake_queued = false;
+
+    receive_buffer.resize(RECEIVE_BUFFER_SIZE);
+    receive_start = 0;
+    receive_end = 0;
     message_received_callback = peer_message_received_callback;
+
+    retry_handler = -1;
+    if (dial) {
+        // connect right away, since the peer can't reach us until we do
+        std::lock_guard<std::mutex> lock(send_mutex);
+        Connect();
+        retry_handler = event_loop.AddTickHandler([this] () {
+            std::lock_guard<std::mutex> lock(send_mutex);
+            if (send_socket == -1) {
+                Connect();
+            }
+        });
+    }
 }
 
 Peer::~Peer() {
-    running = false;
-    if (receive_socket != -1) { //if receive socket is active
-        ErrorCheckSysCall(shutdown(receive_socket, SHUT_RDWR),
-            "shudown recieve socket in peer");
-        //not safe to close until called this
-        //see: https://stackoverflow.com/a/2489066/6227019
-        //closing the socket is handled by the thread now
-        in_listener.join();
-    }
-    // if we still have a thread that hasn't been cleaned up
-    // (may not have opened a connection to send)
-    if (connection_reset == true) {
-        ErrorCheckSysCall(shutdown(send_socket, SHUT_RDWR),
-            "shutdown sending socket in peer");
-        //closing the socket is handled by the thread now
-        out_listener.join();
+    if (retry_handler != -1) {
+        event_loop.RemoveTickHandler(retry_handler);
+    }
+    if (listen_socket != -1) {
+        event_loop.Unwatch(listen_socket);
+        ErrorCheckSysCall(close(listen_socket), "close listen_socket");
+    }
+    CloseReceiveSocket();
+    std::lock_guard<std::mutex> lock(send_mutex);
+    if (send_socket != -1) {
+        CloseSendSocket();
     }
 }
 
 void Peer::SendMessage(const char* message, int message_len) {
-    if (send_socket == -1) {
-    //TODO: maybe this could be done in a thread to go faster, particular
-    //when attempting reconnection.  Though that should be rare and that
-    //the much-more-common send method below is non-blocking
-        debug("Attempted reconnection to %s on port %d",
+    QueueMessage({std::string(message, message_len), nullptr});
+}
+
+void Peer::SendMessage(std::string header,
+        std::shared_ptr<const std::string> body) {
+    QueueMessage({std::move(header), std::move(body)});
+}
+
+void Peer::QueueMessage(QueuedMessage message) {
+    std::lock_guard<std::mutex> lock(send_mutex);
+    send_queue_bytes += message.size();
+    send_queue.push_back(std::move(message));
+    // newer messages supersede older ones (the leader resends anything that
+    // goes unanswered), so drop from the front, except for a message that
+    // is partly sent already or the introduction of a duplex connection,
+    // without which the peer can't make sense of the rest
+    size_t kept = (send_offset > 0 || handshake_queued) ? 1 : 0;
+    while (send_queue_bytes > MAX_SEND_QUEUE_BYTES &&
+            send_queue.size() > kept + 1) {
+        debug("Send queue to %s:%d is full, dropping a message",
             dest_ip_addr.c_str(), dest_port);
-        struct sockaddr_in dest;
-        send_socket = socket(AF_INET, SOCK_STREAM, 0);
-        ErrorCheckSysCall(send_socket, "send_socket");
-
-        memset(&dest, 0, sizeof(dest));               /* zero the struct */
-        dest.sin_family = AF_INET;
-        dest.sin_addr.s_addr = inet_addr(dest_ip_addr.c_str());    /* set destination IP num */
-        dest.sin_port = htons(dest_port);      /* set destination port num */
-
-        int success = connect(send_socket, (struct sockaddr *)&dest,
-            sizeof(struct sockaddr_in));
-        if (success == 0) {
-            if (connection_reset) {
-                // if we had reset the connection, must clean up old thread
-                // before we spawn the new one (immediately below)
-                out_listener.join();
-                connection_reset = false;
-                debug("%s", "Joined old listening-for-close-on-outbound thread");
-            }
-            debug("%s", "Creating a new outbound-close listening thread");
-            out_listener = std::thread([this] () { CloseListener(); });
-        } else {
-            send_socket = -1;
-            ErrorCheckSysCall(success, "connect failed ");
-            warn("%s failed on %d failed",dest_ip_addr.c_str(), dest_port);
-            // if failed, will just lazy-retry on next send request
-        }
+        auto dropped = send_queue.begin() + kept;
+        send_queue_bytes -= dropped->size();
+        send_queue.erase(dropped);
+    }
+
+    if (send_socket == -1 && !dial) {
+        // nothing to send over until the peer connects to us
+        CloseSendSocket();
+        return;
+    }
+    if (send_socket == -1 && !Connect()) {
+        // if failed, will just lazy-retry on next send request
+        return;
     }
-    if (send_socket > 0) {
-        debug("Sending over socket: %d", send_socket);
-        // each peer is sequential & uses kernel buffers to send/avoid blocking
-        ErrorCheckSysCall(send(send_socket, &message_len,
-            sizeof(int), 0), "send int message_len prepend");
-        ErrorCheckSysCall(send(send_socket, message,
-            message_len, 0), "send message itself");
+    if (!send_connecting && !send_waiting) {
+        SendQueuedMessages();
     }
 }
 
-void Peer::ReceiveListener() {
-    while(running) {
-        AcceptConnection(dest_ip_addr.c_str(), my_port);
-        debug("receive socket: %d", receive_socket);
-        RespondToReceivedMessages(receive_socket);
-        if (receive_socket != -1) {
-            ErrorCheckSysCall(close(receive_socket),"close receive_socket");
-            receive_socket = -1;
-        }
-        ResetIncomingMessage();
-        //dump anything we haven't used from this previous connection
+bool Peer::Connect() {
+    debug("Attempted reconnection to %s on port %d",
+        dest_ip_addr.c_str(), dest_port);
+    struct sockaddr_in dest;
+    send_socket = socket(AF_INET, SOCK_STREAM, 0);
+    ErrorCheckSysCall(send_socket, "send_socket");
+    if (send_socket == -1) {
+        CloseSendSocket();
+        return false;
+    }
+    ErrorCheckSysCall(fcntl(send_socket, F_SETFL, O_NONBLOCK),
+        "fcntl failed to make send_socket non-blocking");
+    if (options.no_delay) {
+        int val = 1;
+        ErrorCheckSysCall(setsockopt(send_socket, IPPROTO_TCP, TCP_NODELAY,
+            &val, sizeof(int)), "setsockopt failed to set TCP_NODELAY");
+    }
+
+    memset(&dest, 0, sizeof(dest));               /* zero the struct */
+    dest.sin_family = AF_INET;
+    dest.sin_addr.s_addr = inet_addr(dest_ip_addr.c_str());    /* set destination IP num */
+    dest.sin_port = htons(dest_port);      /* set destination port num */
+
+    int success = connect(send_socket, (struct sockaddr *)&dest,
+        sizeof(struct sockaddr_in));
+    if (success == -1 && errno != EINPROGRESS) {
+        ErrorCheckSysCall(success, "connect failed ");
+        warn("%s failed on %d failed",dest_ip_addr.c_str(), dest_port);
+        CloseSendSocket();
+        return false;
+    }
+    if (duplex) {
+        // introduce ourselves ahead of anything already queued
+        send_queue.push_front({std::string((const char *) &my_server_id,
+            sizeof(int)), nullptr});
+        send_queue_bytes += sizeof(int);
+        handshake_queued = true;
     }
+    // HandleSendEvent finds out when a pending connection is established
+    send_connecting = (success == -1);
+    // a duplex connection is used right away, for the introduction at least
+    send_waiting = send_connecting || duplex;
+    event_loop.Watch(send_socket, EVENT_READ | (send_waiting ? EVENT_WRITE : 0),
+        [this] (int events) {
+            if (duplex) {
+                HandleConnectionEvent(events);
+            } else {
+                HandleSendEvent(events);
+            }
+        });
+    return true;
 }
 
-void Peer::CloseListener() {
-    RespondToReceivedMessages(send_socket);
-    connection_reset = true;
-    close(send_socket);
-    send_socket = -1;
-    debug("%s", "Outbound Connection Closed");
+void Peer::AdoptConnection(int new_socket) {
+    assert(duplex);
+    struct sockaddr_in dest; /* socket info about the machine connecting to us */
+    socklen_t socksize = sizeof(struct sockaddr_in);
+    if (getpeername(new_socket, (struct sockaddr *)&dest, &socksize) == -1 ||
+            dest.sin_addr.s_addr != inet_addr(dest_ip_addr.c_str())) {
+        warn("%s", "Connection from unspecified IP, closing connection");
+        close(new_socket);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(send_mutex);
+        // the peer only reconnects if its old connection broke
+        CloseSendSocket();
+        send_socket = new_socket;
+        debug("connection from %s: %d", dest_ip_addr.c_str(), send_socket);
+        if (options.no_delay) {
+            int val = 1;
+            ErrorCheckSysCall(setsockopt(send_socket, IPPROTO_TCP, TCP_NODELAY,
+                &val, sizeof(int)), "setsockopt failed to set TCP_NODELAY");
+        }
+        event_loop.Watch(send_socket, EVENT_READ,
+            [this] (int events) { HandleConnectionEvent(events); });
+    }
+    //dump anything we haven't used from the previous connection
+    ResetIncomingMessage();
 }
 
-void Peer::RespondToReceivedMessages(int socket) {
-    if (socket <= 0) return;
-    char buffer[RECEIVE_BUFFER_SIZE];
-    while(running) {
-        int len = recv(socket, buffer, RECEIVE_BUFFER_SIZE, 0);
+void Peer::HandleConnectionEvent(int events) {
+    int connection;
+    {
+        std::lock_guard<std::mutex> lock(send_mutex);
+        if (send_socket == -1) return;
+        if ((events & EVENT_WRITE) && send_connecting) {
+            int connect_error = 0;
+            socklen_t size = sizeof(int);
+            getsockopt(send_socket, SOL_SOCKET, SO_ERROR, &connect_error, &size);
+            if (connect_error != 0) {
+                debug("connect to %s:%d failed, %s (%d)", dest_ip_addr.c_str(),
+                    dest_port, strerror(connect_error), connect_error);
+                CloseSendSocket();
+                return;
+            }
+            send_connecting = false;
+        }
+        if ((events & EVENT_WRITE) && !send_connecting) {
+            SendQueuedMessages();
+        }
+        connection = send_socket;
+    }
+    if (!(events & EVENT_READ)) return;
+
+    // only this thread closes the connection, so it's safe to read unlocked
+    while (true) {
+        PrepareReceiveBuffer();
+        int len = recv(connection, &receive_buffer[receive_end],
+            receive_buffer.size() - receive_end, 0);
+        if (len == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        } else if (len == -1 && errno == EINTR) {
+            continue;
+        } else if (len > 0) {
+            debug("Received %d bytes", len);
+            HandleRecievedChunk(len);
+            continue;
+        }
         if (len == -1) {
             debug("recv: %s (%d)", strerror(errno), errno);
-            break;
-        } else if (len == 0) {
+        } else {
             debug("%s", "Peer Disconnected");
-            break;
         }
-        debug("Received %d bytes", len);
-        HandleRecievedChunk(buffer, len);
+        {
+            std::lock_guard<std::mutex> lock(send_mutex);
+            if (send_socket == connection) {
+                CloseSendSocket();
+            }
+        }
+        ResetIncomingMessage();
+        return;
     }
 }
 
-void Peer::AcceptConnection(const char* ip_addr, unsigned short listening_port) {
-    struct sockaddr_in dest; /* socket info about the machine connecting to us */
-    struct sockaddr_in serv; /* socket info about our server */
-    int mysocket;            /* socket used to listen for incoming connections */
-    socklen_t socksize = sizeof(struct sockaddr_in);
+void Peer::HandleSendEvent(int events) {
+    std::lock_guard<std::mutex> lock(send_mutex);
+    if (send_socket == -1) return;
+    if (events & EVENT_READ) {
+        char buf[1];
+        int len = recv(send_socket, buf, sizeof(buf), 0);
+        if (len == 0 || (len == -1 && errno != EAGAIN && errno != EINTR)) {
+            if (send_connecting) {
+                ErrorCheckSysCall(len, "connect failed ");
+                warn("%s failed on %d failed",dest_ip_addr.c_str(), dest_port);
+            } else {
+                debug("%s", "Outbound Connection Closed");
+            }
+            CloseSendSocket();
+            return;
+        }
+    }
+    if (events & EVENT_WRITE) {
+        if (send_connecting) {
+            int connect_error = 0;
+            socklen_t size = sizeof(int);
+            getsockopt(send_socket, SOL_SOCKET, SO_ERROR, &connect_error, &size);
+            if (connect_error != 0) {
+                warn("Error: connect failed , %s (%d)", strerror(connect_error),
+                    connect_error);
+                warn("%s failed on %d failed",dest_ip_addr.c_str(), dest_port);
+                CloseSendSocket();
+                return;
+            }
+            send_connecting = false;
+        }
+        SendQueuedMessages();
+    }
+}
 
-    memset(&serv, 0, sizeof(serv));             /* zero the struct */
-    serv.sin_family = AF_INET;                  /* set connection type TCP/IP */
-    serv.sin_addr.s_addr = htonl(INADDR_ANY);   /* accept on any interface */
-    serv.sin_port = htons(listening_port);      /* set the server port number */
+void Peer::SendQueuedMessages() {
+#ifdef TCP_CORK
+    int cork = 1;
+    if (options.cork) {
+        ErrorCheckSysCall(setsockopt(send_socket, IPPROTO_TCP, TCP_CORK,
+            &cork, sizeof(int)), "setsockopt failed to set TCP_CORK");
+    }
+#endif
+    while (!send_queue.empty()) {
+        int num_messages = std::min(send_queue.size(), (size_t) IOV_MAX / 3);
+        debug("Sending %d messages over socket: %d", num_messages, send_socket);
+        std::vector<int> message_lens;
+        std::vector<struct iovec> iovecs;
+        message_lens.reserve(num_messages);
+        for (int i = 0; i < num_messages; i++) {
+            const QueuedMessage& message = send_queue[i];
+            message_lens.push_back(message.size());
+            iovecs.push_back({&message_lens.back(), sizeof(int)});
+            iovecs.push_back({(void *) message.header.data(), message.header.size()});
+            if (message.body && !message.body->empty()) {
+                iovecs.push_back({(void *) message.body->data(), message.body->size()});
+            }
+        }
+        // skip the part of the first message that was sent already
+        size_t skip = send_offset;
+        size_t next_iovec = 0;
+        while (skip >= iovecs[next_iovec].iov_len) {
+            skip -= iovecs[next_iovec].iov_len;
+            next_iovec += 1;
+        }
+        iovecs[next_iovec].iov_base = (char *) iovecs[next_iovec].iov_base + skip;
+        iovecs[next_iovec].iov_len -= skip;
+
+        struct msghdr batch;
+        memset(&batch, 0, sizeof(batch));
+        batch.msg_iov = &iovecs[next_iovec];
+        batch.msg_iovlen = iovecs.size() - next_iovec;
+        ssize_t sent = sendmsg(send_socket, &batch, MSG_NOSIGNAL);
+        if (sent == -1 && errno == EINTR) continue;
+        if (sent == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (sent == -1 && duplex) {
+            // the event loop may be reading from the socket, so leave closing
+            // it to the loop, which finds out from its next read
+            ErrorCheckSysCall(sent, "send messages");
+            shutdown(send_socket, SHUT_RDWR);
+            send_queue.clear();
+            send_queue_bytes = 0;
+            send_offset = 0;
+            handshake_queued = false;
+            break;
+        }
+        if (sent == -1) {
+            ErrorCheckSysCall(sent, "send messages");
+            CloseSendSocket();
+            return;
+        }
+        // drop the messages that were sent in full
+        send_offset += sent;
+        while (!send_queue.empty() &&
+                send_offset >= (int) (sizeof(int) + send_queue.front().size())) {
+            send_offset -= sizeof(int) + send_queue.front().size();
+            send_queue_bytes -= send_queue.front().size();
+            send_queue.pop_front();
+            // the introduction, if queued, is always the first to go out
+            handshake_queued = false;
+        }
+    }
+#ifdef TCP_CORK
+    if (options.cork) {
+        // uncorking sends whatever is left of the batch
+        cork = 0;
+        ErrorCheckSysCall(setsockopt(send_socket, IPPROTO_TCP, TCP_CORK,
+            &cork, sizeof(int)), "setsockopt failed to clear TCP_CORK");
+    }
+#endif
+    // the rest goes out once the socket has room for it
+    WaitForWritable(!send_queue.empty());
+}
 
-    mysocket = socket(AF_INET, SOCK_STREAM, 0);
-    ErrorCheckSysCall(mysocket, "socket creation failed");
-    debug("listen_port: %d, mysocket: %d", listening_port, mysocket);
+void Peer::WaitForWritable(bool wait) {
+    if (wait != send_waiting) {
+        send_waiting = wait;
+        event_loop.Modify(send_socket, EVENT_READ | (wait ? EVENT_WRITE : 0));
+    }
+}
 
-    int val = 1; //required for setsockopt
-    ErrorCheckSysCall(setsockopt(mysocket, SOL_SOCKET, SO_REUSEADDR, &val,
-        sizeof(int)), "setsockopt failed to set SO_REUSEADDR for socket/port");
+void Peer::CloseSendSocket() {
+    if (send_socket != -1) {
+        event_loop.Unwatch(send_socket);
+        ErrorCheckSysCall(close(send_socket), "close send_socket");
+    }
+    send_socket = -1;
+    send_connecting = false;
+    send_waiting = false;
+    send_queue.clear();
+    send_queue_bytes = 0;
+    send_offset = 0;
+    handshake_queued = false;
+}
 
-    /* bind serv information to mysocket */
-    int success = bind(mysocket, (struct sockaddr *)&serv, sizeof(struct sockaddr));
-    ErrorCheckSysCall(success, "bind attempt failed on mysocket");
-    if (success == -1) return; //no chance of success, may lazy retry later
+void Peer::Listen() {
+    listen_socket = ListenOnPort(my_port);
+    if (listen_socket == -1) {
+        return; // retried on the next tick of the event loop
+    }
+    event_loop.Watch(listen_socket, EVENT_READ,
+        [this] (int events) { HandleListenEvent(events); });
+}
 
-    /* start listening, allowing a queue of up to 1 pending connection */
-    ErrorCheckSysCall(listen(mysocket, 1), "listen attempt on mysocket failed");
+void Peer::HandleListenEvent(int events) {
+    struct sockaddr_in dest; /* socket info about the machine connecting to us */
+    socklen_t socksize = sizeof(struct sockaddr_in);
+    int new_socket = accept(listen_socket, (struct sockaddr *)&dest, &socksize);
+    if (new_socket == -1) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            ErrorCheckSysCall(new_socket, "accept attempt on mysocket failed");
+        }
+        return;
+    }
+    if (dest.sin_addr.s_addr != inet_addr(dest_ip_addr.c_str())) {
+        warn("%s", "Connection from unspecified IP, closing connection");
+        close(new_socket);
+        return;
+    }
 
-    receive_socket = accept(mysocket, (struct sockaddr *)&dest, &socksize);
-    ErrorCheckSysCall(receive_socket, "accept attempt on mysocket failed");
+    // the peer only reconnects if its old connection broke
+    CloseReceiveSocket();
+    receive_socket = new_socket;
+    debug("receive socket: %d", receive_socket);
+    ErrorCheckSysCall(fcntl(receive_socket, F_SETFL, O_NONBLOCK),
+        "fcntl failed to make receive_socket non-blocking");
+    event_loop.Watch(receive_socket, EVENT_READ,
+        [this] (int events) { HandleReceiveEvent(events); });
+}
 
-    if (dest.sin_addr.s_addr != inet_addr(ip_addr)) {
-        warn("%s", "Connection from unspecified IP, closing connection");
-        close(receive_socket);
-        receive_socket = -1;
+void Peer::HandleReceiveEvent(int events) {
+    while (receive_socket != -1) {
+        PrepareReceiveBuffer();
+        int len = recv(receive_socket, &receive_buffer[receive_end],
+            receive_buffer.size() - receive_end, 0);
+        if (len == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        } else if (len == -1 && errno == EINTR) {
+            continue;
+        } else if (len == -1) {
+            debug("recv: %s (%d)", strerror(errno), errno);
+            CloseReceiveSocket();
+        } else if (len == 0) {
+            debug("%s", "Peer Disconnected");
+            CloseReceiveSocket();
+        } else {
+            debug("Received %d bytes", len);
+            HandleRecievedChunk(len);
+        }
     }
+}
 
-    ErrorCheckSysCall(close(mysocket), "close mysocket");
+void Peer::CloseReceiveSocket() {
+    if (receive_socket != -1) {
+        event_loop.Unwatch(receive_socket);
+        ErrorCheckSysCall(close(receive_socket),"close receive_socket");
+        receive_socket = -1;
+    }
+    //dump anything we haven't used from this previous connection
+    ResetIncomingMessage();
 }
 
 void Peer::ResetIncomingMessage() {
-    partial_number_bytes = 0;
-    current_message_length = 0;
-    target_message_length = -1;
-    if (message_under_construction != NULL) delete(message_under_construction);
-    message_under_construction = NULL;
+    receive_start = 0;
+    receive_end = 0;
 }
 
+void Peer::PrepareReceiveBuffer() {
+    int pending = receive_end - receive_start;
+    int message_size = 0;
+    if (pending >= (int) sizeof(int)) {
+        memcpy(&message_size, &receive_buffer[receive_start], sizeof(int));
+        message_size += sizeof(int);
+    }
+    // move the incomplete message to the front once the buffer is used up,
+    // which is the only time received bytes are copied
+    if (pending == 0 || receive_start + message_size > (int) receive_buffer.size() ||
+            (int) receive_buffer.size() - receive_end < MIN_RECEIVE_SPACE) {
+        memmove(&receive_buffer[0], &receive_buffer[receive_start], pending);
+        receive_start = 0;
+        receive_end = pending;
+    }
+    // messages bigger than the buffer grow it, for good
+    if (message_size > (int) receive_buffer.size()) {
+        receive_buffer.resize(message_size);
+    }
+}
 
-void Peer::HandleRecievedChunk(char* buffer, int valid_bytes) {
-    debug("the buffer, assuming leading int: %s", buffer + sizeof(int));
+void Peer::HandleRecievedChunk(int valid_bytes) {
+    receive_end += valid_bytes;
     // loop necessary, because may have received multiple messages in chunk
-    while(valid_bytes > 0) {
-        if (target_message_length == -1) {
-            //read bytes to determine the next message's length
-            int bytes_needed = sizeof(int) - partial_number_bytes;
-            int message_len_bytes = bytes_needed;
-            if(valid_bytes < bytes_needed) {
-                message_len_bytes = valid_bytes;
-            }
-            memcpy(incomplete_number_buffer + partial_number_bytes,
-            buffer, message_len_bytes);
-            partial_number_bytes += message_len_bytes;
-            valid_bytes -= message_len_bytes;
-            if(message_len_bytes == bytes_needed) {
-                // complete message_len_number was obtained,
-                target_message_length = *(int*)incomplete_number_buffer;
-                current_message_length = 0;
-
-                buffer = buffer + bytes_needed;
-                //heap allocation is not avoidable if e.g. we receive only part
-                // of the full message
-                message_under_construction = new char[target_message_length + 1];
-                message_under_construction[target_message_length] = '\0';
-                //null-terminate only because it's low-cost to do so
-            }
-        } else {
-            // accumulate current message
-            int bytes_to_copy = target_message_length;
-            if (valid_bytes < target_message_length) bytes_to_copy = valid_bytes;
-            memcpy(message_under_construction + current_message_length,
-                buffer, bytes_to_copy);
-            buffer = buffer + bytes_to_copy;
-            current_message_length += bytes_to_copy;
-            valid_bytes -= bytes_to_copy;
-
-            debug("current message len: %d, target: %d, valid: %d, to_copy: %d",
-                current_message_length, target_message_length, valid_bytes,
-                bytes_to_copy);
-
-            // if accumulated full message, callback & reset internal data
-            if(current_message_length == target_message_length) {
-                debug("Found full message: %s, buffer: %s",
-                    message_under_construction, buffer);
-
-                message_received_callback(this, message_under_construction,
-                    target_message_length);
-                //client may use data, w/ callback blocking, until reach here
-                ResetIncomingMessage();
-            }
+    while (receive_end - receive_start >= (int) sizeof(int)) {
+        int message_len;
+        memcpy(&message_len, &receive_buffer[receive_start], sizeof(int));
+        if (receive_end - receive_start - (int) sizeof(int) < message_len) {
+            // the rest of the message comes with a later chunk
+            break;
         }
+        const char* message = &receive_buffer[receive_start + sizeof(int)];
+        receive_start += sizeof(int) + message_len;
+        debug("Found full message of %d bytes", message_len);
+        // hand out the message in place, it's only valid during the callback
+        message_received_callback(this, message, message_len);
     }
 }
 
+PeerListener::PeerListener(unsigned short listening_port, EventLoop& event_loop,
+        std::function<void(int, int)> connection_callback) :
+        my_port(listening_port), listen_socket(-1), event_loop(event_loop),
+        connection_callback(connection_callback) {
+    Listen();
+    listen_retry_handler = event_loop.AddTickHandler([this] () {
+        if (listen_socket == -1) {
+            Listen();
+        }
+    });
+}
+
+PeerListener::~PeerListener() {
+    event_loop.RemoveTickHandler(listen_retry_handler);
+    if (listen_socket != -1) {
+        event_loop.Unwatch(listen_socket);
+        ErrorCheckSysCall(close(listen_socket), "close listen_socket");
+    }
+    while (!handshakes.empty()) {
+        CloseHandshakeSocket(handshakes.begin()->first);
+    }
+}
+
+void PeerListener::Listen() {
+    listen_socket = ListenOnPort(my_port);
+    if (listen_socket == -1) {
+        return; // retried on the next tick of the event loop
+    }
+    event_loop.Watch(listen_socket, EVENT_READ,
+        [this] (int events) { HandleListenEvent(events); });
+}
+
+void PeerListener::HandleListenEvent(int events) {
+    int new_socket = accept(listen_socket, NULL, NULL);
+    if (new_socket == -1) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            ErrorCheckSysCall(new_socket, "accept attempt on mysocket failed");
+        }
+        return;
+    }
+    ErrorCheckSysCall(fcntl(new_socket, F_SETFL, O_NONBLOCK),
+        "fcntl failed to make new socket non-blocking");
+    handshakes[new_socket] = "";
+    event_loop.Watch(new_socket, EVENT_READ, [this, new_socket] (int events) {
+        HandleHandshakeEvent(new_socket, events);
+    });
+}
+
+void PeerListener::HandleHandshakeEvent(int socket, int events) {
+    std::string& handshake = handshakes[socket];
+    char buffer[HANDSHAKE_BYTES];
+    int len = recv(socket, buffer, HANDSHAKE_BYTES - (int) handshake.size(), 0);
+    if (len == -1 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        return;
+    }
+    if (len <= 0) {
+        debug("%s", "Peer disconnected before introducing itself");
+        CloseHandshakeSocket(socket);
+        return;
+    }
+    handshake.append(buffer, len);
+    if ((int) handshake.size() < HANDSHAKE_BYTES) {
+        return;
+    }
+
+    int message_len = *(int *) handshake.data();
+    int server_id = *(int *) (handshake.data() + sizeof(int));
+    if (message_len != sizeof(int)) {
+        warn("%s", "Connection without an introduction, closing connection");
+        CloseHandshakeSocket(socket);
+        return;
+    }
+    event_loop.Unwatch(socket);
+    handshakes.erase(socket);
+    connection_callback(server_id, socket);
+}
+
+void PeerListener::CloseHandshakeSocket(int socket) {
+    event_loop.Unwatch(socket);
+    ErrorCheckSysCall(close(socket), "close handshake socket");
+    handshakes.erase(socket);
+}
+
+
 
 
 
@@ -5,12 +5,33 @@
 
 #pragma once
 
-#include <thread>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 #include <unistd.h>
 #include <arpa/inet.h>
 
+#include "event-loop.h"
 #include "log.h"
 
+// Limit on the size of messages waiting to be sent to a single peer
+static const int MAX_SEND_QUEUE_BYTES = 16'000'000; // bytes
+
+/**
+ * TCP options for the connections we send peer messages over.
+ */
+struct PeerOptions {
+    // Send each batch of messages right away, instead of letting TCP hold
+    // small ones back until earlier data is acknowledged (Nagle's algorithm)
+    bool no_delay = true;
+    // Cork the connection while a batch of messages is being written, so
+    // it goes out in full-sized packets (Linux only)
+    bool cork = false;
+};
 
 class Peer {
     public:
@@ -28,17 +49,45 @@ class Peer {
          * @param destination_port - port the peer machine will be listening for
          *      our connection on. NOTE: Must not be shared on destination machine
          *      because it uniquely identifies our machine to the peer.
+         * @param event_loop - event loop that waits on the connections to this
+         *      peer. Must outlive the peer.
          * @param peer_message_received_callback - callback function to be called
-         *      whenever we receive a message from this peer
+         *      (on the event loop's thread) whenever we receive a message from
+         *      this peer
          *      callback arguments:
          *          peer - who we received from
-         *          char* - pointer to heap-allocated message data (client frees)
-         *                  This is null-terminated for convenience 
+         *          char* - pointer to the message data, which points into
+         *                  our receive buffer and is only valid until the
+         *                  callback returns (copy anything that's kept)
          *          int - size of message data
+         * @param options - TCP options for the connection to the peer
          */
         Peer(unsigned short listening_port, std::string destination_ip_address,
-            unsigned short destination_port,
-            std::function<void(Peer*, char*, int)> peer_message_received_callback);
+            unsigned short destination_port, EventLoop& event_loop,
+            std::function<void(Peer*, const char*, int)> peer_message_received_callback,
+            PeerOptions options = PeerOptions());
+
+        /**
+         * Creates a peer that sends & receives over a single connection,
+         * for clusters where each server listens on just one peer port.
+         * Exactly one side of each pair dials: it connects to the peer's
+         * shared port (retrying on every tick of the event loop), and
+         * introduces itself by sending its server id as the first message.
+         * The other side waits for a PeerListener to hand it the connection
+         * with AdoptConnection, and drops messages until then.
+         *
+         * @param my_server_id - server id we introduce ourselves with
+         * @param dial - whether we connect to the peer, or it connects to us
+         * @param destination_ip_address - ip address of the peer machine
+         * @param destination_port - the peer's shared listening port
+         * @param event_loop - as above
+         * @param peer_message_received_callback - as above
+         * @param options - as above
+         */
+        Peer(int my_server_id, bool dial, std::string destination_ip_address,
+            unsigned short destination_port, EventLoop& event_loop,
+            std::function<void(Peer*, const char*, int)> peer_message_received_callback,
+            PeerOptions options = PeerOptions());
 
         /**
          *  Destroy the Peer Connection & clean up all resources
@@ -52,12 +101,37 @@ class Peer {
          * @param message - blob of data to send to the peer
          * @param message_len - size (in bytes) of message blob to send to peer
          *
-         * Uses kernel queue to provide nonblocking functionality, however
-         * after filled may block, as we wouldn't be able to make progress
-         * anyway
+         * Never blocks: whatever the socket won't take right away is queued,
+         * and sent by the event loop once the socket is writable, so a slow
+         * or unreachable peer can't hold up the caller. Everything queued
+         * goes out together, in as few system calls as possible.
+         * If more than MAX_SEND_QUEUE_BYTES are waiting, the oldest messages
+         * are dropped, and if the peer can't be reached, everything queued
+         * for it is dropped.
          */
         void SendMessage(const char* message, int message_len);
 
+        /**
+         * Like the above, but sends header followed by body as one message,
+         * and keeps a reference to body rather than copying it, so a single
+         * encoding can be sent to every peer.
+         *
+         * @param header - first part of the message, copied
+         * @param body - rest of the message, shared and never modified
+         */
+        void SendMessage(std::string header,
+            std::shared_ptr<const std::string> body);
+
+        /**
+         * Takes over a connection the peer made to our shared listening
+         * port, replacing any previous one. Only for peers created with
+         * the single connection constructor. Called on the event loop's
+         * thread by PeerListener, once the peer has introduced itself.
+         *
+         * @param socket - the connected socket, already non-blocking
+         */
+        void AdoptConnection(int socket);
+
         /*
          * Identifier for this peer
          */
@@ -65,29 +139,65 @@ class Peer {
 
     private:
         /**
-         * Attempts to listen for incoming connections on this port, and create
-         * a reusable socket on success.  On failure, peer is set to be
-         * non-communicating via this port & the user of this function will
-         * need to retry
+         * Attempts to listen for incoming connections on my_port. On failure
+         * (e.g. the port is still in use), this is retried on every tick of
+         * the event loop.
+         */
+        void Listen();
+        /**
+         * Accepts an incoming connection from dest_ip_addr, which replaces
+         * any previous one. Called by the event loop when listen_socket is
+         * readable.
+         */
+        void HandleListenEvent(int events);
+        /**
+         * Reads whatever has arrived on receive_socket, and calls the
+         * callback for every complete message. Called by the event loop.
+         */
+        void HandleReceiveEvent(int events);
+        void CloseReceiveSocket();
+
+        /**
+         * Starts connecting to the peer, without waiting for the connection
+         * to be established. Assumes that send_mutex is held.
+         *
+         * @return false if the connection failed right away
+         */
+        bool Connect();
+        /**
+         * Finishes connecting, sends queued messages once the socket can take
+         * more, and notices the connection breaking (since we use two
+         * different connections for send & receiving to minimize possible race
+         * conditions at small cost & maintain implementation simplicity, we
+         * don't expect to receive any real messages on it). Called by the
+         * event loop.
+         */
+        void HandleSendEvent(int events);
+        /**
+         * Does the job of both HandleSendEvent and HandleReceiveEvent for
+         * the single connection of a duplex peer. Only the event loop's
+         * thread closes that connection, since it reads from it without
+         * holding send_mutex (the callback may well send a reply).
+         */
+        void HandleConnectionEvent(int events);
+        /**
+         * Writes as many queued messages to send_socket as it will take, each
+         * prefixed with its length, using gathered writes rather than a
+         * write per message. Waits for the socket to be writable if anything
+         * is left. Assumes that send_mutex is held.
          */
-        void AcceptConnection(const char* ip_addr, unsigned short port_num);
+        void SendQueuedMessages();
         /**
-         * Will repeatedly attempt to listen for
-         * incoming connections on my_port coming from dest_ip_addr and updates
-         * associated receiving state when establishing connection.
-         * If connection is established, listens for messages coming in on the
-         * currently active socket.  When messages are received, calls callback
-         * for every full received chunk.
+         * Closes send_socket, and drops every queued message, as they would
+         * be stale by the time we reconnect (the leader resends what it still
+         * needs). Assumes that send_mutex is held.
          */
-        void ReceiveListener();
+        void CloseSendSocket();
         /**
-         * Listens for broken outgoing connection (since we use two different
-         * connections for send & receiving to minimize possible race conditions
-         * at small cost & maintain implementation simplicity), and updates state
-         * associated with outgoing connections on hearing the broken connection.
+         * Changes whether the event loop waits for send_socket to become
+         * writable. Assumes that send_mutex is held.
          */
-        void CloseListener();
-        void RespondToReceivedMessages(int socket);
+        void WaitForWritable(bool wait);
 
         /**
          * Explicitly track both sockets, even though we really only need one,
@@ -103,63 +213,95 @@ class Peer {
          * (P(failure) = probability down at any time ^ (num machines/2))
          * this won't end up using very many extra ports so seems worth
          * the reduced complexity
+         *
+         * listen_socket and receive_socket are only used on the event loop's
+         * thread; send_socket is guarded by send_mutex.
+         *
+         * Duplex peers (see the second constructor) avoid glare by having
+         * only one side of each pair connect. They use send_socket in both
+         * directions, and have no listen_socket or receive_socket.
          */
+        int listen_socket;
         int send_socket;
         int receive_socket;
         unsigned short my_port;
         unsigned short dest_port;
         std::string dest_ip_addr;
-        // Note: could just have one server external to the peer class, and
-        // use the sockets returned by this to form peers.
-        // However, this would require peers to identify each other using messages,
-        // and have an enclosing class doing this handoff from "made connection to
-        // someone" to individual peers, and this class would need to be simultaneously
-        // aware of multiple peers and sockets/networking details.
-        //
-        // Having a server for each peer simplifies the interface substantially
-        // because you trade a peermanager class + exposed sockets +
-        // passing sockets for a port argument
+
+        bool duplex;
+        bool dial;
+        int my_server_id;
+
+        EventLoop& event_loop;
+        // retries Listen, or Connect for duplex peers that dial
+        int retry_handler;
+
+        PeerOptions options;
 
         /**
-         * Listening for incoming connection and/or incoming messages if
-         * connection has already been established
+         * State of send_socket: whether it's still connecting, and whether
+         * the event loop is waiting for it to become writable.
          */
-        std::thread in_listener;
+        bool send_connecting;
+        bool send_waiting;
 
         /**
-         * Listening for the outgoing connection to break. Do not expect to
-         * receive any real messages, assuming normal peering.
+         * A message waiting to be sent: the header, followed by the (possibly
+         * shared) body, if any.
          */
-        std::thread out_listener;
+        struct QueuedMessage {
+            std::string header;
+            std::shared_ptr<const std::string> body;
+
+            int size() const {
+                return header.size() + (body ? body->size() : 0);
+            }
+        };
 
         /**
-         * Indicates whether the connection has been reset, and therefore we
-         * should join the old listening thread
+         * Adds a message to send_queue, and sends what we can right away.
          */
-        bool connection_reset;
+        void QueueMessage(QueuedMessage message);
+
         /**
-         * Indicates that the loops in the listening threads should continue
-         * running. Changed to false when destructing.
+         * Messages waiting to be sent, their total size, and how many bytes
+         * of the first one (including its length) have been sent already.
+         * Guarded by send_mutex.
          */
-        bool running;
-
-
-
+        std::deque<QueuedMessage> send_queue;
+        int send_queue_bytes;
+        int send_offset;
+        /**
+         * Whether the front of send_queue is the introduction of a duplex
+         * connection (our server id), which is never dropped to make room.
+         * Guarded by send_mutex.
+         */
+        bool handshake_queued;
+        std::mutex send_mutex;
 
         // merged StreamParser methods (as per Ousterhout's suggestion)
 
         /**
-         * Given a chunk of data from the stream of any size:
-         *  - parses out any completed messages & calls message_received_callback
-         *      that was passed in the constructor
-         *  - accumulates any partial messages to be completed by future chunks.
+         * Called after valid_bytes more bytes of the stream were read into
+         * receive_buffer at receive_end:
+         *  - calls message_received_callback that was passed in the
+         *      constructor for any completed messages, pointing into the
+         *      buffer rather than copying them out
+         *  - leaves any partial message to be completed by future chunks.
          *
          * Must be called on bytes coming from stream in order.
          *
-         * @param buffer - buffer containing received bytes from the stream
-         * @param valid_bytes - number of valid bytes in this buffer from stream
+         * @param valid_bytes - number of bytes just read from the stream
+         */
+        void HandleRecievedChunk(int valid_bytes);
+
+        /**
+         * Makes room after receive_end for the next read from the stream.
+         * A partial message is moved to the front of receive_buffer once
+         * there's little room left behind it, and the buffer grows if the
+         * message won't fit in it at all.
          */
-        void HandleRecievedChunk(char* buffer, int valid_bytes);
+        void PrepareReceiveBuffer();
 
         /**
          * Resets/ throws out any partially accumulated message from the socket,
@@ -176,37 +318,65 @@ class Peer {
          *      - char* : the blob of bytes received
          *      - int : the length of the blob of bytes received
          */
-        std::function<void(Peer*, char*, int)> message_received_callback;
+        std::function<void(Peer*, const char*, int)> message_received_callback;
         //TODO: feel bad about typedef v.s. more explicit function signature
         // typedef seems to lose information/ require scrolling, especially
         // because we have multiple callbacks throught raft
 
         /*
-         * How many bytes we have currently received as part of the next message
-         * from this peer.
+         * Bytes received from the current connection, which are read into
+         * the buffer and parsed in place. It's reused for the life of the
+         * peer, so receiving a message normally takes no allocation or copy.
+         * Bytes before receive_start were handed to the callback already;
+         * those up to receive_end start the next message, which is still
+         * incomplete. Only used on the event loop's thread.
          */
-        int current_message_length;
-        /*
-         * How many total bytes will be in our next message
+        std::vector<char> receive_buffer;
+        int receive_start;
+        int receive_end;
+};
+
+/**
+ * Listens on a server's single peer port, for clusters configured with one
+ * peer port per server. Every connection starts with the connecting server
+ * introducing itself, which tells us whose Peer it should be handed to.
+ */
+class PeerListener {
+    public:
+        /**
+         * @param listening_port - our shared peer port. Binding it is
+         *      retried on every tick of the event loop until it succeeds.
+         * @param event_loop - event loop that waits on the connections.
+         *      Must outlive the listener.
+         * @param connection_callback - called on the event loop's thread with
+         *      the server id a new connection introduced itself with, and
+         *      the (non-blocking) socket, which the callback then owns.
          */
-        int target_message_length;
-        /*
-         * Message under construction is a heap-allocated buffer that tracks
-         * the "current" partially-received message that came over the
-         * socket's stream. It will accumulate only until we have a full message.
-         * This must be freed before you point to a new heap location
+        PeerListener(unsigned short listening_port, EventLoop& event_loop,
+            std::function<void(int, int)> connection_callback);
+
+        ~PeerListener();
+
+    private:
+        void Listen();
+        void HandleListenEvent(int events);
+        /**
+         * Reads the introduction from a new connection, and hands the
+         * connection over once it's complete. Reads nothing past it, as
+         * messages may follow right behind.
          */
-        char* message_under_construction;
+        void HandleHandshakeEvent(int socket, int events);
+        void CloseHandshakeSocket(int socket);
+
+        unsigned short my_port;
+        int listen_socket;
+        EventLoop& event_loop;
+        int listen_retry_handler;
+        std::function<void(int, int)> connection_callback;
 
         /**
-         * Because the stream of bytes may be cut even along within the middle
-         * of the 4 bytes identifying the length of the subsequent message blob,
-         * we may need to accumulate a partial integer.  We use this number &
-         * buffer to accumulate bytes until the full number is complete.
+         * Bytes of the introduction received so far on each new connection.
+         * Only used on the event loop's thread.
          */
-        /* number of bytes currently written in incomplete_number_buffer */
-        int partial_number_bytes;
-        /* accumulator for the leading integer, that precedes each message
-         * and enables us to provide a message-based interface */
-        char incomplete_number_buffer[sizeof(int)];
+        std::map<int, std::string> handshakes;
 };
@@ -1,141 +1,508 @@
 #include "persistent_log.h"
 
 
-PersistentLog::PersistentLog(const char *filename) {
-    std::string cursor_filename_str = std::string(filename) + "_cursor";
-    cursor_filename = strdup(cursor_filename_str.c_str());
+PersistentLog::PersistentLog(const char *filename, bool sync_writes,
+        long cache_budget) :
+        first_log_index(0), cache_bytes(0), cache_budget(cache_budget), cache_hits(0),
+        cache_misses(0), sync_writes(sync_writes), written_index(-1),
+        written_fd(-1), durable_index(-1), sync_in_progress(false) {
+    std::string manifest_filename_str = std::string(filename) + "_manifest";
+    manifest_filename = strdup(manifest_filename_str.c_str());
     std::string log_filename_str = std::string(filename) + "_log";
     log_filename = strdup(log_filename_str.c_str());
-    debug("cursor filename: %s , log: %s", cursor_filename, log_filename);
-    log_file = NULL;
-    cursor_file = NULL;
-    bool success = ReopenLog();
-    if (!success) {
+    debug("manifest filename: %s , log: %s", manifest_filename, log_filename);
+    cursor = {0, 0};
+    open = ReopenLog();
+    if (!open) {
         warn("failed to reopen log %s", filename);
         return;
     }
+    PublishWrites();
+    durable_index = written_index; // everything on disk at startup counts
 }
 
 
 PersistentLog::~PersistentLog() {
     RemoveCachedLogEntries();
-    delete(cursor_filename);
-    delete(log_filename);
+    for (struct LogSegment& segment : segments) {
+        CloseSegment(segment);
+    }
+    free((void *) manifest_filename);
+    free((void *) log_filename);
 }
 
 bool PersistentLog::ResetLog() {
-    cursor = 0;
+    int zero = 0;
+    char base_entry[10 + sizeof(int)];
+    memcpy(base_entry, &zero, sizeof(int));
+    memcpy(base_entry + 4, "echo hell\0", 10);
+    if (!ResetLog(0, base_entry, 10 + sizeof(int))) { //start of all logs is same
+        return false;
+    }
+    if (!AddLogEntry(base_entry, 10 + sizeof(int))) { //need previous entry too
+        return false;
+    }
+    // a log left in the older single-file format is reset too
+    unlink(LegacyCursorFilename().c_str());
+    unlink(log_filename);
+    return Sync(LastLogIndex());
+}
+
+bool PersistentLog::ResetLog(int index, const void* log_data, int log_data_len) {
+    {
+        std::unique_lock<std::mutex> lock(sync_mutex);
+        // a running sync could still be syncing a segment we're about to delete
+        while (sync_in_progress) {
+            sync_cv.wait(lock);
+        }
+        written_index = -1;
+        written_fd = -1;
+        durable_index = -1;
+    }
     RemoveCachedLogEntries();
     log_entries.clear();
+    first_log_index = index;
 
-    if(Util::PersistentFileUpdate(cursor_filename, &cursor, sizeof(int)) == false) {
-        warn("Error: PersistentFileUpdate failed to write to cursor %d file", cursor);
-        return false;
+    // without a manifest, a crash part way through resets the log again
+    unlink(manifest_filename);
+    for (struct LogSegment& segment : segments) {
+        CloseSegment(segment);
+        unlink(SegmentFilename(segment.number).c_str());
     }
-    log_file = fopen( log_filename , "wb" ); //erases old log
-    fclose(log_file);
+    segments.clear();
 
-    log_file = fopen( log_filename , "r+b" );
-    cursor_file = fopen( cursor_filename, "r+b" );
-    if (log_file == NULL || cursor_file == NULL) {
-        warn("Error: failed to open log || cursor_filename file %s", cursor_filename);
+    cursor = {0, 0};
+    if (!OpenSegment(0, LOG_SEGMENT_SIZE, true)) {
+        warn("Error: failed to create first segment of log %s", log_filename);
         return false;
     }
-    int zero = 0;
-    char base_entry[10 + sizeof(int)];
-    memcpy(base_entry, &zero, sizeof(int));
-    memcpy(base_entry + 4, "echo hell\0", 10);
-    AddLogEntry(base_entry, 10 + sizeof(int)); //start of all logs is same
-    AddLogEntry(base_entry, 10 + sizeof(int)); //need previous entry too
-    return true;
+    if (!WriteManifest()) {
+        return false;
+    }
+    PublishWrites();
+    if (!AddLogEntry(log_data, log_data_len)) {
+        return false;
+    }
+    return Sync(LastLogIndex());
 }
 
 bool PersistentLog::ReopenLog() {
-    cursor_file = fopen( cursor_filename , "r+b" );
-    log_file = fopen( log_filename , "r+b" );
+    if (access(LegacyCursorFilename().c_str(), F_OK) == 0) {
+        // left by the older single-file log, or by a migration that crashed
+        return MigrateLegacyLog();
+    }
+    FILE *manifest_file = fopen( manifest_filename , "rb" );
 
-    if (cursor_file == NULL || log_file == NULL) {
-        debug("creating cursor & log files %s", log_filename);
-        if (cursor_file != NULL) fclose(cursor_file);
-        if (log_file != NULL) fclose(log_file);
+    if (manifest_file == NULL) {
+        debug("creating manifest & log files %s", log_filename);
         if (ResetLog() != true) {
             debug("%s", "Failed to reset log");
+            return false;
         }
+        return true;
+    }
+    // manifest is a list of [segment number][end of sealed segment] pairs
+    std::vector<struct LogPosition> manifest;
+    struct LogPosition manifest_entry;
+    while (fread(&manifest_entry, sizeof(manifest_entry), 1, manifest_file) == 1) {
+        manifest.push_back(manifest_entry);
     }
-    fread(&cursor, sizeof(int), 1, cursor_file);
-    debug("opened log, cursor: %d", cursor);
-    fclose(cursor_file);
+    fclose(manifest_file);
+    if (manifest.empty()) {
+        warn("Error: manifest of log %s is empty", log_filename);
+        return false;
+    }
+    debug("opened log, %zu segments", manifest.size());
+
+    for (struct LogPosition segment_info : manifest) {
+        if (!OpenSegment(segment_info.segment, 0, false)) {
+            return false;
+        }
+        segments.back().end = segment_info.offset;
+    }
+    segments.back().end = -1;
     if (LoadIndexFromLog() != true) {
         warn("Failed to load full log into memory %s", log_filename);
         return false;
     }
+    if (log_entries.empty()) {
+        // only happens if we crashed while resetting the log
+        debug("log %s has no entries, resetting it", log_filename);
+        return ResetLog();
+    }
+    return true;
+}
+
+
+bool PersistentLog::MigrateLegacyLog() {
+    std::string cursor_filename = LegacyCursorFilename();
+    FILE *cursor_file = fopen(cursor_filename.c_str(), "rb");
+    FILE *legacy_file = fopen(log_filename, "rb");
+    int legacy_cursor = 0;
+    bool readable = cursor_file != NULL && legacy_file != NULL &&
+        fread(&legacy_cursor, sizeof(int), 1, cursor_file) == 1;
+    if (cursor_file != NULL) fclose(cursor_file);
+
+    std::vector<std::string> legacy_entries;
+    int scan_location = 0;
+    while (readable && scan_location < legacy_cursor) {
+        int entry_size;
+        int trailing_size;
+        if (fread(&entry_size, sizeof(int), 1, legacy_file) != 1 || entry_size < 0 ||
+                entry_size > legacy_cursor - scan_location - (int) (2 * sizeof(int))) {
+            readable = false;
+            break;
+        }
+        std::string entry(entry_size, '\0');
+        if (fread(&entry[0], 1, entry_size, legacy_file) != (size_t) entry_size ||
+                fread(&trailing_size, sizeof(int), 1, legacy_file) != 1 ||
+                trailing_size != entry_size) {
+            readable = false;
+            break;
+        }
+        legacy_entries.push_back(entry);
+        scan_location += entry_size + 2 * sizeof(int);
+    }
+    if (legacy_file != NULL) fclose(legacy_file);
+    if (!readable || legacy_entries.empty()) {
+        error("Error: log %s is in the old single-file format (with %s) but "
+            "can't be read; refusing to replace it", log_filename,
+            cursor_filename.c_str());
+        return false;
+    }
+
+    info("Migrating %zu entries of log %s into segments", legacy_entries.size(),
+        log_filename);
+    std::string& first_entry = legacy_entries.front();
+    if (!ResetLog(0, first_entry.data(), first_entry.size())) {
+        return false;
+    }
+    legacy_entries.erase(legacy_entries.begin());
+    if (!AddLogEntries(legacy_entries) || !Sync(LastLogIndex())) {
+        error("Error: failed to copy old log %s into segments", log_filename);
+        return false;
+    }
+    // deleting the cursor file commits the migration
+    if (unlink(cursor_filename.c_str()) == -1) {
+        warn("Error: failed to delete old cursor %s, %s (%d)",
+            cursor_filename.c_str(), strerror(errno), errno);
+    }
+    unlink(log_filename);
     return true;
 }
 
 
+std::string PersistentLog::LegacyCursorFilename() {
+    std::string log_filename_str(log_filename);
+    // filename + _log, whose cursor file was filename + _cursor
+    return log_filename_str.substr(0, log_filename_str.size() - 4) + "_cursor";
+}
+
+
 bool PersistentLog::LoadIndexFromLog() {
-    if (cursor == 0) return true;
     log_entries.clear();
-    int scan_location = 0;
-    while(true) {
-        int success = fseek(log_file, scan_location, SEEK_SET);
+    first_log_index = 0;
+    std::vector<char> buffer;
+    for (struct LogSegment& segment : segments) {
+        int segment_end = (segment.end == -1) ? segment.size : segment.end;
+        int scan_location = 0;
+        int success = fseek(segment.file, 0, SEEK_SET);
         if (success != 0) {
             warn("Error: fseek failed to move to move to a new file offset, %s (%d)", strerror(errno), errno);
             return false;
         }
-        int entry_size;
-        int read_bytes = fread( &entry_size, 1, sizeof(int), log_file);
-        if (read_bytes != sizeof(int)) {
-            warn("Error: fread failed to read int bytes from log file at scan_location %d, cursor %d, %s (%d)", scan_location, cursor, strerror(errno), errno);
+        // records are read back to back, the first bad one ends the log
+        while (scan_location + (int) sizeof(struct LogRecordHeader) <= segment_end) {
+            struct LogRecordHeader header;
+            if (fread(&header, sizeof(header), 1, segment.file) != 1) {
+                break;
+            }
+            if (log_entries.empty()) {
+                // the prefix before the first segment may have been compacted
+                first_log_index = header.index;
+            }
+            if (header.index != first_log_index + (int) log_entries.size() || header.len < 0 ||
+                    header.len > segment_end - scan_location - (int) sizeof(header)) {
+                break;
+            }
+            buffer.resize(header.len);
+            if (fread(buffer.data(), 1, header.len, segment.file) != (size_t) header.len) {
+                break;
+            }
+            uint32_t crc = Util::Crc32c(0, &header.index, sizeof(header) - sizeof(header.crc));
+            if (Util::Crc32c(crc, buffer.data(), header.len) != header.crc) {
+                break;
+            }
+            struct LogIndexEntry current_entry;
+            current_entry.segment = segment.number;
+            current_entry.offset = scan_location;
+            current_entry.len = header.len;
+            log_entries.push_back(current_entry);
+
+            scan_location += sizeof(header) + header.len;
+        }
+        if (scan_location != segment.end) {
+            cursor = {segment.number, scan_location};
+            debug("log ends at %d:%d, index %d", cursor.segment, cursor.offset, LastLogIndex());
+            if (segment.number != segments.back().number) {
+                // crashed while truncating, later segments aren't part of the log
+                std::lock_guard<std::mutex> lock(sync_mutex);
+                RemoveSegmentsAfter(segment.number);
+            }
+            break;
+        }
+    }
+    return true;
+}
+
+
+void PersistentLog::RemoveCachedLogEntries() {
+    for (auto& cached : cache) {
+        delete[] cached.second.data; //free lazily populated in-memory log entries
+    }
+    cache.clear();
+    cache_lru.clear();
+    cache_bytes = 0;
+}
+
+
+char *PersistentLog::LookupCachedLogEntry(int index) {
+    auto cached = cache.find(index);
+    if (cached == cache.end()) {
+        cache_misses += 1;
+        return NULL;
+    }
+    cache_hits += 1;
+    cache_lru.splice(cache_lru.begin(), cache_lru, cached->second.lru_position);
+    return cached->second.data;
+}
+
+
+void PersistentLog::CacheLogEntry(int index, char *data, int len) {
+    cache_lru.push_front(index);
+    cache[index] = {data, len, cache_lru.begin()};
+    cache_bytes += len;
+}
+
+
+void PersistentLog::RemoveCachedLogEntry(int index) {
+    auto cached = cache.find(index);
+    if (cached == cache.end()) return;
+    delete[] cached->second.data;
+    cache_bytes -= cached->second.len;
+    cache_lru.erase(cached->second.lru_position);
+    cache.erase(cached);
+}
+
+
+void PersistentLog::TrimCache() {
+    while (cache_bytes > cache_budget && !cache_lru.empty()) {
+        RemoveCachedLogEntry(cache_lru.back());
+    }
+}
+
+
+long PersistentLog::CacheHits() {
+    return cache_hits;
+}
+
+
+long PersistentLog::CacheMisses() {
+    return cache_misses;
+}
+
+
+long PersistentLog::CacheBytes() {
+    return cache_bytes;
+}
+
+
+std::string PersistentLog::SegmentFilename(int number) {
+    return std::string(log_filename) + "." + std::to_string(number);
+}
+
+
+struct LogSegment& PersistentLog::GetSegment(int number) {
+    return segments[number - segments.front().number];
+}
+
+
+bool PersistentLog::OpenSegment(int number, int size, bool create) {
+    std::string filename = SegmentFilename(number);
+    struct LogSegment segment;
+    segment.number = number;
+    segment.end = -1;
+    segment.file = fopen(filename.c_str(), create ? "w+b" : "r+b");
+    if (segment.file == NULL) {
+        warn("Error: failed to open segment file %s, %s (%d)", filename.c_str(), strerror(errno), errno);
+        return false;
+    }
+    if (create) {
+        // allocate the whole segment up front, so appends never grow the file
+        bool allocated = Util::PreallocateFile(fileno(segment.file), size);
+        if (allocated && sync_writes) {
+            allocated = Util::SyncFileData(fileno(segment.file));
+        }
+        if (!allocated) {
+            warn("Error: failed to preallocate %d bytes for segment file %s", size, filename.c_str());
+            fclose(segment.file);
+            unlink(filename.c_str());
             return false;
         }
-        struct LogEntry current_entry;
-        current_entry.data = NULL;
-        current_entry.offset = scan_location;
-        current_entry.len = entry_size;
-        log_entries.push_back(current_entry);
+        segment.size = size;
+    } else {
+        fseek(segment.file, 0, SEEK_END);
+        segment.size = ftell(segment.file);
+    }
+    // the size never changes, so the mapping covers every future append
+    void *map = mmap(NULL, segment.size, PROT_READ, MAP_SHARED,
+        fileno(segment.file), 0);
+    if (map == MAP_FAILED) {
+        warn("failed to map segment file %s, reading it instead, %s (%d)", filename.c_str(), strerror(errno), errno);
+        segment.map = NULL;
+    } else {
+        segment.map = (char *) map;
+    }
+    segments.push_back(segment);
+    return true;
+}
 
-        scan_location += ((sizeof(int) * 2) + entry_size);
-        if (scan_location == cursor) return true;
+
+void PersistentLog::CloseSegment(struct LogSegment& segment) {
+    if (segment.map != NULL) {
+        munmap(segment.map, segment.size);
     }
+    fclose(segment.file);
 }
 
 
-void PersistentLog::RemoveCachedLogEntries() {
-    for (int i = 0; i<log_entries.size(); i++) {
-        if (log_entries[i].data != NULL) {
-            delete(log_entries[i].data ); //free lazily populated in-memory log entries
+bool PersistentLog::WriteManifest() {
+    std::vector<struct LogPosition> manifest;
+    for (struct LogSegment& segment : segments) {
+        manifest.push_back({segment.number, segment.end});
+    }
+    if (!Util::PersistentFileUpdate(manifest_filename, manifest.data(),
+            manifest.size() * sizeof(struct LogPosition), sync_writes)) {
+        warn("Error: failed to update manifest of log %s", log_filename);
+        return false;
+    }
+    return true;
+}
+
+
+bool PersistentLog::RollSegment(int min_size) {
+    struct LogSegment& active = segments.back();
+    int success = fflush(active.file);
+    if (success != 0) {
+        warn("Error: fflush failed to push all writes to disk, %s (%d)", strerror(errno), errno);
+        return false;
+    }
+    // Sync() only covers the active segment, so sync the one being sealed now
+    if (sync_writes && !Util::SyncFileData(fileno(active.file))) {
+        return false;
+    }
+    int number = active.number + 1;
+    active.end = cursor.offset;
+    if (!OpenSegment(number, std::max(LOG_SEGMENT_SIZE, min_size), true)) {
+        segments.back().end = -1;
+        return false;
+    }
+    if (!WriteManifest()) {
+        CloseSegment(segments.back());
+        unlink(SegmentFilename(number).c_str());
+        segments.pop_back();
+        segments.back().end = -1;
+        return false;
+    }
+    debug("rolled log over to segment %d", number);
+    cursor = {number, 0};
+    return true;
+}
+
+
+bool PersistentLog::RemoveSegmentsAfter(int number) {
+    std::vector<struct LogSegment> removed_segments(
+        segments.begin() + (number - segments.front().number) + 1, segments.end());
+    segments.erase(segments.end() - removed_segments.size(), segments.end());
+    segments.back().end = -1;
+    // the manifest goes first, so a crash never leaves it listing missing files
+    bool updated = WriteManifest();
+    for (struct LogSegment& segment : removed_segments) {
+        CloseSegment(segment);
+        if (updated) {
+            unlink(SegmentFilename(segment.number).c_str());
         }
     }
+    written_fd = fileno(segments.back().file);
+    return updated;
 }
 
 
-bool PersistentLog::MoveCursor(int distance) {
-    int new_cursor_position = cursor + distance;
-    if (Util::PersistentFileUpdate(cursor_filename, &new_cursor_position, sizeof(int))) {
-        cursor = new_cursor_position;
-        debug("moved cursor to %d", cursor);
-        return true;
+void PersistentLog::PublishWrites() {
+    std::lock_guard<std::mutex> lock(sync_mutex);
+    written_index = LastLogIndex();
+    written_fd = segments.empty() ? -1 : fileno(segments.back().file);
+    durable_index = std::min(durable_index, written_index);
+}
+
+
+bool PersistentLog::Sync(int index) {
+    if (!sync_writes) return true;
+
+    std::unique_lock<std::mutex> lock(sync_mutex);
+    while (durable_index < index && index <= written_index) {
+        if (sync_in_progress) {
+            // our entry will be covered by the sync after this one
+            sync_cv.wait(lock);
+            continue;
+        }
+        sync_in_progress = true;
+        int sync_index = written_index;
+        int sync_fd = written_fd;
+        lock.unlock();
+
+        // one fdatasync covers every entry appended since the last sync, the
+        // segments before the active one were synced when they were sealed
+        bool synced = Util::SyncFileData(sync_fd);
+
+        lock.lock();
+        if (synced) {
+            debug("synced log through index %d", sync_index);
+            durable_index = std::max(durable_index, sync_index);
+        }
+        sync_in_progress = false;
+        sync_cv.notify_all();
+        if (!synced) {
+            warn("Error: failed to sync log through index %d", index);
+            return false;
+        }
     }
-    warn("Error: failed to update cursor location, cursor: %d", cursor);
-    return false;
+    return durable_index >= index;
 }
 
 
-bool PersistentLog::AddLogEntry(const void* log_data, int log_data_len) {
-    struct LogEntry current_entry;
-    current_entry.data = NULL;
-    current_entry.len = log_data_len;
-    current_entry.offset = cursor;
+int PersistentLog::DurableLogIndex() {
+    if (!sync_writes) return LastLogIndex();
+    std::lock_guard<std::mutex> lock(sync_mutex);
+    return durable_index;
+}
+
 
-    int success = fseek(log_file, cursor, SEEK_SET); // to make sure we're in right location
+bool PersistentLog::WriteLogEntry(int offset, int index, const void* log_data, int log_data_len) {
+    FILE *log_file = segments.back().file;
+    int success = fseek(log_file, offset, SEEK_SET); // to make sure we're in right location
     if (success != 0) {
         warn("Error: fseek failed to move to move to a new file offset, %s (%d)", strerror(errno), errno);
         return false;
     }
-    int wrote_bytes = fwrite(&log_data_len, 1, sizeof(int), log_file);
-    if (wrote_bytes != sizeof(int)) {
-        warn("Error: fwrite failed to write int bytes to log file, %s (%d)", strerror(errno), errno);
+    struct LogRecordHeader header;
+    header.index = index;
+    header.len = log_data_len;
+    header.crc = Util::Crc32c(Util::Crc32c(0, &header.index,
+        sizeof(header) - sizeof(header.crc)), log_data, log_data_len);
+    int wrote_bytes = fwrite(&header, 1, sizeof(header), log_file);
+    if (wrote_bytes != sizeof(header)) {
+        warn("Error: fwrite failed to write record header to log file, %s (%d)", strerror(errno), errno);
         return false;
     }
     wrote_bytes = fwrite(log_data, 1, log_data_len, log_file);
@@ -143,90 +510,301 @@ bool PersistentLog::AddLogEntry(const void* log_data, int log_data_len) {
         warn("Error: fwrite failed to write log_data_len bytes to log, %s (%d)", strerror(errno), errno);
         return false;
     }
-    wrote_bytes = fwrite(&log_data_len, 1, sizeof(int), log_file);
-    if (wrote_bytes != sizeof(int)) {
-        warn("Error: fwrite failed to write int bytes to log file, %s (%d)", strerror(errno), errno);
+    return true;
+}
+
+
+bool PersistentLog::ClearLogRecords(struct LogSegment& segment, int start, int end) {
+    static const char zeros[4096] = {0};
+    FILE *log_file = segment.file;
+    int success = fseek(log_file, start, SEEK_SET);
+    if (success != 0) {
+        warn("Error: fseek failed to move to move to a new file offset, %s (%d)", strerror(errno), errno);
         return false;
     }
+    int remaining = end - start;
+    while (remaining > 0) {
+        int chunk = std::min(remaining, (int) sizeof(zeros));
+        if (fwrite(zeros, 1, chunk, log_file) != (size_t) chunk) {
+            warn("Error: fwrite failed to clear log record, %s (%d)", strerror(errno), errno);
+            return false;
+        }
+        remaining -= chunk;
+    }
     success = fflush(log_file);
     if (success != 0) {
         warn("Error: fflush failed to push all writes to disk, %s (%d)", strerror(errno), errno);
         return false;
     }
+    return true;
+}
 
-    success = MoveCursor(log_data_len + (sizeof(int) * 2));
-    if (!success) {
-        warn("failed to move cursor safely, %s (%d)", strerror(errno), errno);
-        return false;
+
+bool PersistentLog::AddLogEntry(const void* log_data, int log_data_len) {
+    std::vector<std::string> new_entries;
+    new_entries.push_back(std::string((const char *) log_data, log_data_len));
+    return AddLogEntries(new_entries);
+}
+
+
+bool PersistentLog::AddLogEntries(const std::vector<std::string>& new_entries) {
+    size_t next_entry = 0;
+    while (next_entry < new_entries.size()) {
+        int framed_len = new_entries[next_entry].length() + sizeof(struct LogRecordHeader);
+        if (cursor.offset + framed_len > segments.back().size &&
+                !RollSegment(framed_len)) {
+            warn("failed to roll over to a new segment, %s (%d)", strerror(errno), errno);
+            return false;
+        }
+
+        // write every entry that fits in the active segment
+        std::vector<struct LogIndexEntry> added_entries;
+        struct LogPosition position = cursor;
+        while (next_entry < new_entries.size()) {
+            const std::string& log_data = new_entries[next_entry];
+            framed_len = log_data.length() + sizeof(struct LogRecordHeader);
+            if (position.offset + framed_len > segments.back().size) break;
+
+            struct LogIndexEntry current_entry;
+            current_entry.segment = position.segment;
+            current_entry.offset = position.offset;
+            current_entry.len = log_data.length();
+            int index = LastLogIndex() + 1 + added_entries.size();
+            if (!WriteLogEntry(position.offset, index, log_data.data(), current_entry.len)) {
+                return false;
+            }
+            position.offset += framed_len;
+            added_entries.push_back(current_entry);
+            next_entry += 1;
+        }
+        int success = fflush(segments.back().file);
+        if (success != 0) {
+            warn("Error: fflush failed to push all writes to disk, %s (%d)", strerror(errno), errno);
+            return false;
+        }
+
+        cursor = position;
+        log_entries.insert(log_entries.end(), added_entries.begin(), added_entries.end());
+        PublishWrites();
     }
-    log_entries.push_back(current_entry);
     return true;
 }
 
 
-bool PersistentLog::RemoveLogEntry() {
-    int prev_entry_size;
-    int success = fseek( log_file, cursor - sizeof(int), SEEK_SET);
-    if (success != 0) {
-        warn("Error: fseek failed to move to move to a new file offset, %s (%d)", strerror(errno), errno);
-        return false;
-    }
-    int read_bytes = fread( &prev_entry_size, 1, sizeof(int), log_file);
-    if (read_bytes != sizeof(int)) {
-        warn("Error: fread failed to read int bytes from log file, %s (%d)", strerror(errno), errno);
+bool PersistentLog::TruncateSuffix(int index) {
+    // the log must keep at least one entry to know where it starts on reopen
+    if (index <= first_log_index || index > LastLogIndex()) {
+        warn("Error: can't truncate log at %d, log is [%d, %d]", index, first_log_index, LastLogIndex());
         return false;
     }
+    struct LogIndexEntry first_removed = log_entries[index - first_log_index];
+    struct LogSegment& segment = GetSegment(first_removed.segment);
+    int segment_end = (segment.end == -1) ? cursor.offset : segment.end;
 
-    bool moved = MoveCursor(-1 * (prev_entry_size + (sizeof(int) * 2)));
-    if (!moved) {
-        warn("Failed to back up cursor, entry not deleted. cursor: %d", cursor);
+    std::unique_lock<std::mutex> lock(sync_mutex);
+    // a running sync could still be syncing a segment we're about to delete
+    while (sync_in_progress) {
+        sync_cv.wait(lock);
+    }
+    // zeroing the records removes them, later segments are simply dropped
+    if (!ClearLogRecords(segment, first_removed.offset, segment_end)) {
+        warn("Failed to clear records, entries from %d not deleted", index);
         return false;
     }
+    cursor = {first_removed.segment, first_removed.offset};
+    debug("moved cursor to %d:%d", cursor.segment, cursor.offset);
+    if (cursor.segment != segments.back().number) {
+        // segments past the end are dropped on reopen even if this fails
+        RemoveSegmentsAfter(cursor.segment);
+    }
+
     //free if we had saved log into memory for client use
-    struct LogEntry delete_entry = log_entries.back();
-    if (delete_entry.data != NULL) {
-        delete(delete_entry.data);
+    std::vector<int> removed_cached_entries;
+    for (auto& cached : cache) {
+        if (cached.first >= index) {
+            removed_cached_entries.push_back(cached.first);
+        }
+    }
+    for (int removed_index : removed_cached_entries) {
+        RemoveCachedLogEntry(removed_index);
     }
-    log_entries.pop_back();
+    log_entries.resize(index - first_log_index);
+    // publish before releasing the lock, so no sync sees the removed entries
+    written_index = LastLogIndex();
+    durable_index = std::min(durable_index, written_index);
     return true;
 }
 
 
 const struct LogEntry PersistentLog::GetLogEntryByIndex(int index) {
-        if (log_entries.size() <= index) {
-            debug("index %d is not in log, too large", index);
-            struct LogEntry current_entry;
-            current_entry.data = NULL;
+        struct LogEntry current_entry;
+        current_entry.data = NULL;
+        if (index < first_log_index || index > LastLogIndex()) {
+            debug("index %d is not in log", index);
             current_entry.len = -1;
             current_entry.offset = -1;
+            current_entry.segment = -1;
+            return current_entry;
+        }
+        struct LogIndexEntry index_entry = log_entries[index - first_log_index];
+        current_entry.len = index_entry.len;
+        current_entry.offset = index_entry.offset;
+        current_entry.segment = index_entry.segment;
+        struct LogSegment& segment = GetSegment(index_entry.segment);
+        if (segment.map != NULL) {
+            current_entry.data = segment.map + index_entry.offset +
+                sizeof(struct LogRecordHeader);
+            cache_hits += 1;
             return current_entry;
         }
-        struct LogEntry current_entry = log_entries[index];
+        TrimCache();
+        current_entry.data = LookupCachedLogEntry(index);
         if (current_entry.data != NULL) {
             debug("Entry already loaded : %s", current_entry.data);
             return current_entry;
         }
-        int success = fseek(log_file, current_entry.offset + sizeof(int), SEEK_SET); // to make sure we're in right location
+        FILE *log_file = segment.file;
+        int success = fseek(log_file, index_entry.offset + sizeof(struct LogRecordHeader), SEEK_SET); // to make sure we're in right location
         if (success != 0) {
             warn("Error: fseek failed to move to move to a new file offset, %s (%d)", strerror(errno), errno);
             return current_entry; // NULL data
         }
 
-        char *buffer = new char[current_entry.len + 1];
-        buffer[current_entry.len] = '\0';
-        int read_bytes = fread( buffer, 1, current_entry.len, log_file);
-        if (read_bytes != current_entry.len) {
+        char *buffer = new char[index_entry.len + 1];
+        buffer[index_entry.len] = '\0';
+        int read_bytes = fread( buffer, 1, index_entry.len, log_file);
+        if (read_bytes != index_entry.len) {
             warn("Error: fread failed to read int bytes from log file, %s (%d)", strerror(errno), errno);
+            delete[] buffer;
             return current_entry; // NULL data
         }
         debug("Entry Loaded : %s", buffer);
+        CacheLogEntry(index, buffer, index_entry.len);
         current_entry.data = buffer;
-        log_entries[index] = current_entry;
         return current_entry;
 }
 
-int PersistentLog::LastLogIndex() {
-    return log_entries.size() - 1;
+std::vector<struct LogEntry> PersistentLog::GetLogEntriesByRange(int first_index,
+        int max_count, int max_bytes) {
+    std::vector<struct LogEntry> range;
+    if (first_index < first_log_index || first_index > LastLogIndex()) {
+        debug("index %d is not in log", first_index);
+        return range;
+    }
+
+    // size the range from the in-memory index, no disk access needed
+    int first_position = first_index - first_log_index;
+    int segment = log_entries[first_position].segment;
+    int last_position = first_position;
+    int range_bytes = log_entries[first_position].len;
+    while (last_position + 1 < (int) log_entries.size() &&
+            log_entries[last_position + 1].segment == segment &&
+            last_position + 1 - first_position < max_count &&
+            range_bytes + log_entries[last_position + 1].len <= max_bytes) {
+        last_position += 1;
+        range_bytes += log_entries[last_position].len;
+    }
+    int last_index = first_log_index + last_position;
+
+    struct LogSegment& range_segment = GetSegment(segment);
+    if (range_segment.map == NULL) {
+        TrimCache();
+    }
+    // the entries are contiguous on disk, so read any we need in one go
+    FILE *log_file = range_segment.file;
+    int range_start = log_entries[first_position].offset;
+    int range_end = log_entries[last_position].offset +
+        log_entries[last_position].len + sizeof(struct LogRecordHeader);
+    char *range_buffer = NULL;
+    for (int index = first_index; index <= last_index; index++) {
+        struct LogIndexEntry index_entry = log_entries[index - first_log_index];
+        struct LogEntry current_entry;
+        current_entry.len = index_entry.len;
+        current_entry.offset = index_entry.offset;
+        current_entry.segment = index_entry.segment;
+        if (range_segment.map != NULL) {
+            current_entry.data = range_segment.map + index_entry.offset +
+                sizeof(struct LogRecordHeader);
+            cache_hits += 1;
+            range.push_back(current_entry);
+            continue;
+        }
+        current_entry.data = LookupCachedLogEntry(index);
+        if (current_entry.data == NULL) {
+            if (range_buffer == NULL) {
+                range_buffer = new char[range_end - range_start];
+                int success = fseek(log_file, range_start, SEEK_SET);
+                int read_bytes = fread(range_buffer, 1, range_end - range_start, log_file);
+                if (success != 0 || read_bytes != range_end - range_start) {
+                    warn("Error: failed to read log range [%d, %d], %s (%d)", first_index, last_index, strerror(errno), errno);
+                    delete[] range_buffer;
+                    return range;
+                }
+            }
+            char *buffer = new char[index_entry.len + 1];
+            buffer[index_entry.len] = '\0';
+            memcpy(buffer, range_buffer + (index_entry.offset - range_start) +
+                sizeof(struct LogRecordHeader), index_entry.len);
+            CacheLogEntry(index, buffer, index_entry.len);
+            current_entry.data = buffer;
+        }
+        range.push_back(current_entry);
+    }
+    if (range_buffer != NULL) {
+        delete[] range_buffer;
+    }
+    return range;
+}
+
+bool PersistentLog::CompactPrefix(int index) {
+    // keep the segment holding the first entry after index (or the last
+    // entry, if index covers the whole log), and everything after it
+    int keep_position = std::min(index + 1, LastLogIndex()) - first_log_index;
+    if (keep_position <= 0) return true;
+    int keep_segment = log_entries[keep_position].segment;
+    if (keep_segment == segments.front().number) return true;
+
+    std::vector<struct LogSegment> removed_segments(segments.begin(),
+        segments.begin() + (keep_segment - segments.front().number));
+    segments.erase(segments.begin(), segments.begin() + removed_segments.size());
+    // the manifest goes first, so a crash never leaves it listing missing files
+    if (!WriteManifest()) {
+        segments.insert(segments.begin(), removed_segments.begin(), removed_segments.end());
+        return false;
+    }
+    for (struct LogSegment& segment : removed_segments) {
+        CloseSegment(segment);
+        unlink(SegmentFilename(segment.number).c_str());
+    }
+
+    // segments hold consecutive entries, so find where the kept ones start
+    int removed_entries = 0;
+    while (log_entries[removed_entries].segment != keep_segment) {
+        removed_entries += 1;
+    }
+    std::vector<int> removed_cached_entries;
+    for (auto& cached : cache) {
+        if (cached.first < first_log_index + removed_entries) {
+            removed_cached_entries.push_back(cached.first);
+        }
+    }
+    for (int removed_index : removed_cached_entries) {
+        RemoveCachedLogEntry(removed_index);
+    }
+    log_entries.erase(log_entries.begin(), log_entries.begin() + removed_entries);
+    first_log_index += removed_entries;
+    debug("compacted log through index %d, %zu segments left", first_log_index - 1, segments.size());
+    return true;
+}
+
+bool PersistentLog::IsOpen() {
+    return open;
 }
 
+int PersistentLog::FirstLogIndex() {
+    return first_log_index;
+}
 
+int PersistentLog::LastLogIndex() {
+    return first_log_index + log_entries.size() - 1;
+}
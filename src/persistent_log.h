@@ -1,36 +1,107 @@
 #pragma once
 
+#include <stdint.h>
 #include <stdio.h>
 #include <unistd.h>
 #include <errno.h>
+#include <sys/mman.h>
+#include <condition_variable>
 #include <cstring>
 #include <iostream>
+#include <list>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "log.h"
 #include "util.h"
 
+static const int LOG_SEGMENT_SIZE = 64 * 1024 * 1024; // bytes
+static const long LOG_CACHE_BYTES = 64 * 1024 * 1024; // bytes
+
 /**
  * Struct describing a particular log entry, including:
  * - the content of the log entry
  * - the length of that content
- * - the byte-offset into log where the data associated with this entry begins
+ * - the byte-offset into its segment where the record for this entry begins
+ * - the number of the segment file holding the entry
  */
 struct LogEntry {
     char *data;
     int len;
     int offset;
+    int segment;
+};
+
+/**
+ * Where a particular log entry is on disk: the number of the segment holding
+ * it, the byte-offset of its record in that segment & the length of its data.
+ * One of these is kept in memory for every entry, so there is no room for
+ * the data itself.
+ */
+struct LogIndexEntry {
+    int segment;
+    int offset;
+    int len;
+};
+
+/**
+ * A location in the log: a byte-offset into the segment with the given number.
+ */
+struct LogPosition {
+    int segment;
+    int offset;
+};
+
+/**
+ * Header of each record in a segment, followed by len bytes of entry data.
+ * crc is the CRC32C of the rest of the header & the data, and index is the
+ * entry's index in the log, so a scan can tell where the valid records end
+ * without any other metadata.
+ */
+struct LogRecordHeader {
+    uint32_t crc;
+    int index;
+    int len;
+};
+
+/**
+ * Struct describing one segment file of the log.  Segments are preallocated
+ * (with zeros) to size bytes so appends don't have to grow the file.  end is
+ * the end of the records in a full (sealed) segment, and -1 for the active
+ * segment, whose end is the cursor.  Everything past the end of the log is
+ * kept zeroed, so a scan always stops there.  map is a read-only mapping of
+ * the whole segment, or NULL if it couldn't be mapped.
+ */
+struct LogSegment {
+    int number;
+    FILE *file;
+    char *map;
+    int size;
+    int end;
 };
 
 class PersistentLog {
     public:
         /*
          * Reloads a persistent log with the prefix specified by filename.  If
-         * none is present, creates 2 files: filename + _log & filename + _cursor
-         * and initializes the log to be empty.
+         * none is present, creates a manifest (filename + _manifest) & a first
+         * segment (filename + _log.0) and initializes the log to be empty.  Further segments are created as
+         * the log grows, each LOG_SEGMENT_SIZE bytes (or larger, for an entry
+         * that wouldn't fit otherwise).  A log in the older single-file format
+         * (filename + _log & filename + _cursor) is migrated into segments.
+         * Whether the log could be opened is told by IsOpen().
+         *
+         * If sync_writes is true, appended entries only become durable (and
+         * survive a power loss) once Sync() has covered them; otherwise every
+         * write is merely flushed to the kernel.
+         *
+         * cache_budget bounds the bytes of entry copies kept in memory for
+         * segments that couldn't be mapped.
          */
-        PersistentLog(const char *filename);
+        PersistentLog(const char *filename, bool sync_writes = false,
+            long cache_budget = LOG_CACHE_BYTES);
         /*
          * Cleans up temporary information used by persistent log for performance,
          * but leaves the persistent log intacted.
@@ -38,7 +109,12 @@ class PersistentLog {
         ~PersistentLog();
         /*
          * Returns the index-th entry in the log, if present.  If not present,
-         * returns a log entry with -1 size & NULL entry pointer.
+         * returns a log entry with -1 size & NULL entry pointer.  The data
+         * points straight into the mapped segment (no copy, no syscall), or
+         * to a cached copy read from disk if the segment couldn't be mapped.
+         * A copy may be evicted by the next read, so the data is only valid
+         * until the next call on this log.  It is only len bytes long (not
+         * NUL-terminated).
          *
          * @return LogEntry containing a pointer to the entry & its length
          */
@@ -53,19 +129,115 @@ class PersistentLog {
          */
         bool AddLogEntry(const void* log_data, int log_data_len);
         /*
-         * Removes the last entry from the end of our persistent log.
+         * Appends several entries to the end of our persistent log with a
+         * single write & flush, so a batch costs about the same as one entry.
+         *
+         * @param new_entries - entries to be appended, in log order
          *
-         * @return bool - true if successfully removed entry from persistent log
+         * @return bool - true if all entries were successfully appended
          */
-        bool RemoveLogEntry();
+        bool AddLogEntries(const std::vector<std::string>& new_entries);
+        /*
+         * Returns consecutive entries starting at first_index, stopping at the
+         * end of the log or once adding another entry would exceed max_count
+         * entries or max_bytes bytes of entry data.  At least one entry is
+         * returned if first_index is in the log.  The range also stops at the
+         * end of the first entry's segment.  Like GetLogEntryByIndex(), data
+         * points into the mapped segment; without a mapping, entries not
+         * already in memory are read with a single read covering the range.
+         *
+         * @param first_index - index of the first entry to return
+         * @param max_count - maximum number of entries to return
+         * @param max_bytes - maximum total length of the returned entries
+         *
+         * @return vector of LogEntry, each containing a pointer to the entry
+         */
+        std::vector<struct LogEntry> GetLogEntriesByRange(int first_index,
+            int max_count, int max_bytes);
+        /*
+         * Removes the entry at index & every entry after it, however many,
+         * with a single write clearing their records & at most one manifest
+         * update (when whole segments are dropped).  The first entry of the
+         * log can't be removed.  Like appends, the removal is made durable by
+         * the next Sync().
+         *
+         * @param index - first entry to remove
+         *
+         * @return bool - true if the entries were removed from the log
+         */
+        bool TruncateSuffix(int index);
+        /*
+         * Discards a prefix of the log that is covered by a snapshot, e.g.
+         * everything up to & including index.  Whole segments are deleted, so
+         * the log may still start a little before index + 1, and the segment
+         * holding the last entry is always kept.  Indexes of the remaining
+         * entries don't change.
+         *
+         * @param index - last entry that may be discarded
+         *
+         * @return bool - true if the log no longer needs the discarded segments
+         */
+        bool CompactPrefix(int index);
         /*
          * Resets the log to be completely empty
          */
         bool ResetLog();
+        /*
+         * Discards the whole log and starts it again with a single entry at
+         * index, e.g. the last entry covered by a snapshot installed from
+         * another server
+         *
+         * @param index - index of the new first entry
+         * @param log_data - data of the new first entry
+         * @param log_data_len - length of log_data
+         *
+         * @return bool - true if the log was reset
+         */
+        bool ResetLog(int index, const void* log_data, int log_data_len);
+        /*
+         * Returns whether the constructor opened or created the log; if not,
+         * the log must not be used
+         */
+        bool IsOpen();
+        /*
+         * Returns the lowest index still in the log, which is 0 until a
+         * prefix is compacted
+         */
+        int FirstLogIndex();
         /*
          * Returns the highest current index in the log
          */
         int LastLogIndex();
+        /*
+         * Blocks until every entry up to and including index is on disk.  A
+         * single fdatasync covers all entries appended since the previous
+         * sync, so threads that call this while a sync is running wait for
+         * the next one and are released together.  Safe to call without
+         * holding the lock that serializes appends.  Returns immediately
+         * when the log was not opened with sync_writes.
+         *
+         * @param index - last index that must be durable
+         *
+         * @return bool - true if the entry is durable, false if the sync
+         *      failed or the entry was removed from the log
+         */
+        bool Sync(int index);
+        /*
+         * Returns the highest index known to be durable.  Without sync_writes,
+         * this is the same as LastLogIndex().
+         */
+        int DurableLogIndex();
+        /*
+         * Counters of entry reads by GetLogEntryByIndex() &
+         * GetLogEntriesByRange(): reads served from memory (a mapped segment,
+         * or a cached copy), reads that had to go to disk, and bytes of entry
+         * data currently cached.  The cache is only a fallback for segments
+         * that couldn't be mapped (mmap failed), so with every segment
+         * mapped there are no misses & nothing is cached.
+         */
+        long CacheHits();
+        long CacheMisses();
+        long CacheBytes();
 
     private:
 
@@ -76,59 +248,192 @@ class PersistentLog {
          * @return bool - true if successfully reopened/created the persistent log
          */
         bool ReopenLog();
+        /*
+         * Copies every entry of a log in the older single-file format (a
+         * file of [length][data][length] records, ending at the offset held
+         * in the cursor file) into a fresh segmented log.  The old files are
+         * only deleted once the copy is durable, so a crash part way through
+         * just migrates again on the next start.
+         *
+         * @return bool - true if the log was migrated, false if the old files
+         *      couldn't be read (they are left alone)
+         */
+        bool MigrateLegacyLog();
+        /*
+         * Returns the name of the cursor file of the older single-file format,
+         * whose log file had the name now used as the prefix of segments
+         */
+        std::string LegacyCursorFilename();
         /*
          * Loads into memory information about the log.  Because we are restoring
-         * from disk, this scans over the full log.  Used for more efficient
-         * manipulation of the log (to avoid constant disk seeking).
+         * from disk, this scans over the full log, which ends at the first
+         * record whose index or checksum doesn't match.  Used for more
+         * efficient manipulation of the log (to avoid constant disk seeking).
          *
          * @return bool - whether we successfully scanned the log info into memory
          */
         bool LoadIndexFromLog();
         /*
-         * Persistently updates the cursor file and cursor, effectively adding
-         * or removing bytes from the file.  Cursor specifies the active "end"
-         * of the log, any subsequent bytes are garbage
+         * Writes the record for the entry with the given index at the given
+         * offset into the active segment, without flushing or moving the
+         * cursor.
+         *
+         * @return bool - whether all bytes of the record were written
+         */
+        bool WriteLogEntry(int offset, int index, const void* log_data, int log_data_len);
+        /*
+         * Overwrites the bytes [start, end) of a segment with zeros, so a scan
+         * of the log stops before any record that was there.
+         *
+         * @return bool - whether the records were cleared
+         */
+        bool ClearLogRecords(struct LogSegment& segment, int start, int end);
+        /*
+         * Opens the segment file with the given number & adds it to the end
+         * of segments.  If create is set, the file is (re)created and
+         * preallocated to size bytes.
+         *
+         * @return bool - whether the segment was opened
+         */
+        bool OpenSegment(int number, int size, bool create);
+        /*
+         * Unmaps & closes a segment file, without deleting it.
+         */
+        void CloseSegment(struct LogSegment& segment);
+        /*
+         * Seals the active segment at the cursor & starts appending to a new,
+         * preallocated segment of at least min_size bytes.
+         *
+         * @return bool - whether the new segment is ready for appends
+         */
+        bool RollSegment(int min_size);
+        /*
+         * Closes & deletes every segment after the one with the given number,
+         * which becomes the active segment again.  The caller must hold
+         * sync_mutex with no sync in progress.
+         *
+         * @return bool - whether the manifest was updated
+         */
+        bool RemoveSegmentsAfter(int number);
+        /*
+         * Persistently records the current list of segments & where each
+         * sealed segment ends.
          *
-         * @return bool - whether we successfully & persistently moved the cursor
+         * @return bool - whether the manifest was updated
+         */
+        bool WriteManifest();
+        /*
+         * Returns the name of the segment file with the given number.
          */
-        bool MoveCursor(int distance);
+        std::string SegmentFilename(int number);
         /*
-         * Removes any lazily-created in-memory representations of the log entries
+         * Returns the segment with the given number, which must be in the log.
+         */
+        struct LogSegment& GetSegment(int number);
+        /*
+         * Removes any in-memory copies of log entries read from segments that
+         * couldn't be mapped
          */
         void RemoveCachedLogEntries();
+        /*
+         * Returns the cached copy of the index-th entry & marks it as most
+         * recently used, or NULL if it isn't cached.
+         */
+        char *LookupCachedLogEntry(int index);
+        /*
+         * Caches a copy of the index-th entry, taking ownership of data.
+         */
+        void CacheLogEntry(int index, char *data, int len);
+        /*
+         * Frees the cached copy of the index-th entry, if any.
+         */
+        void RemoveCachedLogEntry(int index);
+        /*
+         * Evicts least recently used copies until the cache is within budget.
+         * Only called at the start of a read, so copies handed out by one
+         * call stay valid until the next.
+         */
+        void TrimCache();
+        /*
+         * Makes the current end of the log visible to Sync(), must be called
+         * after every change to the log
+         */
+        void PublishWrites();
 
         /*
-         * Name of persistent cursor file, necessary to enable safe adding/removing
-         * from the file
+         * Name of persistent manifest file, which lists the segments of the log
          */
-        const char *cursor_filename;
+        const char *manifest_filename;
 
         /*
-         * Name of persistent log file, which contains the log entries & metadata
+         * Prefix of the segment file names, the segment number is appended to it
          */
         const char *log_filename;
         /*
-         * A handle to the persistent log file, should be open during normal
-         * operation to avoid overhead of closing/opening constantly.
+         * Whether the log was opened, see IsOpen()
          */
-        FILE *log_file;
+        bool open;
         /*
-         * A handle to the persistent cursor file, may be open during normal
-         * operation, though regularly closed to atomically move cursor
+         * Segments of the log, oldest first, with consecutive numbers.  Each
+         * is kept open & mapped during normal operation to avoid overhead of
+         * closing/opening constantly.  Only the last one is appended to,
+         * through its FILE*; the mapping sees those writes once flushed.
          */
-        FILE *cursor_file;
+        std::vector<struct LogSegment> segments;
         /*
-         * Current cursor location, should match cursor_filename body at any time
-         * other than initialization or in the midst of a crash.
+         * Current cursor location, where the next record will be written.
          */
-        int cursor;
+        struct LogPosition cursor;
 
         /*
          * In-memory representation of the log.  Because the log may be large, we
-         * only lazily populate log content (which is subsequently tracked and
-         * freed during destruction, so client doesn't have to free)
+         * only keep where each entry is; content is read through the segment
+         * mappings.
+         */
+        std::vector<struct LogIndexEntry> log_entries;
+        /*
+         * Index of the entry at the front of log_entries
+         */
+        int first_log_index;
+
+        /*
+         * LRU cache of copies of entries from segments that couldn't be
+         * mapped, keyed by index.  cache_lru holds the cached indexes, most
+         * recently used first, and cache_bytes the total length of the copies,
+         * kept within cache_budget by TrimCache().  Copies are freed on
+         * eviction, removal of the entry, or destruction, so client doesn't
+         * have to free.
          */
-        std::vector<struct LogEntry> log_entries;
+        struct CachedLogEntry {
+            char *data;
+            int len;
+            std::list<int>::iterator lru_position;
+        };
+        std::unordered_map<int, struct CachedLogEntry> cache;
+        std::list<int> cache_lru;
+        long cache_bytes;
+        long cache_budget;
+        long cache_hits;
+        long cache_misses;
 
+        /*
+         * Whether appends must be made durable with Sync().
+         */
+        bool sync_writes;
+        /*
+         * Sync scheduler state, guarded by sync_mutex.  written_index &
+         * written_fd (the active segment's file descriptor, used to sync
+         * without touching the FILE* that appends are using) describe the
+         * end of the log as of the last publish, and durable_index is the
+         * last entry covered by a completed sync.  Entries are only removed
+         * while no sync is in progress, so a sync never uses the file
+         * descriptor of a deleted segment.
+         */
+        int written_index;
+        int written_fd;
+        int durable_index;
+        bool sync_in_progress;
+        std::mutex sync_mutex;
+        std::condition_variable sync_cv;
 
 };
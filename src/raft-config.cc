@@ -47,14 +47,38 @@ void RaftConfig::parse(int my_server_id) {
     }
 
     int num_servers = servers_ports.size();
+    if (my_server_id < 0 || my_server_id >= num_servers) {
+        throw RaftConfigException("No config line for server id " +
+            to_string(my_server_id));
+    }
+    // Either every server lists a port per peer, or just one shared port
+    bool per_peer_ports = all_of(servers_ports.begin(), servers_ports.end(),
+        [num_servers](vector<unsigned short>& ports) {
+            return (int) ports.size() == num_servers - 1;
+        });
+    bool shared_ports = all_of(servers_ports.begin(), servers_ports.end(),
+        [](vector<unsigned short>& ports) { return ports.size() == 1; });
+    if (!per_peer_ports && !shared_ports) {
+        throw RaftConfigException("Invalid config: each server must list "
+            "either one peer port, or one for each other server");
+    }
+
     for (int server_id = 0; server_id < num_servers; server_id++) {
         if (server_id == my_server_id) {
             continue;
         }
 
         PeerInfo peer_info;
-        peer_info.my_listen_port = servers_ports[my_server_id][peer_infos.size()];
+        peer_info.server_id = server_id;
         peer_info.destination_ip_addr = server_infos[server_id].ip_addr;
+        peer_info.shared_listen_port = !per_peer_ports;
+        if (peer_info.shared_listen_port) {
+            peer_info.my_listen_port = servers_ports[my_server_id][0];
+            peer_info.destination_port = servers_ports[server_id][0];
+            peer_infos.push_back(peer_info);
+            continue;
+        }
+        peer_info.my_listen_port = servers_ports[my_server_id][peer_infos.size()];
 
         vector<unsigned short> dest_server_ports = servers_ports[server_id];
 
@@ -18,10 +18,22 @@
  * cluster, each server needs to open two additional ports to receive
  * connections from the other servers in the cluster.
  *
+ * Alternatively, each server can list a single peer port:
+ *
+ *     127.0.0.1 4000 4001
+ *     127.0.0.1 5000 5001
+ *     127.0.0.1 6000 6001
+ *
+ * Every server then accepts connections from all of its peers on that port,
+ * and each pair of servers shares one connection in both directions. The
+ * connecting server identifies itself by sending its server id first. (With
+ * two servers, both forms look the same, and the one-port-per-peer form is
+ * assumed.)
+ *
  * Lines which are prefixed with a hash character (#) are considered comments.
  *
- * See the Peer class documentation for more information about why one listening
- * port per peer is required.
+ * See the Peer class documentation for more information about the trade-offs
+ * between the two forms.
  */
 
 #pragma once
@@ -53,8 +65,13 @@ struct ServerInfo {
  * to. Peers are specified via destination_ip_addr and destination_port. The
  * port on which this server will listen for a incoming connection from this
  * peer is specified as my_listen_port.
+ *
+ * If shared_listen_port is set, my_listen_port and destination_port are the
+ * single peer ports of this server and the peer, shared by all their peers.
  */
 struct PeerInfo {
+    int server_id;
+    bool shared_listen_port;
     string destination_ip_addr;
     unsigned short destination_port;
     unsigned short my_listen_port;
@@ -86,9 +103,9 @@ class RaftConfig {
          * The given `my_server_id` parameter is used to determine which peer
          * connection information should be used to connect to the other peers
          * in the cluster, as this information is different for each peer
-         * because of our unique design where each server creates a listening
-         * port for each of the other peers in the cluster. See the Peer class
-         * documentation for more information about this design.
+         * when each server creates a listening port for each of the other
+         * peers in the cluster. See the Peer class documentation for more
+         * information about this design.
          *
          * @throws RaftConfigException
          *
@@ -1,31 +1,104 @@
 #include "raft-server.h"
 
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <google/protobuf/wire_format_lite.h>
+
+/**
+ * Options for an arena that allocates from the given block until it's full.
+ */
+static google::protobuf::ArenaOptions ArenaOptionsWithBlock(char* block,
+        size_t block_size) {
+    google::protobuf::ArenaOptions options;
+    options.initial_block = block;
+    options.initial_block_size = block_size;
+    return options;
+}
+
 RaftServer::RaftServer(int server_id, vector<ServerInfo> server_infos,
-    vector<PeerInfo> peer_infos) : server_id(server_id),
-    server_infos(server_infos), peer_infos(peer_infos),
-    storage(to_string(server_id) + STORAGE_NAME_SUFFIX),
-    persistent_log((to_string(server_id) + STORAGE_NAME_SUFFIX).c_str()),
-    committed_index() {}
+    vector<PeerInfo> peer_infos, bool sync_writes, PeerOptions peer_options) :
+    server_id(server_id), server_infos(server_infos), peer_infos(peer_infos),
+    peer_options(peer_options),
+    storage(to_string(server_id) + STORAGE_NAME_SUFFIX, sync_writes),
+    persistent_log((to_string(server_id) + STORAGE_NAME_SUFFIX).c_str(),
+        sync_writes),
+    committed_index(),
+    receive_arena(ArenaOptionsWithBlock(receive_arena_block,
+        sizeof(receive_arena_block))),
+    send_arena(ArenaOptionsWithBlock(send_arena_block,
+        sizeof(send_arena_block))) {}
+
+RaftServer::~RaftServer() {
+    {
+        lock_guard<mutex> lock(server_mutex);
+        apply_stopped = true;
+        apply_cv.notify_one();
+    }
+    if (apply_thread.joinable()) {
+        apply_thread.join();
+    }
+}
 
 void RaftServer::Run() {
+    if (!persistent_log.IsOpen()) {
+        throw RaftStorageException("Failed to open log: " +
+            to_string(server_id) + STORAGE_NAME_SUFFIX);
+    }
     storage.Load();
     //at start, say we've only committed what we've already applied
     committed_index = storage.last_applied();
-
+    applied_index = storage.last_applied();
+    saved_applied_index = applied_index;
+    saved_applied_time = steady_clock::now();
+    if (persistent_log.LastLogIndex() < storage.snapshot_index() &&
+            !ResetLogToSnapshot()) {
+        // We crashed while installing a snapshot, before the log caught up
+        error("failed to reset log to snapshot at %d", storage.snapshot_index());
+    }
 
     info("TERM: %d", storage.current_term());
     info("STATE: %s", ServerStateStrings[Follower].c_str());
 
+    // Until a peer tells us otherwise, it gets PeerMessages only
+    peer_accepts_frames.assign(peer_infos.size(), false);
     for (int i = 0; i < peer_infos.size(); i++) {
         PeerInfo peer_info = peer_infos[i];
-        Peer *peer = new Peer(peer_info.my_listen_port,
-            peer_info.destination_ip_addr, peer_info.destination_port,
-            [this](Peer* peer, char* raw_message, int raw_message_len) {
-                HandlePeerMessage(peer, raw_message, raw_message_len);
-            });
+        auto callback = [this](Peer* peer, const char* raw_message, int raw_message_len) {
+            HandlePeerMessage(peer, raw_message, raw_message_len);
+        };
+        Peer *peer;
+        if (peer_info.shared_listen_port) {
+            // the lower server id of each pair connects
+            peer = new Peer(server_id, server_id < peer_info.server_id,
+                peer_info.destination_ip_addr, peer_info.destination_port,
+                peer_event_loop, callback, peer_options);
+        } else {
+            peer = new Peer(peer_info.my_listen_port,
+                peer_info.destination_ip_addr, peer_info.destination_port,
+                peer_event_loop, callback, peer_options);
+        }
         peer->id = i;
         peers.push_back(peer);
     }
+    if (!peer_infos.empty() && peer_infos[0].shared_listen_port) {
+        peer_listener = new PeerListener(peer_infos[0].my_listen_port,
+            peer_event_loop, [this](int peer_server_id, int socket) {
+                for (size_t i = 0; i < peer_infos.size(); i++) {
+                    if (peer_infos[i].server_id == peer_server_id &&
+                            peer_server_id < server_id) {
+                        peers[i]->AdoptConnection(socket);
+                        return;
+                    }
+                }
+                warn("Connection from unexpected server %d, closing connection",
+                    peer_server_id);
+                close(socket);
+            });
+    }
+
+    apply_thread = thread([this]() {
+        RunApplyThread();
+    });
 
     election_timer = new Timer(ELECTION_MIN_TIMEOUT, ELECTION_MAX_TIMEOUT, [this]() {
         HandleElectionTimer();
@@ -56,56 +129,188 @@ void RaftServer::HandleLeaderTimer() {
     if (server_state != Leader) {
         return;
     }
+    // Peers at the same point in the log share one encoding of the entries
+    map<int, EncodedEntries> encoded_entries;
     for (Peer* peer: peers) {
-        SendAppendEntriesRequest(peer);
+        if (!peer_responded[peer->id] && peer_inflight_requests[peer->id] > 0) {
+            // Requests were lost (e.g. the connection dropped), so go back to
+            // probing from the last entry we know the peer has
+            debug("Peer %d stalled, probing from %d", peer->id,
+                peer_match_indexes[peer->id] + 1);
+            peer_inflight_requests[peer->id] = 0;
+            peer_probing[peer->id] = true;
+            peer_next_indexes[peer->id] = peer_match_indexes[peer->id] + 1;
+        }
+        peer_responded[peer->id] = false;
+        ReplicateToPeer(peer, true, &encoded_entries);
     }
     CheckForCommittedEntries();
+    debug("Log reads: %ld from memory, %ld from disk, %ld bytes cached",
+        persistent_log.CacheHits(), persistent_log.CacheMisses(),
+        persistent_log.CacheBytes());
 }
 
 int RaftServer::HandleClientCommand(char * command) {
-    lock_guard<mutex> lock(server_mutex);
-    assert(server_state == Leader);
+    QueuedCommand queued_command;
+    queued_command.command = command;
 
-    info("Client command: %s", command);
+    unique_lock<mutex> lock(group_commit_mutex);
+    queued_commands.push_back(&queued_command);
+    int flushed_index = -1;
+    while (!queued_command.done) {
+        if (group_commit_flushing) {
+            // Another thread is flushing; our command goes in the next group
+            group_commit_cv.wait(lock);
+            continue;
+        }
+        // Become the flusher for every command queued so far (including ours)
+        group_commit_flushing = true;
+        vector<QueuedCommand*> group;
+        group.swap(queued_commands);
+        lock.unlock();
 
-    int prev_last_log_index = persistent_log.LastLogIndex();
+        flushed_index = FlushClientCommands(group);
+
+        lock.lock();
+        group_commit_flushing = false;
+        group_commit_cv.notify_all();
+    }
+    lock.unlock();
+
+    if (flushed_index != -1) {
+        // Followers write the group while we do
+        {
+            lock_guard<mutex> server_lock(server_mutex);
+            if (server_state == Leader) {
+                map<int, EncodedEntries> encoded_entries;
+                for (Peer* peer: peers) {
+                    ReplicateToPeer(peer, false, &encoded_entries);
+                }
+            }
+        }
+
+        // The next group can be appended while we wait for ours to be durable
+        bool durable = persistent_log.Sync(flushed_index);
+
+        lock_guard<mutex> server_lock(server_mutex);
+        // Our log is only truncated after we have stepped down, so the
+        // entries are ours if we are still leading the same term
+        if (durable && server_state == Leader &&
+                storage.current_term() == queued_command.log_term) {
+            self_match_index = max(self_match_index, flushed_index);
+            CheckForCommittedEntries();
+        }
+    }
+    return queued_command.log_index;
+}
+
+int RaftServer::FlushClientCommands(vector<QueuedCommand*>& group) {
+    lock_guard<mutex> lock(server_mutex);
+    if (server_state != Leader) {
+        // Stepped down (e.g. on a higher term) after the group was queued,
+        // so the commands can't go in our log
+        info("No longer leader, dropping %d client commands", (int) group.size());
+        for (QueuedCommand* queued_command : group) {
+            queued_command->log_index = -1;
+            queued_command->done = true;
+        }
+        return -1;
+    }
 
-    // Append log entry
-    int log_entry_len = strlen(command) + 1;
-    char log_entry_buffer[log_entry_len + sizeof(int)];
+    int prev_last_log_index = persistent_log.LastLogIndex();
     int current_term = storage.current_term();
 
-    memcpy(log_entry_buffer, &current_term, sizeof(int));
-    memcpy(log_entry_buffer + sizeof(int), command, log_entry_len);
-    persistent_log.AddLogEntry(log_entry_buffer, log_entry_len + sizeof(int));
+    // Append all log entries with a single write
+    vector<string> log_entries;
+    for (QueuedCommand* queued_command : group) {
+        info("Client command: %s", queued_command->command.c_str());
+        string log_entry((char *) &current_term, sizeof(int));
+        log_entry.append(queued_command->command.c_str(),
+            queued_command->command.length() + 1);
+        log_entries.push_back(log_entry);
+    }
+    bool appended = persistent_log.AddLogEntries(log_entries);
+    if (!appended) {
+        error("%s", "failed to append client commands to log");
+        // Nothing has been sent to followers yet, so the part of the group
+        // that made it into the log can simply be dropped
+        if (persistent_log.LastLogIndex() > prev_last_log_index &&
+                !persistent_log.TruncateSuffix(prev_last_log_index + 1)) {
+            error("%s", "failed to remove partially appended client commands");
+        }
+    }
 
     int last_log_index = persistent_log.LastLogIndex();
-    info("Added to log (prev index %d, current index %d)", prev_last_log_index, last_log_index);
-
-    for (Peer* peer: peers) {
-        SendAppendEntriesRequest(peer);
+    if (appended) {
+        info("Added to log (prev index %d, current index %d)", prev_last_log_index, last_log_index);
     }
 
-    return last_log_index;
+    for (size_t i = 0; i < group.size(); i++) {
+        group[i]->log_index = appended ? prev_last_log_index + 1 + i : -1;
+        group[i]->log_term = current_term;
+        group[i]->done = true;
+    }
+    return appended ? last_log_index : -1;
 }
 
-void RaftServer::HandlePeerMessage(Peer* peer, char* raw_message, int raw_message_len) {
+void RaftServer::HandlePeerMessage(Peer* peer, const char* raw_message, int raw_message_len) {
     lock_guard<mutex> lock(server_mutex);
-    PeerMessage message;
-    message.ParseFromString(string(raw_message, raw_message_len));
-
-    debug("RECEIVE: %s", Util::ProtoDebugString(message).c_str());
+    if (PeerFrame::IsFrame(raw_message, raw_message_len)) {
+        HandlePeerFrame(peer, raw_message, raw_message_len);
+        return;
+    }
+    PeerMessage* message =
+        google::protobuf::Arena::CreateMessage<PeerMessage>(&receive_arena);
+    message->ParseFromArray(raw_message, raw_message_len);
+    HandlePeerMessage(peer, *message);
+    // Frees the message, and anything allocated while handling it
+    receive_arena.Reset();
+}
 
-    if (message.term() > storage.current_term()) {
-        TransitionCurrentTerm(message.term());
-        TransitionServerState(Follower);
-        client_server->StartRedirecting(&server_infos[message.server_id()]);
+void RaftServer::HandlePeerMessage(Peer* peer, const PeerMessage& message) {
+    if (LOG_LEVEL <= DEBUG) {
+        debug("RECEIVE: %s", Util::ProtoDebugString(message).c_str());
     }
+    peer_accepts_frames[peer->id] = message.accepts_frames();
+    CheckTerm(message.term(), message.server_id());
 
     switch (message.type()) {
         case PeerMessage::APPENDENTRIES_REQUEST: {
+            AppendEntriesRequest& request = received_request;
+            request.term = message.term();
+            request.server_id = message.server_id();
+            request.prev_log_index = message.prev_log_index();
+            request.prev_log_term = message.prev_log_term();
+            request.leader_commit = message.leader_commit();
+            request.entries.clear();
+            for (const string& entry : message.entries()) {
+                if (entry.size() < sizeof(int)) {
+                    // every entry starts with its term
+                    warn("Malformed AppendEntries request from peer %d", peer->id);
+                    return;
+                }
+                request.entries.emplace_back(entry);
+            }
+            HandleAppendEntriesRequest(peer, request);
+            return;
+        }
+
+        case PeerMessage::APPENDENTRIES_RESPONSE: {
+            AppendEntriesResponse response;
+            response.term = message.term();
+            response.server_id = message.server_id();
+            response.success = message.success();
+            response.appended_log_index = message.appended_log_index();
+            response.conflict_term = message.conflict_term();
+            response.conflict_first_index = message.conflict_first_index();
+            HandleAppendEntriesResponse(peer, response);
+            return;
+        }
+
+        case PeerMessage::INSTALLSNAPSHOT_REQUEST: {
+            int snapshot_index = message.last_included_index();
             if (message.term() < storage.current_term()) {
-                SendAppendEntriesResponse(peer, false, message.prev_log_index() + 1);
+                SendInstallSnapshotResponse(peer, false, snapshot_index, 0, false);
                 return;
             }
             if (server_state == Candidate && message.term() == storage.current_term()) {
@@ -113,66 +318,85 @@ void RaftServer::HandlePeerMessage(Peer* peer, char* raw_message, int raw_messag
                 TransitionServerState(Follower);
                 client_server->StartRedirecting(&server_infos[message.server_id()]);
             }
+            election_timer->Reset();
 
-            int largest_log_index = persistent_log.LastLogIndex();
-            if (largest_log_index < message.prev_log_index()) {
-                SendAppendEntriesResponse(peer, false, message.prev_log_index() + 1);
+            if (snapshot_index <= committed_index) {
+                // Everything the snapshot covers is already applied and in
+                // our log
+                SendInstallSnapshotResponse(peer, true, snapshot_index,
+                    message.offset(), true);
                 return;
             }
-
-            struct LogEntry compare_entry =
-                persistent_log.GetLogEntryByIndex(message.prev_log_index());
-            int compare_entry_term = *(int *)compare_entry.data;
-            if (compare_entry_term != message.prev_log_term()) {
-                SendAppendEntriesResponse(peer, false, message.prev_log_index() + 1);
-                return;
+            if (message.offset() == 0) {
+                received_snapshot_index = snapshot_index;
+                received_snapshot_offset = 0;
             }
-
-            while (largest_log_index > message.prev_log_index()) {
-                if (persistent_log.RemoveLogEntry() != true) {
-                    error("%s", "failed to remove an entry from log");
-                }
-                largest_log_index -= 1;
-                // should == largest_log_index = persistent_log.LastLogIndex();
+            if (snapshot_index != received_snapshot_index ||
+                    message.offset() != received_snapshot_offset) {
+                // A chunk went missing, so tell the leader where to resume
+                long resume_offset = (snapshot_index == received_snapshot_index) ?
+                    received_snapshot_offset : 0;
+                SendInstallSnapshotResponse(peer, false, snapshot_index,
+                    resume_offset, false);
+                return;
             }
-            if (message.entries_size() > 0) {
-                string log_entry = message.entries(0);
-                int log_entry_len = log_entry.length();
-                char log_entry_buffer[log_entry_len + sizeof(int)];
-                int current_term = storage.current_term();
-
-                memcpy(log_entry_buffer, &current_term, sizeof(int));
-                memcpy(log_entry_buffer + sizeof(int), log_entry.c_str(), log_entry_len);
-                persistent_log.AddLogEntry(log_entry_buffer,
-                    log_entry_len + sizeof(int));
+            try {
+                storage.WriteSnapshotChunk(message.offset(), message.data());
+            } catch (RaftStorageException& err) {
+                error("%s", err.what());
+                received_snapshot_index = -1;
+                SendInstallSnapshotResponse(peer, false, snapshot_index, 0, false);
+                return;
             }
-            SendAppendEntriesResponse(peer, true, message.prev_log_index() + 1);
-            election_timer->Reset();
-            if (message.leader_commit() > committed_index) {
-                CommitEntries(message.leader_commit());
+            received_snapshot_offset += message.data().size();
+            if (message.done()) {
+                received_snapshot_index = -1;
+                if (!InstallSnapshot(snapshot_index, message.last_included_term())) {
+                    SendInstallSnapshotResponse(peer, false, snapshot_index, 0, false);
+                    return;
+                }
             }
+            SendInstallSnapshotResponse(peer, true, snapshot_index,
+                received_snapshot_offset, message.done());
             return;
         }
 
-        case PeerMessage::APPENDENTRIES_RESPONSE: {
+        case PeerMessage::INSTALLSNAPSHOT_RESPONSE: {
             if (message.term() < storage.current_term()) {
                 // Drop responses with an outdated term; they indicate this
                 // response is for a request from a previous term.
                 return;
             }
+            if (server_state != Leader) {
+                // Stepped down (e.g. in CheckTerm), so the peer is no
+                // longer ours to send snapshots to
+                return;
+            }
 
-            if (message.success()) {
-                if (message.appended_log_index() >= peer_next_indexes[peer->id]) {
-                    peer_next_indexes[peer->id] = message.appended_log_index() + 1;
-                    peer_match_indexes[peer->id] = message.appended_log_index();
+            peer_responded[peer->id] = true;
+            if (peer_inflight_requests[peer->id] > 0) {
+                peer_inflight_requests[peer->id] -= 1;
+            }
+            if (peer_snapshot_offsets[peer->id] == -1 ||
+                    message.last_included_index() != peer_snapshot_indexes[peer->id]) {
+                // Response to a snapshot we're no longer sending
+                return;
+            }
+            if (message.done()) {
+                info("Peer %d installed snapshot at %d", peer->id,
+                    message.last_included_index());
+                peer_snapshot_offsets[peer->id] = -1;
+                peer_next_indexes[peer->id] = message.last_included_index() + 1;
+                if (message.last_included_index() > peer_match_indexes[peer->id]) {
+                    peer_match_indexes[peer->id] = message.last_included_index();
                     CheckForCommittedEntries();
                 }
             } else {
-                peer_next_indexes[peer->id] = message.appended_log_index() - 1;
-            }
-            if (peer_next_indexes[peer->id] <= persistent_log.LastLogIndex()){
-                SendAppendEntriesRequest(peer); //still need to catch up
+                // The peer tells us where the next chunk starts, also after
+                // a chunk it couldn't use
+                peer_snapshot_offsets[peer->id] = message.offset();
             }
+            ReplicateToPeer(peer, false);
             return;
         }
 
@@ -188,17 +412,17 @@ void RaftServer::HandlePeerMessage(Peer* peer, char* raw_message, int raw_messag
                 return;
             }
 
-            struct LogEntry prev_entry =
-                persistent_log.GetLogEntryByIndex(message.prev_log_index());
-            int prev_entry_term = *(int *)prev_entry.data;
+            // Only vote for candidates whose log is at least as up to date
+            // as ours
+            int last_log_term = LogTerm(persistent_log.LastLogIndex());
 
-            if (message.last_log_term() > prev_entry_term) {
+            if (message.last_log_term() > last_log_term) {
                 storage.set_term_and_voted(storage.current_term(), message.server_id());
                 SendRequestVoteResponse(peer, true);
                 election_timer->Reset();
                 return;
             }
-            if (message.last_log_term() == prev_entry_term &&
+            if (message.last_log_term() == last_log_term &&
                 message.last_log_index() >= persistent_log.LastLogIndex()) {
                 storage.set_term_and_voted(storage.current_term(), message.server_id());
                 SendRequestVoteResponse(peer, true);
@@ -226,113 +450,620 @@ void RaftServer::HandlePeerMessage(Peer* peer, char* raw_message, int raw_messag
     }
 }
 
-void RaftServer::CheckForCommittedEntries() {
-    info("%s", "CheckForCommittedEntries");
-    int max_log_index = persistent_log.LastLogIndex();
-    int highest_majority_index = committed_index;
-    for(int j = committed_index; j <= max_log_index; j++) {
-
-        int matches = 1; // Leader always has the latest log entry
-        for (int i = 0; i < peer_match_indexes.size(); i++) {
-            if (peer_match_indexes[i] > j) {
-                matches += 1;
-            }
+void RaftServer::HandlePeerFrame(Peer* peer, const char* frame, int frame_len) {
+    if ((uint8_t) frame[0] == FRAME_APPENDENTRIES_REQUEST) {
+        if (!PeerFrame::DecodeRequest(frame, frame_len, received_request)) {
+            warn("Malformed AppendEntries request from peer %d", peer->id);
+            return;
         }
-        int majority_threshold = (server_infos.size() / 2) + 1;
-        info("majority thresh: %d ,", majority_threshold);
-        if (matches < majority_threshold) {
+        debug("RECEIVE: AppendEntries frame, prev_log_index: %d entries: %d",
+            received_request.prev_log_index, (int) received_request.entries.size());
+        CheckTerm(received_request.term, received_request.server_id);
+        HandleAppendEntriesRequest(peer, received_request);
+        return;
+    }
+    AppendEntriesResponse response;
+    if (!PeerFrame::DecodeResponse(frame, frame_len, response)) {
+        warn("Malformed AppendEntries response from peer %d", peer->id);
+        return;
+    }
+    debug("RECEIVE: AppendEntries response frame, success: %d appended_log_index: %d",
+        response.success, response.appended_log_index);
+    CheckTerm(response.term, response.server_id);
+    HandleAppendEntriesResponse(peer, response);
+}
+
+void RaftServer::CheckTerm(int term, int sender_id) {
+    if (term > storage.current_term()) {
+        TransitionCurrentTerm(term);
+        TransitionServerState(Follower);
+        client_server->StartRedirecting(&server_infos[sender_id]);
+    }
+}
+
+void RaftServer::HandleAppendEntriesRequest(Peer* peer,
+        const AppendEntriesRequest& request) {
+    if (request.term < storage.current_term()) {
+        SendAppendEntriesResponse(peer, false, request.prev_log_index + 1);
+        return;
+    }
+    if (server_state == Candidate && request.term == storage.current_term()) {
+        // Candidate recognizes another candidate has won election
+        TransitionServerState(Follower);
+        client_server->StartRedirecting(&server_infos[request.server_id]);
+    }
+
+    int largest_log_index = persistent_log.LastLogIndex();
+    if (largest_log_index < request.prev_log_index) {
+        // Tell the leader where our log ends, so it can back up there at once
+        SendAppendEntriesResponse(peer, false, request.prev_log_index + 1,
+            -1, largest_log_index + 1);
+        return;
+    }
+
+    // Entries before the start of our log are covered by our
+    // snapshot, so they are committed and match the leader's
+    if (request.prev_log_index >= persistent_log.FirstLogIndex() &&
+            LogTerm(request.prev_log_index) != request.prev_log_term) {
+        // Tell the leader where the conflicting term starts, so it can skip
+        // all of its entries at once
+        int conflict_term = LogTerm(request.prev_log_index);
+        SendAppendEntriesResponse(peer, false, request.prev_log_index + 1,
+            conflict_term,
+            FirstIndexWithTerm(conflict_term, request.prev_log_index));
+        return;
+    }
+
+    // Skip entries we already have; only a conflicting entry (same
+    // index, different term) truncates our log
+    int entry_index = request.prev_log_index + 1;
+    int first_new_entry = 0;
+    while (first_new_entry < (int) request.entries.size() &&
+            entry_index <= largest_log_index) {
+        int new_entry_term;
+        memcpy(&new_entry_term, request.entries[first_new_entry].data(),
+            sizeof(int));
+        if (entry_index >= persistent_log.FirstLogIndex() &&
+                LogTerm(entry_index) != new_entry_term) {
             break;
+        }
+        first_new_entry += 1;
+        entry_index += 1;
+    }
+
+    if (first_new_entry < (int) request.entries.size()) {
+        if (largest_log_index >= entry_index &&
+                !persistent_log.TruncateSuffix(entry_index)) {
+            error("%s", "failed to remove conflicting entries from log");
+            SendAppendEntriesResponse(peer, false, request.prev_log_index + 1);
+            return;
+        }
+        // Entries arrive with their term prepended, exactly as they
+        // are stored in the leader's log
+        vector<string> new_entries(
+            request.entries.begin() + first_new_entry,
+            request.entries.end());
+        if (!persistent_log.AddLogEntries(new_entries)) {
+            error("%s", "failed to append entries to log");
+            SendAppendEntriesResponse(peer, false, request.prev_log_index + 1);
+            return;
+        }
+    }
+    // Only entries known to match the leader's log may be committed
+    int last_matching_index =
+        request.prev_log_index + (int) request.entries.size();
+    // Heard from the current leader, however long the sync below takes
+    election_timer->Reset();
+    // The leader counts our response towards a majority, so the
+    // entries must be durable before we acknowledge them. Syncing doesn't
+    // need server_mutex, so timers and the applier aren't held up for the
+    // length of a disk flush
+    int term = storage.current_term();
+    server_mutex.unlock();
+    bool durable = persistent_log.Sync(last_matching_index);
+    server_mutex.lock();
+    if (storage.current_term() != term ||
+            persistent_log.LastLogIndex() < last_matching_index) {
+        // Moved on to a new term while syncing, so the entries may no
+        // longer be the leader's; it resends whatever goes unanswered
+        return;
+    }
+    if (!durable) {
+        error("%s", "failed to sync appended entries to disk");
+        SendAppendEntriesResponse(peer, false, request.prev_log_index + 1);
+        return;
+    }
+    SendAppendEntriesResponse(peer, true, last_matching_index);
+    int leader_commit =
+        min(request.leader_commit, last_matching_index);
+    if (leader_commit > committed_index) {
+        CommitEntries(leader_commit);
+    }
+}
+
+void RaftServer::HandleAppendEntriesResponse(Peer* peer,
+        const AppendEntriesResponse& response) {
+    if (response.term < storage.current_term()) {
+        // Drop responses with an outdated term; they indicate this
+        // response is for a request from a previous term.
+        return;
+    }
+    if (server_state != Leader) {
+        // Stepped down (e.g. in CheckTerm), so the peer is no longer ours
+        // to replicate to
+        return;
+    }
+
+    peer_responded[peer->id] = true;
+    if (peer_inflight_requests[peer->id] > 0) {
+        peer_inflight_requests[peer->id] -= 1;
+    }
+    if (response.success) {
+        if (response.appended_log_index > peer_match_indexes[peer->id]) {
+            peer_match_indexes[peer->id] = response.appended_log_index;
+            CheckForCommittedEntries();
+        }
+        if (response.appended_log_index >= peer_next_indexes[peer->id]) {
+            peer_next_indexes[peer->id] = response.appended_log_index + 1;
+        }
+        // Found where our logs match, so start pipelining
+        peer_probing[peer->id] = false;
+    } else if (response.appended_log_index <= peer_next_indexes[peer->id]) {
+        // Back up to just before the mismatch, or further if the peer
+        // says where its conflicting entries start. Failures for requests
+        // pipelined after the mismatching one report later indexes and
+        // are ignored by the min(). The first entry of our log is
+        // committed, so identical in every log that has it; never back
+        // up past it.
+        int next_index = response.appended_log_index - 1;
+        if (response.conflict_first_index > 0) {
+            next_index = min(next_index, ConflictNextIndex(response));
+        }
+        next_index = min(peer_next_indexes[peer->id], next_index);
+        if (next_index <= persistent_log.FirstLogIndex() &&
+                storage.snapshot_index() > 0) {
+            // The peer lacks entries we have discarded, so it has to
+            // catch up from our snapshot instead
+            if (peer_snapshot_offsets[peer->id] == -1) {
+                info("Sending snapshot at %d to peer %d",
+                    storage.snapshot_index(), peer->id);
+                peer_snapshot_offsets[peer->id] = 0;
+                peer_snapshot_indexes[peer->id] = storage.snapshot_index();
+            }
         } else {
-            highest_majority_index = j;
+            peer_next_indexes[peer->id] = max(next_index,
+                persistent_log.FirstLogIndex() + 1);
         }
+        peer_probing[peer->id] = true;
+    }
+    ReplicateToPeer(peer, false); //still need to catch up
+}
 
+void RaftServer::CheckForCommittedEntries() {
+    // The majority-th largest match index, counting our own, is the highest
+    // entry a majority of servers have. Leader has every entry, but only
+    // counts those already durable.
+    vector<int> match_indexes(peer_match_indexes);
+    match_indexes.push_back(self_match_index);
+    int majority_threshold = (server_infos.size() / 2) + 1;
+    nth_element(match_indexes.begin(),
+        match_indexes.begin() + majority_threshold - 1, match_indexes.end(),
+        greater<int>());
+    int highest_majority_index = match_indexes[majority_threshold - 1];
+    if (highest_majority_index <= committed_index) {
+        return;
     }
-    struct LogEntry ent = persistent_log.
-        GetLogEntryByIndex(highest_majority_index);
-    int term = *(int *)ent.data;
 
-    info("CheckForCommittedEntries 1 (term: %d) (current term: %d)(command: %s)", term, storage.current_term(), ent.data + 4);
+    // Only entries from our own term are committed by counting replicas
+    int term = LogTerm(highest_majority_index);
+    debug("Majority has index %d (term: %d) (current term: %d)",
+        highest_majority_index, term, storage.current_term());
     if (term == storage.current_term()) {
-        info("%s", "Committing all majority-passing entries");
         CommitEntries(highest_majority_index);
     }
 }
 
 void RaftServer::CommitEntries(int highest_majority_index) {
-    while (committed_index < highest_majority_index) {
-        committed_index += 1;
-        struct LogEntry ent = persistent_log.GetLogEntryByIndex(committed_index);
-        char * data = ent.data + sizeof(int);
-        string response = state_machine.Apply(string(data));
-        if (server_state == Leader) {
-            client_server->RespondToClient(committed_index, response);
+    if (highest_majority_index > committed_index) {
+        committed_index = highest_majority_index;
+        apply_cv.notify_one();
+    }
+}
+
+void RaftServer::RunApplyThread() {
+    unique_lock<mutex> lock(server_mutex);
+    while (!apply_stopped) {
+        int first_index;
+        bool unsaved;
+        {
+            lock_guard<mutex> apply_lock(apply_mutex);
+            first_index = applied_index + 1;
+            unsaved = saved_applied_index < applied_index;
+        }
+        if (first_index > committed_index) {
+            if (!unsaved) {
+                apply_cv.wait(lock);
+            } else if (apply_cv.wait_for(lock,
+                    milliseconds(LAST_APPLIED_SAVE_INTERVAL)) ==
+                    cv_status::timeout) {
+                // Nothing more to apply for now, so record how far we got
+                lock.unlock();
+                {
+                    lock_guard<mutex> apply_lock(apply_mutex);
+                    SaveAppliedIndex(true);
+                }
+                lock.lock();
+            }
+            continue;
+        }
+        // The log may change once server_mutex is released, so copy the
+        // commands out of it
+        int last_index = min(committed_index,
+            first_index + MAX_APPLY_BATCH_COUNT - 1);
+        vector<string> commands;
+        for (int index = first_index; index <= last_index; index++) {
+            struct LogEntry ent = persistent_log.GetLogEntryByIndex(index);
+            if (ent.data == NULL || ent.len < (int) sizeof(int)) {
+                // Committed entries must be applied in order, so there is
+                // no skipping this one
+                error("failed to read committed entry %d, no longer applying",
+                    index);
+                return;
+            }
+            char * data = ent.data + sizeof(int);
+            // log data isn't NUL-terminated past the entry, so stay within it
+            commands.emplace_back(data, strnlen(data, ent.len - sizeof(int)));
+        }
+        bool respond = server_state == Leader;
+        lock.unlock();
+
+        int snapshot_index = ApplyEntries(first_index, commands, respond);
+
+        lock.lock();
+        if (snapshot_index != -1) {
+            SaveSnapshot(snapshot_index);
         }
-        storage.set_last_applied(committed_index);
     }
 }
 
-void RaftServer::SendMessage(Peer *peer, PeerMessage &message) {
-    debug("SEND: %s", Util::ProtoDebugString(message).c_str());
+int RaftServer::ApplyEntries(int first_index, const vector<string>& commands,
+        bool respond) {
+    lock_guard<mutex> lock(apply_mutex);
+    for (size_t i = 0; i < commands.size(); i++) {
+        int index = first_index + i;
+        if (index <= applied_index) {
+            // Covered by a snapshot installed since the batch was copied
+            continue;
+        }
+        string response = state_machine.Apply(commands[i]);
+        if (respond) {
+            client_server->RespondToClient(index, response);
+        }
+        applied_index = index;
+        SaveAppliedIndex(false);
+    }
+    if (applied_index - storage.snapshot_index() < SNAPSHOT_INTERVAL) {
+        return -1;
+    }
+    try {
+        // The log before the snapshot will be discarded, so it must never
+        // need to be applied again
+        SaveAppliedIndex(true);
+        storage.WriteSnapshot(applied_index, state_machine);
+    } catch (RaftStorageException& err) {
+        error("%s", err.what());
+        return -1;
+    }
+    return applied_index;
+}
+
+void RaftServer::SaveAppliedIndex(bool force) {
+    if (saved_applied_index == applied_index) {
+        return;
+    }
+    time_point<steady_clock> now = steady_clock::now();
+    if (force ||
+            applied_index - saved_applied_index >= LAST_APPLIED_SAVE_ENTRIES ||
+            now - saved_applied_time >=
+                milliseconds(LAST_APPLIED_SAVE_INTERVAL)) {
+        storage.set_last_applied(applied_index);
+        saved_applied_index = applied_index;
+        saved_applied_time = now;
+    }
+}
+
+void RaftServer::SaveSnapshot(int snapshot_index) {
+    try {
+        storage.SaveSnapshot(snapshot_index, LogTerm(snapshot_index));
+    } catch (RaftStorageException& err) {
+        error("%s", err.what());
+        return;
+    }
+    if (storage.snapshot_index() != snapshot_index) {
+        // A newer snapshot was installed while this one was written
+        return;
+    }
+    if (!persistent_log.CompactPrefix(snapshot_index)) {
+        error("failed to discard log before snapshot at %d", snapshot_index);
+        return;
+    }
+    info("Snapshot at index %d, log now starts at %d", snapshot_index,
+        persistent_log.FirstLogIndex());
+}
+
+bool RaftServer::InstallSnapshot(int index, int term) {
+    // Raft keeps the entries after the snapshot if our log agrees with it
+    bool keep_log = index <= persistent_log.LastLogIndex() &&
+        index >= persistent_log.FirstLogIndex() && LogTerm(index) == term;
+    try {
+        lock_guard<mutex> apply_lock(apply_mutex);
+        storage.InstallSnapshot(index, term, state_machine);
+        applied_index = index;
+        saved_applied_index = index;
+    } catch (RaftStorageException& err) {
+        error("%s", err.what());
+        return false;
+    }
+    committed_index = index;
+    bool log_updated = keep_log ? persistent_log.CompactPrefix(index) :
+        ResetLogToSnapshot();
+    if (!log_updated) {
+        error("failed to update log for snapshot at %d", index);
+        return false;
+    }
+    info("Installed snapshot at index %d, log now starts at %d", index,
+        persistent_log.FirstLogIndex());
+    return true;
+}
+
+bool RaftServer::ResetLogToSnapshot() {
+    // The entry itself is never applied again, only its term is needed
+    int snapshot_term = storage.snapshot_term();
+    string log_entry((char *) &snapshot_term, sizeof(int));
+    log_entry.push_back('\0');
+    return persistent_log.ResetLog(storage.snapshot_index(), log_entry.data(),
+        log_entry.length());
+}
+
+int RaftServer::FirstIndexWithTerm(int term, int limit) {
+    // Terms never decrease along the log, so binary search for the first
+    // entry whose term is at least term
+    int low = persistent_log.FirstLogIndex();
+    int high = limit + 1;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        if (LogTerm(middle) < term) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+int RaftServer::ConflictNextIndex(const AppendEntriesResponse& response) {
+    if (response.conflict_term != -1) {
+        // If we have entries from the conflicting term, resume after our
+        // last one; otherwise skip the whole term on the peer
+        int last_of_term = FirstIndexWithTerm(response.conflict_term + 1,
+            persistent_log.LastLogIndex()) - 1;
+        if (last_of_term >= persistent_log.FirstLogIndex() &&
+                LogTerm(last_of_term) == response.conflict_term) {
+            return last_of_term + 1;
+        }
+    }
+    return response.conflict_first_index;
+}
+
+int RaftServer::LogTerm(int index) {
+    if (index == storage.snapshot_index()) {
+        return storage.snapshot_term();
+    }
+    struct LogEntry entry = persistent_log.GetLogEntryByIndex(index);
+    if (entry.data == NULL) {
+        return -1;
+    }
+    int term;
+    memcpy(&term, entry.data, sizeof(int));
+    return term;
+}
+
+void RaftServer::SendMessage(Peer *peer, PeerMessage &message,
+        shared_ptr<const string> body) {
+    if (LOG_LEVEL <= DEBUG) {
+        debug("SEND: %s", Util::ProtoDebugString(message).c_str());
+    }
     string message_string;
     message.SerializeToString(&message_string);
-    peer->SendMessage(message_string.c_str(), message_string.size());
+    // Frees the message, now that it's encoded
+    send_arena.Reset();
+    peer->SendMessage(move(message_string), body);
 }
 
-PeerMessage RaftServer::CreateMessage(PeerMessage_Type message_type) {
-    PeerMessage message;
-    message.set_type(message_type);
-    message.set_term(storage.current_term());
-    message.set_server_id(server_id);
+PeerMessage* RaftServer::CreateMessage(PeerMessage_Type message_type) {
+    PeerMessage* message =
+        google::protobuf::Arena::CreateMessage<PeerMessage>(&send_arena);
+    message->set_type(message_type);
+    message->set_term(storage.current_term());
+    message->set_server_id(server_id);
+    message->set_accepts_frames(true);
     return message;
 }
 
-void RaftServer::SendAppendEntriesRequest(Peer *peer) {
-    PeerMessage message = CreateMessage(PeerMessage::APPENDENTRIES_REQUEST);
+void RaftServer::ReplicateToPeer(Peer *peer, bool heartbeat,
+        map<int, EncodedEntries> *encoded_entries) {
+    if (peer_snapshot_offsets[peer->id] != -1) {
+        // No entries can be sent until the peer has our snapshot
+        if (peer_inflight_requests[peer->id] == 0) {
+            SendInstallSnapshotRequest(peer);
+        }
+        return;
+    }
+    bool sent = false;
+    while (peer_next_indexes[peer->id] <= persistent_log.LastLogIndex()) {
+        int window = peer_probing[peer->id] ? 1 : MAX_INFLIGHT_APPEND_ENTRIES;
+        if (peer_inflight_requests[peer->id] >= window) {
+            break;
+        }
+        SendAppendEntriesRequest(peer, false, encoded_entries);
+        sent = true;
+        if (peer_probing[peer->id]) {
+            break;
+        }
+    }
+    if (heartbeat && !sent) {
+        SendAppendEntriesRequest(peer, true, encoded_entries);
+    }
+}
+
+void RaftServer::SendAppendEntriesRequest(Peer *peer, bool heartbeat,
+        map<int, EncodedEntries> *encoded_entries) {
     int next_index = peer_next_indexes[peer->id];
-    bool empty_body = false;
+    bool empty_body = heartbeat;
     if (next_index > persistent_log.LastLogIndex()) {
         debug("%s", "empty body of append entries");
         next_index = persistent_log.LastLogIndex() + 1;
         empty_body = true;
     }
 
-    struct LogEntry prev_entry = persistent_log.GetLogEntryByIndex(next_index - 1);
-    int prev_entry_term = *(int *)prev_entry.data;
+    AppendEntriesRequest request;
+    request.term = storage.current_term();
+    request.server_id = server_id;
+    request.prev_log_term = LogTerm(next_index - 1);
+    request.prev_log_index = next_index - 1;
+    request.leader_commit = committed_index;
+    bool frame = peer_accepts_frames[peer->id];
+    peer_inflight_requests[peer->id] += 1;
 
-    message.set_prev_log_term(prev_entry_term);
-    message.set_prev_log_index(next_index - 1);
-    message.set_leader_commit(committed_index);
+    // Only the fields before the entries differ between peers
+    shared_ptr<const string> body;
+    int entry_count = 0;
     if (!empty_body) {
-        debug("%s", "Append Entry is non-empty");
-        struct LogEntry cur_entry = persistent_log.GetLogEntryByIndex(next_index);
-        message.add_entries(cur_entry.data + sizeof(int),
-            cur_entry.len - sizeof(int));
+        EncodedEntries unshared_entries;
+        EncodedEntries& entries = (encoded_entries != NULL) ?
+            (*encoded_entries)[next_index] : unshared_entries;
+        EncodeEntries(next_index, frame, entries);
+        body = frame ? entries.frame_body : entries.message_body;
+        entry_count = entries.count;
+        debug("Append Entry carries %d entries", entry_count);
+        if (!peer_probing[peer->id]) {
+            // Optimistically assume the entries will be accepted
+            peer_next_indexes[peer->id] = next_index + entry_count;
+        }
+    }
+
+    if (frame) {
+        debug("SEND: AppendEntries frame, prev_log_index: %d entries: %d",
+            request.prev_log_index, entry_count);
+        peer->SendMessage(PeerFrame::EncodeRequestHeader(request, entry_count),
+            body);
+        return;
+    }
+    PeerMessage* message = CreateMessage(PeerMessage::APPENDENTRIES_REQUEST);
+    message->set_prev_log_term(request.prev_log_term);
+    message->set_prev_log_index(request.prev_log_index);
+    message->set_leader_commit(request.leader_commit);
+    SendMessage(peer, *message, body);
+}
+
+void RaftServer::EncodeEntries(int start_index, bool frame,
+        EncodedEntries& encoded) {
+    if ((frame ? encoded.frame_body : encoded.message_body) != nullptr) {
+        return;
+    }
+    vector<struct LogEntry> entries = persistent_log.GetLogEntriesByRange(
+        start_index, MAX_APPEND_ENTRIES_COUNT, MAX_APPEND_ENTRIES_BYTES);
+    encoded.count = entries.size();
+    if (frame) {
+        encoded.frame_body = make_shared<const string>(
+            PeerFrame::EncodeEntries(entries));
+        return;
+    }
+    string body;
+    {
+        google::protobuf::io::StringOutputStream stream(&body);
+        google::protobuf::io::CodedOutputStream output(&stream);
+        uint32_t tag = google::protobuf::internal::WireFormatLite::MakeTag(
+            PeerMessage::kEntriesFieldNumber,
+            google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+        for (struct LogEntry entry : entries) {
+            output.WriteTag(tag);
+            output.WriteVarint32(entry.len);
+            output.WriteRaw(entry.data, entry.len);
+        }
     }
-    SendMessage(peer, message);
+    encoded.message_body = make_shared<const string>(move(body));
 }
 
 void RaftServer::SendAppendEntriesResponse(Peer *peer, bool success,
-        int appended_log_index) {
-    PeerMessage message = CreateMessage(PeerMessage::APPENDENTRIES_RESPONSE);
-    message.set_appended_log_index(appended_log_index);
-    message.set_success(success);
-    SendMessage(peer, message);
+        int appended_log_index, int conflict_term, int conflict_first_index) {
+    if (peer_accepts_frames[peer->id]) {
+        AppendEntriesResponse response;
+        response.term = storage.current_term();
+        response.server_id = server_id;
+        response.success = success;
+        response.appended_log_index = appended_log_index;
+        response.conflict_term = conflict_term;
+        response.conflict_first_index = conflict_first_index;
+        debug("SEND: AppendEntries response frame, success: %d appended_log_index: %d",
+            success, appended_log_index);
+        peer->SendMessage(PeerFrame::EncodeResponse(response), nullptr);
+        return;
+    }
+    PeerMessage* message = CreateMessage(PeerMessage::APPENDENTRIES_RESPONSE);
+    message->set_appended_log_index(appended_log_index);
+    message->set_success(success);
+    if (conflict_first_index > 0) {
+        message->set_conflict_term(conflict_term);
+        message->set_conflict_first_index(conflict_first_index);
+    }
+    SendMessage(peer, *message);
+}
+
+void RaftServer::SendInstallSnapshotRequest(Peer *peer) {
+    if (peer_snapshot_indexes[peer->id] != storage.snapshot_index()) {
+        // The snapshot we were sending has been replaced by a newer one
+        peer_snapshot_indexes[peer->id] = storage.snapshot_index();
+        peer_snapshot_offsets[peer->id] = 0;
+    }
+    PeerMessage* message = CreateMessage(PeerMessage::INSTALLSNAPSHOT_REQUEST);
+    message->set_last_included_index(storage.snapshot_index());
+    message->set_last_included_term(storage.snapshot_term());
+    message->set_offset(peer_snapshot_offsets[peer->id]);
+    try {
+        message->set_data(storage.ReadSnapshotChunk(
+            peer_snapshot_offsets[peer->id], SNAPSHOT_CHUNK_BYTES));
+    } catch (RaftStorageException& err) {
+        error("%s", err.what());
+        return;
+    }
+    message->set_done(message->data().size() < SNAPSHOT_CHUNK_BYTES);
+    peer_inflight_requests[peer->id] += 1;
+    SendMessage(peer, *message);
+}
+
+void RaftServer::SendInstallSnapshotResponse(Peer *peer, bool success,
+        int last_included_index, long offset, bool done) {
+    PeerMessage* message = CreateMessage(PeerMessage::INSTALLSNAPSHOT_RESPONSE);
+    message->set_success(success);
+    message->set_last_included_index(last_included_index);
+    message->set_offset(offset);
+    message->set_done(done);
+    SendMessage(peer, *message);
 }
 
 void RaftServer::SendRequestVoteRequest(Peer *peer) {
-    PeerMessage message = CreateMessage(PeerMessage::REQUESTVOTE_REQUEST);
+    PeerMessage* message = CreateMessage(PeerMessage::REQUESTVOTE_REQUEST);
     int last_log_entry_index = persistent_log.LastLogIndex();
-    struct LogEntry prev_entry = persistent_log.GetLogEntryByIndex(last_log_entry_index);
-    int last_log_entry_term = *(int *)prev_entry.data;
-    message.set_last_log_index(last_log_entry_index);
-    message.set_last_log_term(last_log_entry_term);
-    SendMessage(peer, message);
+    message->set_last_log_index(last_log_entry_index);
+    message->set_last_log_term(LogTerm(last_log_entry_index));
+    SendMessage(peer, *message);
 }
 
 void RaftServer::SendRequestVoteResponse(Peer *peer, bool vote_granted) {
-    PeerMessage message = CreateMessage(PeerMessage::REQUESTVOTE_RESPONSE);
-    message.set_vote_granted(vote_granted);
-    SendMessage(peer, message);
+    PeerMessage* message = CreateMessage(PeerMessage::REQUESTVOTE_RESPONSE);
+    message->set_vote_granted(vote_granted);
+    SendMessage(peer, *message);
 }
 
 void RaftServer::TransitionCurrentTerm(int term) {
@@ -369,12 +1100,23 @@ void RaftServer::TransitionServerState(ServerState new_state) {
         }
         case Leader: {
             int next_log_index = persistent_log.LastLogIndex() + 1;
-            int num_servers = server_infos.size();
             peer_next_indexes.clear();
             peer_match_indexes.clear();
-            for (int i = 0; i < num_servers; i++) {
+            peer_inflight_requests.clear();
+            peer_probing.clear();
+            peer_responded.clear();
+            peer_snapshot_offsets.clear();
+            peer_snapshot_indexes.clear();
+            self_match_index = persistent_log.DurableLogIndex();
+            for (size_t i = 0; i < peers.size(); i++) {
                 peer_next_indexes.push_back(next_log_index);
                 peer_match_indexes.push_back(0);
+                peer_inflight_requests.push_back(0);
+                // We don't know how far each peer's log matches ours yet
+                peer_probing.push_back(true);
+                peer_responded.push_back(true);
+                peer_snapshot_offsets.push_back(-1);
+                peer_snapshot_indexes.push_back(0);
             }
 
             client_server->StartServing();
@@ -7,13 +7,18 @@
 
 #pragma once
 
+#include <condition_variable>
+#include <google/protobuf/arena.h>
 #include <map>
+#include <thread>
 #include <vector>
 
 #include "bash-state-machine.h"
 #include "client-server.h"
+#include "event-loop.h"
 #include "log.h"
 #include "peer.h"
+#include "peer-frame.h"
 #include "peer-message.pb.h"
 #include "raft-config.h"
 #include "raft-storage.h"
@@ -24,12 +29,63 @@
 using namespace proto;
 
 enum ServerState { Follower, Candidate, Leader };
+
+/**
+ * A client command waiting to be appended to the log by the group commit
+ * stage. Owned by the client thread that is waiting for it.
+ */
+struct QueuedCommand {
+    string command;
+    int log_index = -1;
+    int log_term = -1;
+    bool done = false;
+};
+
+/**
+ * Log entries encoded once for an AppendEntries request, so peers that need
+ * the same range can all be sent the same bytes. There is an encoding for
+ * PeerMessages (their entries field) and for frames, each made when first
+ * needed.
+ */
+struct EncodedEntries {
+    shared_ptr<const string> message_body;
+    shared_ptr<const string> frame_body;
+    int count = 0;
+};
+
 static const string ServerStateStrings[] = { "Follower", "Candidate", "Leader" };
 
 static const int ELECTION_MIN_TIMEOUT = 5'000; // milliseconds
 static const int ELECTION_MAX_TIMEOUT = 10'000; // milliseconds
 static const int LEADER_HEARTBEAT_INTERVAL = 2'000; // milliseconds
 
+// Limits on how much of the log a single AppendEntries request may carry
+static const int MAX_APPEND_ENTRIES_COUNT = 1'000; // entries
+static const int MAX_APPEND_ENTRIES_BYTES = 1'000'000; // bytes
+
+// Number of unacknowledged AppendEntries requests allowed per peer
+static const int MAX_INFLIGHT_APPEND_ENTRIES = 8; // requests
+
+// Most committed entries the applier copies out of the log at a time
+static const int MAX_APPLY_BATCH_COUNT = 1'000; // entries
+
+// The applier records how far it has got at most once per this many entries
+// or this long, whichever comes first. Entries applied since the last record
+// are applied again after a crash.
+static const int LAST_APPLIED_SAVE_ENTRIES = 1'000; // entries
+static const int LAST_APPLIED_SAVE_INTERVAL = 100; // milliseconds
+
+// Number of applied entries after which the state machine is snapshotted
+// and the log before the snapshot is discarded
+static const int SNAPSHOT_INTERVAL = 10'000; // entries
+
+// Size of the chunks a snapshot is sent to other servers in
+static const int SNAPSHOT_CHUNK_BYTES = 1'000'000; // bytes
+
+// Size of the fixed blocks that PeerMessages are allocated from; larger
+// messages (e.g. snapshot chunks) spill over onto the heap
+static const int MESSAGE_ARENA_BLOCK_BYTES = 16'000; // bytes
+
 class RaftServer {
     public:
         /**
@@ -45,9 +101,19 @@ class RaftServer {
          * @param server_id Friendly name to identify the server
          * @param server_infos Vector of server information
          * @param peer_infos Vector of connection information for peer servers
+         * @param sync_writes Whether to sync the log and storage to disk (and
+         *     not just the kernel) before relying on them
+         * @param peer_options TCP options for the connections to peers
          */
         RaftServer(int server_id, vector<ServerInfo> server_infos,
-            vector<PeerInfo> peer_infos);
+            vector<PeerInfo> peer_infos, bool sync_writes,
+            PeerOptions peer_options = PeerOptions());
+
+        /**
+         * Stop the applier thread, e.g. after Run fails, once it has finished
+         * applying the batch it is working on.
+         */
+        ~RaftServer();
 
         /**
          * Start running the server. Specifically, start the Raft protocol,
@@ -73,18 +139,75 @@ class RaftServer {
         /**
          * Callback function inboked when we receive a command from a client,
          * requesting to be replicated.  Does NOT initiate response to client
+         *
+         * Commands that arrive while another thread is flushing are queued,
+         * and the next flush appends and replicates them all at once (group
+         * commit). Blocks until this command has been appended to the log.
+         *
+         * The flushing thread then replicates the group to the followers
+         * while our own write of it is still being synced, and only counts
+         * us towards a majority for it once the sync is done. The next group
+         * may be appended meanwhile, so one sync of the log can cover several
+         * groups.
+         *
+         * @return index of the log entry holding the command, or -1 if it
+         *     could not be appended
          */
         int HandleClientCommand(char * command);
 
+        /**
+         * Appends a group of queued client commands to the log with a single
+         * write and marks each with its log index and term. If we are no
+         * longer leader, or the write fails (whatever part of the group was
+         * appended is removed again), every command is marked with log
+         * index -1.
+         *
+         * @param group - queued commands, in the order they should be logged
+         * @return index of the last appended entry, or -1 on failure
+         */
+        int FlushClientCommands(vector<QueuedCommand*>& group);
+
         /**
          * Callback function used to process messages we receive from peers.
          * Called any time we receive a message from any peer.
          *
          * @param peer - the peer connection from which we received the message
-         * @param raw_message - pointer to message received from peer
+         * @param raw_message - pointer to message received from peer, only
+         *      valid during the call
          * @param raw_message_len - length of message received from peer
          */
-        void HandlePeerMessage(Peer* peer, char* raw_message, int raw_message_len);
+        void HandlePeerMessage(Peer* peer, const char* raw_message, int raw_message_len);
+
+        /**
+         * Handles a PeerMessage once it has been decoded. Assumes that
+         * server_mutex is held.
+         */
+        void HandlePeerMessage(Peer* peer, const PeerMessage& message);
+
+        /**
+         * Handles an AppendEntries request or response received as a frame
+         * (see peer-frame.h) rather than a PeerMessage. Assumes that
+         * server_mutex is held.
+         */
+        void HandlePeerFrame(Peer* peer, const char* frame, int frame_len);
+
+        /**
+         * Steps down to follower if a message carries a newer term than ours.
+         *
+         * @param term - term of the message
+         * @param sender_id - server id of the message's sender
+         */
+        void CheckTerm(int term, int sender_id);
+
+        /**
+         * Handle AppendEntries requests and responses, however they were
+         * encoded. Assume that server_mutex is held; requests release it
+         * while syncing appended entries to disk.
+         */
+        void HandleAppendEntriesRequest(Peer* peer,
+            const AppendEntriesRequest& request);
+        void HandleAppendEntriesResponse(Peer* peer,
+            const AppendEntriesResponse& response);
 
         /**
          * Creates base message upon which all other message types are build.
@@ -94,10 +217,13 @@ class RaftServer {
          * The protocol buffer definition of the returned PeerMessage can be
          * found in peer.proto.
          *
+         * The message is allocated on send_arena, so it only lives until the
+         * next call to SendMessage, which should send it.
+         *
          * @param message_type The raft message type
          * @return a PeerMessage protocol buffer
          */
-        PeerMessage CreateMessage(PeerMessage_Type message_type);
+        PeerMessage* CreateMessage(PeerMessage_Type message_type);
 
         /*
          * Checks our log to see if any entries are now sufficiently
@@ -110,38 +236,201 @@ class RaftServer {
 
         /*
          * Called when we know a log is current term & replicated on a majority
-         * of servers.  Will apply & commit all entries between the previous
-         * applied index & current index.
+         * of servers.  Marks all entries through commit_index as committed,
+         * and wakes the applier thread to apply them.
          *
          * @param commit_index - entry through which we should commit
          */
         void CommitEntries(int commit_index);
 
+        /*
+         * Main body of the applier thread. Copies batches of committed
+         * entries out of the log while holding server_mutex, then applies
+         * them without it, so a slow command doesn't hold up heartbeats,
+         * elections or replication. Stops if a committed entry can't be
+         * read from the log.
+         */
+        void RunApplyThread();
+
+        /*
+         * Applies a batch of committed commands to the state machine in
+         * order and responds to their clients as it goes. Commands covered
+         * by a snapshot installed since they were copied are skipped. Takes
+         * apply_mutex.
+         *
+         * If enough entries have been applied since the last snapshot, also
+         * writes a new one, which SaveSnapshot then makes the latest.
+         *
+         * @param first_index - log index of the first command
+         * @param commands - the commands, in log order
+         * @param respond - whether to respond to clients (as the leader)
+         * @return index of the snapshot written, or -1 if none was
+         */
+        int ApplyEntries(int first_index, const vector<string>& commands,
+            bool respond);
+
+        /*
+         * Records applied_index in storage, if it has moved on since it was
+         * last recorded and either force is set, LAST_APPLIED_SAVE_ENTRIES
+         * entries have been applied since, or LAST_APPLIED_SAVE_INTERVAL has
+         * passed. Assumes that apply_mutex is held.
+         *
+         * @param force - record it whenever it has moved on
+         */
+        void SaveAppliedIndex(bool force);
+
+        /*
+         * Makes the snapshot written by ApplyEntries the latest one, then
+         * discards the log before it.  A failed snapshot is logged and
+         * retried after the next applied entry. Assumes that server_mutex
+         * is held.
+         *
+         * @param snapshot_index - index of the snapshot
+         */
+        void SaveSnapshot(int snapshot_index);
+
+        /*
+         * Returns the term of the log entry at index, which is either still
+         * in the log or the last entry covered by the snapshot.
+         *
+         * @param index - log index of the entry
+         * @return term of the entry, or -1 if it was discarded
+         */
+        int LogTerm(int index);
+
+        /*
+         * Finds the first log entry whose term is at least term, by binary
+         * search since terms never decrease along the log.
+         *
+         * @param term - the term to look for
+         * @param limit - last log index to search
+         * @return index of the entry, or limit + 1 if there is none
+         */
+        int FirstIndexWithTerm(int term, int limit);
+
+        /*
+         * Works out where to resume replicating to a peer from the conflict
+         * hints of its failed AppendEntries response: just after our last
+         * entry of the conflicting term if we have any, otherwise at the
+         * peer's first entry of that term (or the end of its log).
+         *
+         * @param response - the failed response, with conflict_first_index set
+         * @return the next index to send the peer
+         */
+        int ConflictNextIndex(const AppendEntriesResponse& response);
+
+        /*
+         * Installs the snapshot received from the leader: restores the state
+         * machine from it (once the applier is done with the batch it is
+         * applying), then keeps our log after index if it matches the
+         * snapshot, and discards it otherwise.
+         *
+         * @param index - index of the last entry covered by the snapshot
+         * @param term - term of the entry at index
+         * @return true if the snapshot was installed
+         */
+        bool InstallSnapshot(int index, int term);
+
+        /*
+         * Discards the whole log and starts it again after the snapshot,
+         * with a placeholder for the last entry the snapshot covers.
+         *
+         * @return true if the log was reset
+         */
+        bool ResetLogToSnapshot();
+
         /**
          * Sends a protocol buffer formatted message to the specified peer.
          *
          * @param peer - the peer to send this message to
          * @param message - the message (any type) to send to this peer
+         * @param body - if given, encoded fields sent right after the
+         *      message, which protobuf parses as part of it
+         */
+        void SendMessage(Peer *peer, PeerMessage &message,
+            shared_ptr<const string> body = nullptr);
+
+        /**
+         * Sends as many AppendEntries requests to the specified peer as its
+         * flow-control window allows. While pipelining, up to
+         * MAX_INFLIGHT_APPEND_ENTRIES requests may be unacknowledged; while
+         * probing for the point where our logs match, only one may be.
+         *
+         * @param peer - the peer to replicate our log to
+         * @param heartbeat - if true, send an (empty) request even when there
+         *      is nothing new to replicate or the window is full
+         * @param encoded_entries - if given, entries encoded for earlier
+         *      peers by the start index, which are reused and added to
          */
-        void SendMessage(Peer *peer, PeerMessage &message);
+        void ReplicateToPeer(Peer *peer, bool heartbeat,
+            map<int, EncodedEntries> *encoded_entries = NULL);
 
         /**
-         * Sends an AppendEntries request to the specified peer. For now, the
-         * log sent is empty and this is just used as a heartbeat.
+         * Sends an AppendEntries request to the specified peer, carrying as
+         * many entries starting at the peer's next index as fit within
+         * MAX_APPEND_ENTRIES_COUNT and MAX_APPEND_ENTRIES_BYTES. If the peer
+         * is already up to date, the request is empty and acts as a heartbeat.
+         *
+         * When pipelining, the peer's next index is advanced past the sent
+         * entries right away, without waiting for the response.
          *
          * @param peer - the peer to send the AppendEntries request to
+         * @param heartbeat - if true, send an empty request
+         * @param encoded_entries - as for ReplicateToPeer
          */
-        void SendAppendEntriesRequest(Peer *peer);
+        void SendAppendEntriesRequest(Peer *peer, bool heartbeat,
+            map<int, EncodedEntries> *encoded_entries);
 
         /**
-         * Responds to an AppendEntries request. For now, success is nearly
-         * always true unless the sender has an old term.
+         * Encodes as many entries starting at start_index as fit within
+         * MAX_APPEND_ENTRIES_COUNT and MAX_APPEND_ENTRIES_BYTES, straight
+         * from the log, for an AppendEntries request, unless they were
+         * encoded that way already.
+         *
+         * @param start_index - index of the first entry to encode
+         * @param frame - whether to encode them for a frame or a PeerMessage
+         * @param encoded - where the encoding and entry count are stored
+         */
+        void EncodeEntries(int start_index, bool frame, EncodedEntries& encoded);
+
+        /**
+         * Responds to an AppendEntries request.
          *
          * @param peer - the peer to send the AppendEntries response to
          * @param success - whether we accepted the AppendEntries request
+         * @param appended_log_index - on success, the last index known to
+         *      match the leader's log; on failure, the index after the
+         *      request's prev_log_index
+         * @param conflict_term - on failure, the term of our entry at the
+         *      request's prev_log_index, or -1 if we don't have one
+         * @param conflict_first_index - on failure, the index of our first
+         *      entry of conflict_term, or the index after our last entry if
+         *      conflict_term is -1; 0 on success
          */
         void SendAppendEntriesResponse(Peer *peer, bool success,
-            int appended_log_index);
+            int appended_log_index, int conflict_term = -1,
+            int conflict_first_index = 0);
+
+        /**
+         * Sends the specified peer the next chunk of our latest snapshot,
+         * read straight from the snapshot file. Starts over from the
+         * beginning if a newer snapshot replaced the one being sent.
+         *
+         * @param peer - the peer to send the InstallSnapshot request to
+         */
+        void SendInstallSnapshotRequest(Peer *peer);
+
+        /**
+         * Responds to an InstallSnapshot request.
+         *
+         * @param peer - the peer to send the InstallSnapshot response to
+         * @param success - whether we stored the chunk
+         * @param last_included_index - index of the snapshot being received
+         * @param offset - number of bytes of the snapshot stored so far
+         * @param done - whether the snapshot has been installed
+         */
+        void SendInstallSnapshotResponse(Peer *peer, bool success,
+            int last_included_index, long offset, bool done);
 
         /**
          * Sends a RequestVote request to the specified peer.
@@ -191,6 +480,18 @@ class RaftServer {
         vector<ServerInfo> server_infos;
         vector<PeerInfo> peer_infos;
         vector<Peer*> peers;
+        PeerOptions peer_options;
+        /**
+         * Accepts connections from all peers, when each server has a single
+         * peer port. Null otherwise.
+         */
+        PeerListener *peer_listener = NULL;
+
+        /**
+         * Waits on the connections to all peers, and calls HandlePeerMessage
+         * for messages received on them, all from a single thread.
+         */
+        EventLoop peer_event_loop;
 
         ServerState server_state = Follower;
         RaftStorage storage;
@@ -212,7 +513,8 @@ class RaftServer {
 
         /**
          * Used by leader to track the next entry the leader should attempt
-         * to send to this particular peer
+         * to send to this particular peer. While pipelining this runs ahead
+         * of peer_match_indexes by the entries that are still in flight.
          */
         vector<int> peer_next_indexes;
         /**
@@ -220,6 +522,60 @@ class RaftServer {
          * in the cluster.
          */
         vector<int> peer_match_indexes;
+        /**
+         * Our own counterpart of peer_match_indexes while we are the leader:
+         * the last entry we know is durable in our log. New entries are sent
+         * to followers before they are synced here, so this can lag behind
+         * them.
+         */
+        int self_match_index;
+        /**
+         * Number of AppendEntries requests sent to each peer that have not
+         * been answered yet.
+         */
+        vector<int> peer_inflight_requests;
+        /**
+         * Whether we are still searching for the last entry our log has in
+         * common with each peer. A probing peer gets one request at a time;
+         * once a request succeeds, we switch to pipelining.
+         */
+        vector<bool> peer_probing;
+        /**
+         * Whether each peer has responded since the last heartbeat. Requests
+         * still unanswered after a whole heartbeat interval are assumed lost.
+         */
+        vector<bool> peer_responded;
+        /**
+         * Byte offset of the next snapshot chunk to send each peer, or -1 if
+         * we aren't sending it a snapshot. A peer is sent our snapshot once
+         * the entries it is missing have been discarded from our log, and
+         * gets one chunk at a time.
+         */
+        vector<long> peer_snapshot_offsets;
+        /**
+         * Index of the snapshot being sent to each peer.
+         */
+        vector<int> peer_snapshot_indexes;
+
+        /**
+         * Whether each peer's latest PeerMessage said it can decode frames,
+         * in which case we send it AppendEntries requests and responses as
+         * frames. Kept whatever our state.
+         */
+        vector<bool> peer_accepts_frames;
+
+        /**
+         * Last AppendEntries request received. Reused so that its entries
+         * don't need a new vector each time.
+         */
+        AppendEntriesRequest received_request;
+
+        /**
+         * Used by followers: index of the snapshot being received from the
+         * leader, and how many bytes of it have been written to disk so far.
+         */
+        int received_snapshot_index = -1;
+        long received_snapshot_offset = 0;
 
         /**
          * Vote record to track which servers have voted for this server in the
@@ -231,12 +587,59 @@ class RaftServer {
         /**
          * server_mutex prevents multiple handler functions from modifying the
          * server state at the same time. Specfically, we have timer threads and
-         * peer threads which may call callback functions in the RaftServer
-         * class and these should not ever run concurrently. All instance
+         * the peer event loop thread which may call callback functions in the
+         * RaftServer class and these should not ever run concurrently. All instance
          * methods that start with "Handle" should acquire this mutex for the
          * duration of their execution.
+         *
+         * The server is split into stages that each have their own lock, so
+         * they overlap: appending client commands to the log (group commit,
+         * below), replicating and tracking commits (server_mutex), and
+         * applying committed entries (the applier thread). Syncing the log
+         * happens outside all of them, and storage and the peer connections
+         * lock themselves.
          */
         mutex server_mutex;
 
+        /**
+         * Apply stage. The applier thread waits on apply_cv (with
+         * server_mutex) for committed_index to pass applied_index, the last
+         * entry applied to state_machine. saved_applied_index is the last
+         * one recorded in storage, at saved_applied_time. These and
+         * state_machine are guarded by apply_mutex, which may be taken while
+         * holding server_mutex but never the other way around. The thread
+         * exits once apply_stopped (guarded by server_mutex) is set.
+         */
+        condition_variable apply_cv;
+        int applied_index;
+        int saved_applied_index;
+        time_point<steady_clock> saved_applied_time;
+        mutex apply_mutex;
+        bool apply_stopped = false;
+        thread apply_thread;
+
+        /**
+         * Group commit state. Client commands are queued in queued_commands
+         * until a thread picks them up as a group and flushes them to the log.
+         * group_commit_flushing is true while a flush is in progress. Guarded
+         * by group_commit_mutex, which is never held while waiting for
+         * server_mutex.
+         */
+        vector<QueuedCommand*> queued_commands;
+        bool group_commit_flushing = false;
+        condition_variable group_commit_cv;
+        mutex group_commit_mutex;
+
         BashStateMachine state_machine;
+
+        /**
+         * Arenas that PeerMessages are allocated on while being received and
+         * sent, which are reset after each message. Each arena starts out
+         * with a fixed block, so most messages are handled without touching
+         * the heap. Only used while holding server_mutex.
+         */
+        char receive_arena_block[MESSAGE_ARENA_BLOCK_BYTES];
+        google::protobuf::Arena receive_arena;
+        char send_arena_block[MESSAGE_ARENA_BLOCK_BYTES];
+        google::protobuf::Arena send_arena;
 };
@@ -1,8 +1,10 @@
 #include "raft-storage.h"
 
-RaftStorage::RaftStorage(string storage_path) : storage_path(storage_path) {}
+RaftStorage::RaftStorage(string storage_path, bool sync_writes) :
+    storage_path(storage_path), sync_writes(sync_writes) {}
 
 void RaftStorage::Load() {
+    lock_guard<mutex> lock(storage_mutex);
     fstream input(storage_path, ios::in | ios::binary);
     if (!storage_message.ParseFromIstream(&input)) {
         throw RaftStorageException("Failed to read storage: " + storage_path);
@@ -11,41 +13,164 @@ void RaftStorage::Load() {
 }
 
 void RaftStorage::Reset() {
+    lock_guard<mutex> lock(storage_mutex);
+    fstream input(storage_path, ios::in | ios::binary);
+    if (storage_message.ParseFromIstream(&input) &&
+            storage_message.snapshot_index() > 0) {
+        remove(SnapshotPath(storage_message.snapshot_index()).c_str());
+    }
+    remove(ReceivedSnapshotPath().c_str());
     storage_message.Clear();
     storage_message.set_current_term(0);
     storage_message.set_voted_for(-1);
     storage_message.set_last_applied(0);
+    storage_message.set_snapshot_index(0);
+    storage_message.set_snapshot_term(0);
     Save();
 }
 
 int RaftStorage::current_term() const {
+    lock_guard<mutex> lock(storage_mutex);
     return storage_message.current_term();
 }
 
 int RaftStorage::voted_for() const {
+    lock_guard<mutex> lock(storage_mutex);
     return storage_message.voted_for();
 }
 
 void RaftStorage::set_term_and_voted(int current_term, int voted_for) {
+    lock_guard<mutex> lock(storage_mutex);
     storage_message.set_current_term(current_term);
     storage_message.set_voted_for(voted_for);
     Save();
 }
 
 int RaftStorage::last_applied() const {
+    lock_guard<mutex> lock(storage_mutex);
     return storage_message.last_applied();
 }
 
 void RaftStorage::set_last_applied(int value) {
+    lock_guard<mutex> lock(storage_mutex);
     storage_message.set_last_applied(value);
     Save();
 }
 
+int RaftStorage::snapshot_index() const {
+    lock_guard<mutex> lock(storage_mutex);
+    return storage_message.snapshot_index();
+}
+
+int RaftStorage::snapshot_term() const {
+    lock_guard<mutex> lock(storage_mutex);
+    return storage_message.snapshot_term();
+}
+
+string RaftStorage::SnapshotPath(int index) const {
+    return storage_path + "_snapshot." + to_string(index);
+}
+
+void RaftStorage::WriteSnapshot(int index, StateMachine& state_machine) {
+    string tmp_path = WrittenSnapshotPath(index);
+    ofstream output(tmp_path, ios::out | ios::binary | ios::trunc);
+    state_machine.Serialize(output);
+    output.close();
+    if (!output) {
+        throw RaftStorageException("Failed to write snapshot: " + tmp_path);
+    }
+    // The snapshot must be complete on disk before storage refers to it
+    if (sync_writes && !Util::SyncFile(tmp_path.c_str())) {
+        throw RaftStorageException("Failed to sync snapshot: " + tmp_path);
+    }
+}
+
+void RaftStorage::SaveSnapshot(int index, int term) {
+    lock_guard<mutex> lock(storage_mutex);
+    if (index <= storage_message.snapshot_index()) {
+        remove(WrittenSnapshotPath(index).c_str());
+        return;
+    }
+    CommitSnapshot(WrittenSnapshotPath(index), index, term);
+}
+
+string RaftStorage::ReadSnapshotChunk(long offset, int max_len) {
+    string path = SnapshotPath(snapshot_index());
+    ifstream input(path, ios::in | ios::binary);
+    input.seekg(offset);
+    string chunk(max_len, '\0');
+    input.read(&chunk[0], max_len);
+    if (input.bad() || (!input && !input.eof())) {
+        throw RaftStorageException("Failed to read snapshot: " + path);
+    }
+    chunk.resize(input.gcount());
+    return chunk;
+}
+
+void RaftStorage::WriteSnapshotChunk(long offset, const string& data) {
+    string path = ReceivedSnapshotPath();
+    fstream output(path, ios::out | ios::binary |
+        (offset == 0 ? ios::trunc : ios::in));
+    output.seekp(0, ios::end);
+    if (!output || output.tellp() != offset) {
+        throw RaftStorageException("Snapshot chunk out of order: " + path);
+    }
+    output.write(data.data(), data.size());
+    output.close();
+    if (!output) {
+        throw RaftStorageException("Failed to write snapshot: " + path);
+    }
+}
+
+void RaftStorage::InstallSnapshot(int index, int term, StateMachine& state_machine) {
+    string path = ReceivedSnapshotPath();
+    ifstream input(path, ios::in | ios::binary);
+    if (!input) {
+        throw RaftStorageException("Failed to read snapshot: " + path);
+    }
+    state_machine.Restore(input);
+    if (input.bad()) {
+        throw RaftStorageException("Failed to restore snapshot: " + path);
+    }
+    input.close();
+    // The snapshot must be complete on disk before storage refers to it
+    if (sync_writes && !Util::SyncFile(path.c_str())) {
+        throw RaftStorageException("Failed to sync snapshot: " + path);
+    }
+    lock_guard<mutex> lock(storage_mutex);
+    storage_message.set_last_applied(max(storage_message.last_applied(), index));
+    CommitSnapshot(path, index, term);
+}
+
+void RaftStorage::CommitSnapshot(const string& tmp_path, int index, int term) {
+    string path = SnapshotPath(index);
+    if (rename(tmp_path.c_str(), path.c_str()) != 0 ||
+        (sync_writes && !Util::SyncDirectory(path.c_str()))) {
+        throw RaftStorageException("Failed to save snapshot: " + path);
+    }
+
+    int previous_index = storage_message.snapshot_index();
+    storage_message.set_snapshot_index(index);
+    storage_message.set_snapshot_term(term);
+    Save();
+    if (previous_index > 0 && previous_index != index) {
+        remove(SnapshotPath(previous_index).c_str());
+    }
+}
+
+string RaftStorage::ReceivedSnapshotPath() const {
+    return storage_path + "_snapshot.received";
+}
+
+string RaftStorage::WrittenSnapshotPath(int index) const {
+    return SnapshotPath(index) + ".tmp";
+}
+
 void RaftStorage::Save() {
     string storage_string;
     storage_message.SerializeToString(&storage_string);
     if (Util::PersistentFileUpdate(storage_path.c_str(), storage_string.c_str(),
-        storage_string.length()) == false) {
+        storage_string.length(), sync_writes) == false) {
         throw RaftStorageException("Failed to write storage: " + storage_path);
     }
 }
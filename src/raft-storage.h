@@ -3,14 +3,20 @@
  * persistent server state for a Raft server. All setter methods in this
  * class ensure that data is persisted to stable storage before
  * returning.
+ *
+ * This class is thread-safe (its methods can safely be called from different
+ * threads), so the state machine's progress can be recorded while the rest of
+ * the server carries on.
  */
 
 #pragma once
 
 #include <fstream>
 #include <cstdio>
+#include <mutex>
 
 #include "log.h"
+#include "state-machine.h"
 #include "storage-message.pb.h"
 #include "util.h"
 
@@ -35,8 +41,10 @@ class RaftStorage {
          * stable storage.
          *
          * @param storage_path Path to the storage file to use
+         * @param sync_writes Whether to fsync every update to the storage file
+         *     (otherwise updates are only flushed to the kernel)
          */
-        RaftStorage(string storage_path);
+        RaftStorage(string storage_path, bool sync_writes = false);
 
         /**
          * Load data from the storage file. Throw if the file does not exist.
@@ -46,7 +54,8 @@ class RaftStorage {
         void Load();
 
         /**
-         * Delete and recreate the storage file.
+         * Delete and recreate the storage file, along with the latest
+         * snapshot and any partly received one.
          */
         void Reset();
 
@@ -95,16 +104,126 @@ class RaftStorage {
          */
         void set_last_applied(int value);
 
+        /**
+         * Returns the index of the last log entry covered by the latest
+         * snapshot (0 if none has been taken).
+         *
+         * @return log index number of the snapshot
+         */
+        int snapshot_index() const;
+
+        /**
+         * Returns the term of the log entry at snapshot_index().
+         *
+         * @return term of the snapshot
+         */
+        int snapshot_term() const;
+
+        /**
+         * Returns the path of the snapshot file covering the log up to and
+         * including the given index.
+         *
+         * @param index log index number of the snapshot
+         * @return path of the snapshot file
+         */
+        string SnapshotPath(int index) const;
+
+        /**
+         * Serializes the state machine into a new snapshot file, which is
+         * not used until SaveSnapshot is called. The state machine must have
+         * applied exactly the log entries up to and including index.
+         *
+         * @param index log index number of the last applied entry
+         * @param state_machine state machine to serialize
+         * @throw RaftStorageException
+         */
+        void WriteSnapshot(int index, StateMachine& state_machine);
+        /**
+         * Records the snapshot written by WriteSnapshot as the latest
+         * snapshot and deletes the previous one. If a newer snapshot was
+         * saved or installed in the meantime, the written one is deleted
+         * instead.
+         *
+         * @param index log index number of the written snapshot
+         * @param term term of the log entry at index
+         * @throw RaftStorageException
+         */
+        void SaveSnapshot(int index, int term);
+
+        /**
+         * Returns up to max_len bytes of the latest snapshot file, starting
+         * at offset. A chunk shorter than max_len is the last one.
+         *
+         * @param offset byte offset of the chunk in the snapshot file
+         * @param max_len maximum number of bytes to return
+         * @return the bytes of the chunk
+         * @throw RaftStorageException
+         */
+        string ReadSnapshotChunk(long offset, int max_len);
+
+        /**
+         * Writes a chunk of a snapshot being received from another server
+         * to disk. Chunks must be written in order; a chunk at offset 0
+         * discards whatever was received before it.
+         *
+         * @param offset byte offset of the chunk in the snapshot file
+         * @param data the bytes of the chunk
+         * @throw RaftStorageException
+         */
+        void WriteSnapshotChunk(long offset, const string& data);
+
+        /**
+         * Restores the state machine from the snapshot received through
+         * WriteSnapshotChunk, then records it as the latest snapshot, marks
+         * everything up to and including index as applied, and deletes the
+         * previous snapshot.
+         *
+         * @param index log index number of the last entry in the snapshot
+         * @param term term of the log entry at index
+         * @param state_machine state machine to restore
+         * @throw RaftStorageException
+         */
+        void InstallSnapshot(int index, int term, StateMachine& state_machine);
+
     private:
         /**
          * Persist the storage state to disk. This method blocks until the data
          * is persisted to disk. This should be called by all the setters in
-         * this class.
+         * this class, holding storage_mutex.
          *
          * @throw RaftStorageException
          */
         void Save();
 
+        /**
+         * Makes a complete snapshot file at tmp_path, already synced to
+         * disk, the latest snapshot, covering the log up to and including
+         * index, and deletes the previous one. The caller must hold
+         * storage_mutex, and may set other fields of storage_message
+         * beforehand, to be saved along with it.
+         *
+         * @throw RaftStorageException
+         */
+        void CommitSnapshot(const string& tmp_path, int index, int term);
+
+        /**
+         * Returns the path of the snapshot being received from another
+         * server.
+         */
+        string ReceivedSnapshotPath() const;
+
+        /**
+         * Returns the path WriteSnapshot writes the snapshot at index to.
+         */
+        string WrittenSnapshotPath(int index) const;
+
         string storage_path;
+        bool sync_writes;
         StorageMessage storage_message;
+
+        /**
+         * Guards storage_message and the storage file. Not held while a
+         * state machine is serialized or restored.
+         */
+        mutable mutex storage_mutex;
 };
@@ -17,6 +17,9 @@ int main(int argc, char* argv[]) {
     args.RegisterInt("id", "Server identifier");
     args.RegisterString("config", "Path to configuration file (default = ./config)");
     args.RegisterBool("reset", "Delete server storage");
+    args.RegisterBool("fsync", "Sync log and storage writes to disk");
+    args.RegisterBool("nagle", "Let TCP delay small peer messages");
+    args.RegisterBool("cork", "Cork peer sockets while sending a batch");
     args.RegisterBool("debug", "Show all logs");
     args.RegisterBool("quiet", "Show only errors");
 
@@ -69,7 +72,12 @@ int main(int argc, char* argv[]) {
     vector<ServerInfo> server_infos = raft_config.get_server_infos();
     vector<PeerInfo> peer_infos = raft_config.get_peer_infos();
 
-    RaftServer raft_server(server_id, server_infos, peer_infos);
+    PeerOptions peer_options;
+    peer_options.no_delay = !args.get_bool("nagle");
+    peer_options.cork = args.get_bool("cork");
+
+    RaftServer raft_server(server_id, server_infos, peer_infos,
+        args.get_bool("fsync"), peer_options);
     try {
         raft_server.Run();
     } catch (exception& err) {
@@ -3,7 +3,8 @@
  * This is an abstract class and it should be subclassed to create a specific
  * type of state machine. This interface is the most minimal interface for a
  * state machine. There's a single `Apply` method to apply state transitions to
- * the state machine.
+ * the state machine, plus `Serialize` and `Restore` methods so the state can
+ * be captured in a snapshot, which lets Raft discard the log behind it.
  *
  * For this Raft project, we create a single subclass called `BashStateMachine`
  * which is defined in bash-state-machine.h.
@@ -11,6 +12,8 @@
 
 #pragma once
 
+#include <istream>
+#include <ostream>
 #include <string>
 
 using namespace std;
@@ -46,4 +49,22 @@ class StateMachine {
          * @return State after the state transition
          */
         virtual string Apply(string command) = 0;
+
+        /**
+         * Write the current state of the state machine (everything the
+         * commands applied so far have done to it) to the given stream, in a
+         * form Restore can read back. Should be overriden in the subclass.
+         *
+         * @param output Stream to write the snapshot to
+         */
+        virtual void Serialize(ostream& output) = 0;
+
+        /**
+         * Replace the state of the state machine with a snapshot written by
+         * Serialize, e.g. one received from another server. Should be
+         * overriden in the subclass.
+         *
+         * @param input Stream to read the snapshot from
+         */
+        virtual void Restore(istream& input) = 0;
 };
@@ -5,312 +5,309 @@
 
 #include <algorithm>
 
-#include <google/protobuf/stubs/common.h>
-#include <google/protobuf/stubs/port.h>
 #include <google/protobuf/io/coded_stream.h>
-#include <google/protobuf/wire_format_lite_inl.h>
+#include <google/protobuf/extension_set.h>
+#include <google/protobuf/wire_format_lite.h>
 #include <google/protobuf/descriptor.h>
 #include <google/protobuf/generated_message_reflection.h>
 #include <google/protobuf/reflection_ops.h>
 #include <google/protobuf/wire_format.h>
-// This is a temporary google only hack
-#ifdef GOOGLE_PROTOBUF_ENFORCE_UNIQUENESS
-#include "third_party/protobuf/version.h"
-#endif
 // @@protoc_insertion_point(includes)
+#include <google/protobuf/port_def.inc>
 
-namespace proto {
-class StorageMessageDefaultTypeInternal {
- public:
-  ::google::protobuf::internal::ExplicitlyConstructed<StorageMessage>
-      _instance;
-} _StorageMessage_default_instance_;
-}  // namespace proto
-namespace protobuf_storage_2dmessage_2eproto {
-static void InitDefaultsStorageMessage() {
-  GOOGLE_PROTOBUF_VERIFY_VERSION;
-
-  {
-    void* ptr = &::proto::_StorageMessage_default_instance_;
-    new (ptr) ::proto::StorageMessage();
-    ::google::protobuf::internal::OnShutdownDestroyMessage(ptr);
-  }
-  ::proto::StorageMessage::InitAsDefaultInstance();
-}
+PROTOBUF_PRAGMA_INIT_SEG
 
-::google::protobuf::internal::SCCInfo<0> scc_info_StorageMessage =
-    {{ATOMIC_VAR_INIT(::google::protobuf::internal::SCCInfoBase::kUninitialized), 0, InitDefaultsStorageMessage}, {}};
+namespace _pb = ::PROTOBUF_NAMESPACE_ID;
+namespace _pbi = _pb::internal;
 
-void InitDefaults() {
-  ::google::protobuf::internal::InitSCC(&scc_info_StorageMessage.base);
-}
-
-::google::protobuf::Metadata file_level_metadata[1];
+namespace proto {
+PROTOBUF_CONSTEXPR StorageMessage::StorageMessage(
+    ::_pbi::ConstantInitialized): _impl_{
+    /*decltype(_impl_._has_bits_)*/{}
+  , /*decltype(_impl_._cached_size_)*/{}
+  , /*decltype(_impl_.current_term_)*/0
+  , /*decltype(_impl_.voted_for_)*/0
+  , /*decltype(_impl_.last_applied_)*/0
+  , /*decltype(_impl_.snapshot_index_)*/0
+  , /*decltype(_impl_.snapshot_term_)*/0} {}
+struct StorageMessageDefaultTypeInternal {
+  PROTOBUF_CONSTEXPR StorageMessageDefaultTypeInternal()
+      : _instance(::_pbi::ConstantInitialized{}) {}
+  ~StorageMessageDefaultTypeInternal() {}
+  union {
+    StorageMessage _instance;
+  };
+};
+PROTOBUF_ATTRIBUTE_NO_DESTROY PROTOBUF_CONSTINIT PROTOBUF_ATTRIBUTE_INIT_PRIORITY1 StorageMessageDefaultTypeInternal _StorageMessage_default_instance_;
+}  // namespace proto
+static ::_pb::Metadata file_level_metadata_storage_2dmessage_2eproto[1];
+static constexpr ::_pb::EnumDescriptor const** file_level_enum_descriptors_storage_2dmessage_2eproto = nullptr;
+static constexpr ::_pb::ServiceDescriptor const** file_level_service_descriptors_storage_2dmessage_2eproto = nullptr;
 
-const ::google::protobuf::uint32 TableStruct::offsets[] GOOGLE_PROTOBUF_ATTRIBUTE_SECTION_VARIABLE(protodesc_cold) = {
-  GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(::proto::StorageMessage, _has_bits_),
-  GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(::proto::StorageMessage, _internal_metadata_),
+const uint32_t TableStruct_storage_2dmessage_2eproto::offsets[] PROTOBUF_SECTION_VARIABLE(protodesc_cold) = {
+  PROTOBUF_FIELD_OFFSET(::proto::StorageMessage, _impl_._has_bits_),
+  PROTOBUF_FIELD_OFFSET(::proto::StorageMessage, _internal_metadata_),
   ~0u,  // no _extensions_
   ~0u,  // no _oneof_case_
   ~0u,  // no _weak_field_map_
-  GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(::proto::StorageMessage, current_term_),
-  GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(::proto::StorageMessage, voted_for_),
-  GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(::proto::StorageMessage, last_applied_),
+  ~0u,  // no _inlined_string_donated_
+  PROTOBUF_FIELD_OFFSET(::proto::StorageMessage, _impl_.current_term_),
+  PROTOBUF_FIELD_OFFSET(::proto::StorageMessage, _impl_.voted_for_),
+  PROTOBUF_FIELD_OFFSET(::proto::StorageMessage, _impl_.last_applied_),
+  PROTOBUF_FIELD_OFFSET(::proto::StorageMessage, _impl_.snapshot_index_),
+  PROTOBUF_FIELD_OFFSET(::proto::StorageMessage, _impl_.snapshot_term_),
   0,
   1,
   2,
+  3,
+  4,
 };
-static const ::google::protobuf::internal::MigrationSchema schemas[] GOOGLE_PROTOBUF_ATTRIBUTE_SECTION_VARIABLE(protodesc_cold) = {
-  { 0, 8, sizeof(::proto::StorageMessage)},
+static const ::_pbi::MigrationSchema schemas[] PROTOBUF_SECTION_VARIABLE(protodesc_cold) = {
+  { 0, 11, -1, sizeof(::proto::StorageMessage)},
 };
 
-static ::google::protobuf::Message const * const file_default_instances[] = {
-  reinterpret_cast<const ::google::protobuf::Message*>(&::proto::_StorageMessage_default_instance_),
+static const ::_pb::Message* const file_default_instances[] = {
+  &::proto::_StorageMessage_default_instance_._instance,
 };
 
-void protobuf_AssignDescriptors() {
-  AddDescriptors();
-  AssignDescriptors(
-      "storage-message.proto", schemas, file_default_instances, TableStruct::offsets,
-      file_level_metadata, NULL, NULL);
-}
-
-void protobuf_AssignDescriptorsOnce() {
-  static ::google::protobuf::internal::once_flag once;
-  ::google::protobuf::internal::call_once(once, protobuf_AssignDescriptors);
-}
-
-void protobuf_RegisterTypes(const ::std::string&) GOOGLE_PROTOBUF_ATTRIBUTE_COLD;
-void protobuf_RegisterTypes(const ::std::string&) {
-  protobuf_AssignDescriptorsOnce();
-  ::google::protobuf::internal::RegisterAllTypes(file_level_metadata, 1);
-}
-
-void AddDescriptorsImpl() {
-  InitDefaults();
-  static const char descriptor[] GOOGLE_PROTOBUF_ATTRIBUTE_SECTION_VARIABLE(protodesc_cold) = {
-      "\n\025storage-message.proto\022\005proto\"O\n\016Storag"
-      "eMessage\022\024\n\014current_term\030\001 \002(\005\022\021\n\tvoted_"
-      "for\030\002 \002(\005\022\024\n\014last_applied\030\003 \002(\005"
-  };
-  ::google::protobuf::DescriptorPool::InternalAddGeneratedFile(
-      descriptor, 111);
-  ::google::protobuf::MessageFactory::InternalRegisterGeneratedFile(
-    "storage-message.proto", &protobuf_RegisterTypes);
+const char descriptor_table_protodef_storage_2dmessage_2eproto[] PROTOBUF_SECTION_VARIABLE(protodesc_cold) =
+  "\n\025storage-message.proto\022\005proto\"\204\001\n\016Stora"
+  "geMessage\022\024\n\014current_term\030\001 \002(\005\022\021\n\tvoted"
+  "_for\030\002 \002(\005\022\024\n\014last_applied\030\003 \002(\005\022\031\n\016snap"
+  "shot_index\030\004 \001(\005:\0010\022\030\n\rsnapshot_term\030\005 \001"
+  "(\005:\0010"
+  ;
+static ::_pbi::once_flag descriptor_table_storage_2dmessage_2eproto_once;
+const ::_pbi::DescriptorTable descriptor_table_storage_2dmessage_2eproto = {
+    false, false, 165, descriptor_table_protodef_storage_2dmessage_2eproto,
+    "storage-message.proto",
+    &descriptor_table_storage_2dmessage_2eproto_once, nullptr, 0, 1,
+    schemas, file_default_instances, TableStruct_storage_2dmessage_2eproto::offsets,
+    file_level_metadata_storage_2dmessage_2eproto, file_level_enum_descriptors_storage_2dmessage_2eproto,
+    file_level_service_descriptors_storage_2dmessage_2eproto,
+};
+PROTOBUF_ATTRIBUTE_WEAK const ::_pbi::DescriptorTable* descriptor_table_storage_2dmessage_2eproto_getter() {
+  return &descriptor_table_storage_2dmessage_2eproto;
 }
 
-void AddDescriptors() {
-  static ::google::protobuf::internal::once_flag once;
-  ::google::protobuf::internal::call_once(once, AddDescriptorsImpl);
-}
-// Force AddDescriptors() to be called at dynamic initialization time.
-struct StaticDescriptorInitializer {
-  StaticDescriptorInitializer() {
-    AddDescriptors();
-  }
-} static_descriptor_initializer;
-}  // namespace protobuf_storage_2dmessage_2eproto
+// Force running AddDescriptors() at dynamic initialization time.
+PROTOBUF_ATTRIBUTE_INIT_PRIORITY2 static ::_pbi::AddDescriptorsRunner dynamic_init_dummy_storage_2dmessage_2eproto(&descriptor_table_storage_2dmessage_2eproto);
 namespace proto {
 
 // ===================================================================
 
-void StorageMessage::InitAsDefaultInstance() {
-}
-#if !defined(_MSC_VER) || _MSC_VER >= 1900
-const int StorageMessage::kCurrentTermFieldNumber;
-const int StorageMessage::kVotedForFieldNumber;
-const int StorageMessage::kLastAppliedFieldNumber;
-#endif  // !defined(_MSC_VER) || _MSC_VER >= 1900
-
-StorageMessage::StorageMessage()
-  : ::google::protobuf::Message(), _internal_metadata_(NULL) {
-  ::google::protobuf::internal::InitSCC(
-      &protobuf_storage_2dmessage_2eproto::scc_info_StorageMessage.base);
-  SharedCtor();
-  // @@protoc_insertion_point(constructor:proto.StorageMessage)
+class StorageMessage::_Internal {
+ public:
+  using HasBits = decltype(std::declval<StorageMessage>()._impl_._has_bits_);
+  static void set_has_current_term(HasBits* has_bits) {
+    (*has_bits)[0] |= 1u;
+  }
+  static void set_has_voted_for(HasBits* has_bits) {
+    (*has_bits)[0] |= 2u;
+  }
+  static void set_has_last_applied(HasBits* has_bits) {
+    (*has_bits)[0] |= 4u;
+  }
+  static void set_has_snapshot_index(HasBits* has_bits) {
+    (*has_bits)[0] |= 8u;
+  }
+  static void set_has_snapshot_term(HasBits* has_bits) {
+    (*has_bits)[0] |= 16u;
+  }
+  static bool MissingRequiredFields(const HasBits& has_bits) {
+    return ((has_bits[0] & 0x00000007) ^ 0x00000007) != 0;
+  }
+};
+
+StorageMessage::StorageMessage(::PROTOBUF_NAMESPACE_ID::Arena* arena,
+                         bool is_message_owned)
+  : ::PROTOBUF_NAMESPACE_ID::Message(arena, is_message_owned) {
+  SharedCtor(arena, is_message_owned);
+  // @@protoc_insertion_point(arena_constructor:proto.StorageMessage)
 }
 StorageMessage::StorageMessage(const StorageMessage& from)
-  : ::google::protobuf::Message(),
-      _internal_metadata_(NULL),
-      _has_bits_(from._has_bits_) {
-  _internal_metadata_.MergeFrom(from._internal_metadata_);
-  ::memcpy(&current_term_, &from.current_term_,
-    static_cast<size_t>(reinterpret_cast<char*>(&last_applied_) -
-    reinterpret_cast<char*>(&current_term_)) + sizeof(last_applied_));
+  : ::PROTOBUF_NAMESPACE_ID::Message() {
+  StorageMessage* const _this = this; (void)_this;
+  new (&_impl_) Impl_{
+      decltype(_impl_._has_bits_){from._impl_._has_bits_}
+    , /*decltype(_impl_._cached_size_)*/{}
+    , decltype(_impl_.current_term_){}
+    , decltype(_impl_.voted_for_){}
+    , decltype(_impl_.last_applied_){}
+    , decltype(_impl_.snapshot_index_){}
+    , decltype(_impl_.snapshot_term_){}};
+
+  _internal_metadata_.MergeFrom<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(from._internal_metadata_);
+  ::memcpy(&_impl_.current_term_, &from._impl_.current_term_,
+    static_cast<size_t>(reinterpret_cast<char*>(&_impl_.snapshot_term_) -
+    reinterpret_cast<char*>(&_impl_.current_term_)) + sizeof(_impl_.snapshot_term_));
   // @@protoc_insertion_point(copy_constructor:proto.StorageMessage)
 }
 
-void StorageMessage::SharedCtor() {
-  ::memset(&current_term_, 0, static_cast<size_t>(
-      reinterpret_cast<char*>(&last_applied_) -
-      reinterpret_cast<char*>(&current_term_)) + sizeof(last_applied_));
+inline void StorageMessage::SharedCtor(
+    ::_pb::Arena* arena, bool is_message_owned) {
+  (void)arena;
+  (void)is_message_owned;
+  new (&_impl_) Impl_{
+      decltype(_impl_._has_bits_){}
+    , /*decltype(_impl_._cached_size_)*/{}
+    , decltype(_impl_.current_term_){0}
+    , decltype(_impl_.voted_for_){0}
+    , decltype(_impl_.last_applied_){0}
+    , decltype(_impl_.snapshot_index_){0}
+    , decltype(_impl_.snapshot_term_){0}
+  };
 }
 
 StorageMessage::~StorageMessage() {
   // @@protoc_insertion_point(destructor:proto.StorageMessage)
+  if (auto *arena = _internal_metadata_.DeleteReturnArena<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>()) {
+  (void)arena;
+    return;
+  }
   SharedDtor();
 }
 
-void StorageMessage::SharedDtor() {
+inline void StorageMessage::SharedDtor() {
+  GOOGLE_DCHECK(GetArenaForAllocation() == nullptr);
 }
 
 void StorageMessage::SetCachedSize(int size) const {
-  _cached_size_.Set(size);
-}
-const ::google::protobuf::Descriptor* StorageMessage::descriptor() {
-  ::protobuf_storage_2dmessage_2eproto::protobuf_AssignDescriptorsOnce();
-  return ::protobuf_storage_2dmessage_2eproto::file_level_metadata[kIndexInFileMessages].descriptor;
-}
-
-const StorageMessage& StorageMessage::default_instance() {
-  ::google::protobuf::internal::InitSCC(&protobuf_storage_2dmessage_2eproto::scc_info_StorageMessage.base);
-  return *internal_default_instance();
+  _impl_._cached_size_.Set(size);
 }
 
-
 void StorageMessage::Clear() {
 // @@protoc_insertion_point(message_clear_start:proto.StorageMessage)
-  ::google::protobuf::uint32 cached_has_bits = 0;
+  uint32_t cached_has_bits = 0;
   // Prevent compiler warnings about cached_has_bits being unused
   (void) cached_has_bits;
 
-  cached_has_bits = _has_bits_[0];
-  if (cached_has_bits & 7u) {
-    ::memset(&current_term_, 0, static_cast<size_t>(
-        reinterpret_cast<char*>(&last_applied_) -
-        reinterpret_cast<char*>(&current_term_)) + sizeof(last_applied_));
+  cached_has_bits = _impl_._has_bits_[0];
+  if (cached_has_bits & 0x0000001fu) {
+    ::memset(&_impl_.current_term_, 0, static_cast<size_t>(
+        reinterpret_cast<char*>(&_impl_.snapshot_term_) -
+        reinterpret_cast<char*>(&_impl_.current_term_)) + sizeof(_impl_.snapshot_term_));
   }
-  _has_bits_.Clear();
-  _internal_metadata_.Clear();
+  _impl_._has_bits_.Clear();
+  _internal_metadata_.Clear<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>();
 }
 
-bool StorageMessage::MergePartialFromCodedStream(
-    ::google::protobuf::io::CodedInputStream* input) {
-#define DO_(EXPRESSION) if (!GOOGLE_PREDICT_TRUE(EXPRESSION)) goto failure
-  ::google::protobuf::uint32 tag;
-  // @@protoc_insertion_point(parse_start:proto.StorageMessage)
-  for (;;) {
-    ::std::pair<::google::protobuf::uint32, bool> p = input->ReadTagWithCutoffNoLastTag(127u);
-    tag = p.first;
-    if (!p.second) goto handle_unusual;
-    switch (::google::protobuf::internal::WireFormatLite::GetTagFieldNumber(tag)) {
+const char* StorageMessage::_InternalParse(const char* ptr, ::_pbi::ParseContext* ctx) {
+#define CHK_(x) if (PROTOBUF_PREDICT_FALSE(!(x))) goto failure
+  _Internal::HasBits has_bits{};
+  while (!ctx->Done(&ptr)) {
+    uint32_t tag;
+    ptr = ::_pbi::ReadTag(ptr, &tag);
+    switch (tag >> 3) {
       // required int32 current_term = 1;
-      case 1: {
-        if (static_cast< ::google::protobuf::uint8>(tag) ==
-            static_cast< ::google::protobuf::uint8>(8u /* 8 & 0xFF */)) {
-          set_has_current_term();
-          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
-                   ::google::protobuf::int32, ::google::protobuf::internal::WireFormatLite::TYPE_INT32>(
-                 input, &current_term_)));
-        } else {
+      case 1:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 8)) {
+          _Internal::set_has_current_term(&has_bits);
+          _impl_.current_term_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
           goto handle_unusual;
-        }
-        break;
-      }
-
+        continue;
       // required int32 voted_for = 2;
-      case 2: {
-        if (static_cast< ::google::protobuf::uint8>(tag) ==
-            static_cast< ::google::protobuf::uint8>(16u /* 16 & 0xFF */)) {
-          set_has_voted_for();
-          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
-                   ::google::protobuf::int32, ::google::protobuf::internal::WireFormatLite::TYPE_INT32>(
-                 input, &voted_for_)));
-        } else {
+      case 2:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 16)) {
+          _Internal::set_has_voted_for(&has_bits);
+          _impl_.voted_for_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
           goto handle_unusual;
-        }
-        break;
-      }
-
+        continue;
       // required int32 last_applied = 3;
-      case 3: {
-        if (static_cast< ::google::protobuf::uint8>(tag) ==
-            static_cast< ::google::protobuf::uint8>(24u /* 24 & 0xFF */)) {
-          set_has_last_applied();
-          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
-                   ::google::protobuf::int32, ::google::protobuf::internal::WireFormatLite::TYPE_INT32>(
-                 input, &last_applied_)));
-        } else {
+      case 3:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 24)) {
+          _Internal::set_has_last_applied(&has_bits);
+          _impl_.last_applied_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      // optional int32 snapshot_index = 4 [default = 0];
+      case 4:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 32)) {
+          _Internal::set_has_snapshot_index(&has_bits);
+          _impl_.snapshot_index_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
           goto handle_unusual;
-        }
-        break;
-      }
-
-      default: {
-      handle_unusual:
-        if (tag == 0) {
-          goto success;
-        }
-        DO_(::google::protobuf::internal::WireFormat::SkipField(
-              input, tag, _internal_metadata_.mutable_unknown_fields()));
-        break;
-      }
+        continue;
+      // optional int32 snapshot_term = 5 [default = 0];
+      case 5:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 40)) {
+          _Internal::set_has_snapshot_term(&has_bits);
+          _impl_.snapshot_term_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint32(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      default:
+        goto handle_unusual;
+    }  // switch
+  handle_unusual:
+    if ((tag == 0) || ((tag & 7) == 4)) {
+      CHK_(ptr);
+      ctx->SetLastTag(tag);
+      goto message_done;
     }
-  }
-success:
-  // @@protoc_insertion_point(parse_success:proto.StorageMessage)
-  return true;
+    ptr = UnknownFieldParse(
+        tag,
+        _internal_metadata_.mutable_unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(),
+        ptr, ctx);
+    CHK_(ptr != nullptr);
+  }  // while
+message_done:
+  _impl_._has_bits_.Or(has_bits);
+  return ptr;
 failure:
-  // @@protoc_insertion_point(parse_failure:proto.StorageMessage)
-  return false;
-#undef DO_
+  ptr = nullptr;
+  goto message_done;
+#undef CHK_
 }
 
-void StorageMessage::SerializeWithCachedSizes(
-    ::google::protobuf::io::CodedOutputStream* output) const {
-  // @@protoc_insertion_point(serialize_start:proto.StorageMessage)
-  ::google::protobuf::uint32 cached_has_bits = 0;
+uint8_t* StorageMessage::_InternalSerialize(
+    uint8_t* target, ::PROTOBUF_NAMESPACE_ID::io::EpsCopyOutputStream* stream) const {
+  // @@protoc_insertion_point(serialize_to_array_start:proto.StorageMessage)
+  uint32_t cached_has_bits = 0;
   (void) cached_has_bits;
 
-  cached_has_bits = _has_bits_[0];
+  cached_has_bits = _impl_._has_bits_[0];
   // required int32 current_term = 1;
   if (cached_has_bits & 0x00000001u) {
-    ::google::protobuf::internal::WireFormatLite::WriteInt32(1, this->current_term(), output);
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteInt32ToArray(1, this->_internal_current_term(), target);
   }
 
   // required int32 voted_for = 2;
   if (cached_has_bits & 0x00000002u) {
-    ::google::protobuf::internal::WireFormatLite::WriteInt32(2, this->voted_for(), output);
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteInt32ToArray(2, this->_internal_voted_for(), target);
   }
 
   // required int32 last_applied = 3;
   if (cached_has_bits & 0x00000004u) {
-    ::google::protobuf::internal::WireFormatLite::WriteInt32(3, this->last_applied(), output);
-  }
-
-  if (_internal_metadata_.have_unknown_fields()) {
-    ::google::protobuf::internal::WireFormat::SerializeUnknownFields(
-        _internal_metadata_.unknown_fields(), output);
-  }
-  // @@protoc_insertion_point(serialize_end:proto.StorageMessage)
-}
-
-::google::protobuf::uint8* StorageMessage::InternalSerializeWithCachedSizesToArray(
-    bool deterministic, ::google::protobuf::uint8* target) const {
-  (void)deterministic; // Unused
-  // @@protoc_insertion_point(serialize_to_array_start:proto.StorageMessage)
-  ::google::protobuf::uint32 cached_has_bits = 0;
-  (void) cached_has_bits;
-
-  cached_has_bits = _has_bits_[0];
-  // required int32 current_term = 1;
-  if (cached_has_bits & 0x00000001u) {
-    target = ::google::protobuf::internal::WireFormatLite::WriteInt32ToArray(1, this->current_term(), target);
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteInt32ToArray(3, this->_internal_last_applied(), target);
   }
 
-  // required int32 voted_for = 2;
-  if (cached_has_bits & 0x00000002u) {
-    target = ::google::protobuf::internal::WireFormatLite::WriteInt32ToArray(2, this->voted_for(), target);
+  // optional int32 snapshot_index = 4 [default = 0];
+  if (cached_has_bits & 0x00000008u) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteInt32ToArray(4, this->_internal_snapshot_index(), target);
   }
 
-  // required int32 last_applied = 3;
-  if (cached_has_bits & 0x00000004u) {
-    target = ::google::protobuf::internal::WireFormatLite::WriteInt32ToArray(3, this->last_applied(), target);
+  // optional int32 snapshot_term = 5 [default = 0];
+  if (cached_has_bits & 0x00000010u) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteInt32ToArray(5, this->_internal_snapshot_term(), target);
   }
 
-  if (_internal_metadata_.have_unknown_fields()) {
-    target = ::google::protobuf::internal::WireFormat::SerializeUnknownFieldsToArray(
-        _internal_metadata_.unknown_fields(), target);
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    target = ::_pbi::WireFormat::InternalSerializeUnknownFieldsToArray(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), target, stream);
   }
   // @@protoc_insertion_point(serialize_to_array_end:proto.StorageMessage)
   return target;
@@ -320,25 +317,19 @@ size_t StorageMessage::RequiredFieldsByteSizeFallback() const {
 // @@protoc_insertion_point(required_fields_byte_size_fallback_start:proto.StorageMessage)
   size_t total_size = 0;
 
-  if (has_current_term()) {
+  if (_internal_has_current_term()) {
     // required int32 current_term = 1;
-    total_size += 1 +
-      ::google::protobuf::internal::WireFormatLite::Int32Size(
-        this->current_term());
+    total_size += ::_pbi::WireFormatLite::Int32SizePlusOne(this->_internal_current_term());
   }
 
-  if (has_voted_for()) {
+  if (_internal_has_voted_for()) {
     // required int32 voted_for = 2;
-    total_size += 1 +
-      ::google::protobuf::internal::WireFormatLite::Int32Size(
-        this->voted_for());
+    total_size += ::_pbi::WireFormatLite::Int32SizePlusOne(this->_internal_voted_for());
   }
 
-  if (has_last_applied()) {
+  if (_internal_has_last_applied()) {
     // required int32 last_applied = 3;
-    total_size += 1 +
-      ::google::protobuf::internal::WireFormatLite::Int32Size(
-        this->last_applied());
+    total_size += ::_pbi::WireFormatLite::Int32SizePlusOne(this->_internal_last_applied());
   }
 
   return total_size;
@@ -347,77 +338,74 @@ size_t StorageMessage::ByteSizeLong() const {
 // @@protoc_insertion_point(message_byte_size_start:proto.StorageMessage)
   size_t total_size = 0;
 
-  if (_internal_metadata_.have_unknown_fields()) {
-    total_size +=
-      ::google::protobuf::internal::WireFormat::ComputeUnknownFieldsSize(
-        _internal_metadata_.unknown_fields());
-  }
-  if (((_has_bits_[0] & 0x00000007) ^ 0x00000007) == 0) {  // All required fields are present.
+  if (((_impl_._has_bits_[0] & 0x00000007) ^ 0x00000007) == 0) {  // All required fields are present.
     // required int32 current_term = 1;
-    total_size += 1 +
-      ::google::protobuf::internal::WireFormatLite::Int32Size(
-        this->current_term());
+    total_size += ::_pbi::WireFormatLite::Int32SizePlusOne(this->_internal_current_term());
 
     // required int32 voted_for = 2;
-    total_size += 1 +
-      ::google::protobuf::internal::WireFormatLite::Int32Size(
-        this->voted_for());
+    total_size += ::_pbi::WireFormatLite::Int32SizePlusOne(this->_internal_voted_for());
 
     // required int32 last_applied = 3;
-    total_size += 1 +
-      ::google::protobuf::internal::WireFormatLite::Int32Size(
-        this->last_applied());
+    total_size += ::_pbi::WireFormatLite::Int32SizePlusOne(this->_internal_last_applied());
 
   } else {
     total_size += RequiredFieldsByteSizeFallback();
   }
-  int cached_size = ::google::protobuf::internal::ToCachedSize(total_size);
-  SetCachedSize(cached_size);
-  return total_size;
-}
+  uint32_t cached_has_bits = 0;
+  // Prevent compiler warnings about cached_has_bits being unused
+  (void) cached_has_bits;
+
+  cached_has_bits = _impl_._has_bits_[0];
+  if (cached_has_bits & 0x00000018u) {
+    // optional int32 snapshot_index = 4 [default = 0];
+    if (cached_has_bits & 0x00000008u) {
+      total_size += ::_pbi::WireFormatLite::Int32SizePlusOne(this->_internal_snapshot_index());
+    }
+
+    // optional int32 snapshot_term = 5 [default = 0];
+    if (cached_has_bits & 0x00000010u) {
+      total_size += ::_pbi::WireFormatLite::Int32SizePlusOne(this->_internal_snapshot_term());
+    }
 
-void StorageMessage::MergeFrom(const ::google::protobuf::Message& from) {
-// @@protoc_insertion_point(generalized_merge_from_start:proto.StorageMessage)
-  GOOGLE_DCHECK_NE(&from, this);
-  const StorageMessage* source =
-      ::google::protobuf::internal::DynamicCastToGenerated<const StorageMessage>(
-          &from);
-  if (source == NULL) {
-  // @@protoc_insertion_point(generalized_merge_from_cast_fail:proto.StorageMessage)
-    ::google::protobuf::internal::ReflectionOps::Merge(from, this);
-  } else {
-  // @@protoc_insertion_point(generalized_merge_from_cast_success:proto.StorageMessage)
-    MergeFrom(*source);
   }
+  return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
 }
 
-void StorageMessage::MergeFrom(const StorageMessage& from) {
-// @@protoc_insertion_point(class_specific_merge_from_start:proto.StorageMessage)
-  GOOGLE_DCHECK_NE(&from, this);
-  _internal_metadata_.MergeFrom(from._internal_metadata_);
-  ::google::protobuf::uint32 cached_has_bits = 0;
+const ::PROTOBUF_NAMESPACE_ID::Message::ClassData StorageMessage::_class_data_ = {
+    ::PROTOBUF_NAMESPACE_ID::Message::CopyWithSourceCheck,
+    StorageMessage::MergeImpl
+};
+const ::PROTOBUF_NAMESPACE_ID::Message::ClassData*StorageMessage::GetClassData() const { return &_class_data_; }
+
+
+void StorageMessage::MergeImpl(::PROTOBUF_NAMESPACE_ID::Message& to_msg, const ::PROTOBUF_NAMESPACE_ID::Message& from_msg) {
+  auto* const _this = static_cast<StorageMessage*>(&to_msg);
+  auto& from = static_cast<const StorageMessage&>(from_msg);
+  // @@protoc_insertion_point(class_specific_merge_from_start:proto.StorageMessage)
+  GOOGLE_DCHECK_NE(&from, _this);
+  uint32_t cached_has_bits = 0;
   (void) cached_has_bits;
 
-  cached_has_bits = from._has_bits_[0];
-  if (cached_has_bits & 7u) {
+  cached_has_bits = from._impl_._has_bits_[0];
+  if (cached_has_bits & 0x0000001fu) {
     if (cached_has_bits & 0x00000001u) {
-      current_term_ = from.current_term_;
+      _this->_impl_.current_term_ = from._impl_.current_term_;
     }
     if (cached_has_bits & 0x00000002u) {
-      voted_for_ = from.voted_for_;
+      _this->_impl_.voted_for_ = from._impl_.voted_for_;
     }
     if (cached_has_bits & 0x00000004u) {
-      last_applied_ = from.last_applied_;
+      _this->_impl_.last_applied_ = from._impl_.last_applied_;
+    }
+    if (cached_has_bits & 0x00000008u) {
+      _this->_impl_.snapshot_index_ = from._impl_.snapshot_index_;
+    }
+    if (cached_has_bits & 0x00000010u) {
+      _this->_impl_.snapshot_term_ = from._impl_.snapshot_term_;
     }
-    _has_bits_[0] |= cached_has_bits;
+    _this->_impl_._has_bits_[0] |= cached_has_bits;
   }
-}
-
-void StorageMessage::CopyFrom(const ::google::protobuf::Message& from) {
-// @@protoc_insertion_point(generalized_copy_from_start:proto.StorageMessage)
-  if (&from == this) return;
-  Clear();
-  MergeFrom(from);
+  _this->_internal_metadata_.MergeFrom<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(from._internal_metadata_);
 }
 
 void StorageMessage::CopyFrom(const StorageMessage& from) {
@@ -428,37 +416,36 @@ void StorageMessage::CopyFrom(const StorageMessage& from) {
 }
 
 bool StorageMessage::IsInitialized() const {
-  if ((_has_bits_[0] & 0x00000007) != 0x00000007) return false;
+  if (_Internal::MissingRequiredFields(_impl_._has_bits_)) return false;
   return true;
 }
 
-void StorageMessage::Swap(StorageMessage* other) {
-  if (other == this) return;
-  InternalSwap(other);
-}
 void StorageMessage::InternalSwap(StorageMessage* other) {
   using std::swap;
-  swap(current_term_, other->current_term_);
-  swap(voted_for_, other->voted_for_);
-  swap(last_applied_, other->last_applied_);
-  swap(_has_bits_[0], other->_has_bits_[0]);
-  _internal_metadata_.Swap(&other->_internal_metadata_);
+  _internal_metadata_.InternalSwap(&other->_internal_metadata_);
+  swap(_impl_._has_bits_[0], other->_impl_._has_bits_[0]);
+  ::PROTOBUF_NAMESPACE_ID::internal::memswap<
+      PROTOBUF_FIELD_OFFSET(StorageMessage, _impl_.snapshot_term_)
+      + sizeof(StorageMessage::_impl_.snapshot_term_)
+      - PROTOBUF_FIELD_OFFSET(StorageMessage, _impl_.current_term_)>(
+          reinterpret_cast<char*>(&_impl_.current_term_),
+          reinterpret_cast<char*>(&other->_impl_.current_term_));
 }
 
-::google::protobuf::Metadata StorageMessage::GetMetadata() const {
-  protobuf_storage_2dmessage_2eproto::protobuf_AssignDescriptorsOnce();
-  return ::protobuf_storage_2dmessage_2eproto::file_level_metadata[kIndexInFileMessages];
+::PROTOBUF_NAMESPACE_ID::Metadata StorageMessage::GetMetadata() const {
+  return ::_pbi::AssignDescriptors(
+      &descriptor_table_storage_2dmessage_2eproto_getter, &descriptor_table_storage_2dmessage_2eproto_once,
+      file_level_metadata_storage_2dmessage_2eproto[0]);
 }
 
-
 // @@protoc_insertion_point(namespace_scope)
 }  // namespace proto
-namespace google {
-namespace protobuf {
-template<> GOOGLE_PROTOBUF_ATTRIBUTE_NOINLINE ::proto::StorageMessage* Arena::CreateMaybeMessage< ::proto::StorageMessage >(Arena* arena) {
-  return Arena::CreateInternal< ::proto::StorageMessage >(arena);
+PROTOBUF_NAMESPACE_OPEN
+template<> PROTOBUF_NOINLINE ::proto::StorageMessage*
+Arena::CreateMaybeMessage< ::proto::StorageMessage >(Arena* arena) {
+  return Arena::CreateMessageInternal< ::proto::StorageMessage >(arena);
 }
-}  // namespace protobuf
-}  // namespace google
+PROTOBUF_NAMESPACE_CLOSE
 
 // @@protoc_insertion_point(global_scope)
+#include <google/protobuf/port_undef.inc>
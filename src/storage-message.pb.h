@@ -1,101 +1,111 @@
 // Generated by the protocol buffer compiler.  DO NOT EDIT!
 // source: storage-message.proto
 
-#ifndef PROTOBUF_INCLUDED_storage_2dmessage_2eproto
-#define PROTOBUF_INCLUDED_storage_2dmessage_2eproto
+#ifndef GOOGLE_PROTOBUF_INCLUDED_storage_2dmessage_2eproto
+#define GOOGLE_PROTOBUF_INCLUDED_storage_2dmessage_2eproto
 
+#include <limits>
 #include <string>
 
-#include <google/protobuf/stubs/common.h>
-
-#if GOOGLE_PROTOBUF_VERSION < 3006001
+#include <google/protobuf/port_def.inc>
+#if PROTOBUF_VERSION < 3021000
 #error This file was generated by a newer version of protoc which is
-#error incompatible with your Protocol Buffer headers.  Please update
+#error incompatible with your Protocol Buffer headers. Please update
 #error your headers.
 #endif
-#if 3006001 < GOOGLE_PROTOBUF_MIN_PROTOC_VERSION
+#if 3021012 < PROTOBUF_MIN_PROTOC_VERSION
 #error This file was generated by an older version of protoc which is
-#error incompatible with your Protocol Buffer headers.  Please
+#error incompatible with your Protocol Buffer headers. Please
 #error regenerate this file with a newer version of protoc.
 #endif
 
+#include <google/protobuf/port_undef.inc>
 #include <google/protobuf/io/coded_stream.h>
 #include <google/protobuf/arena.h>
 #include <google/protobuf/arenastring.h>
-#include <google/protobuf/generated_message_table_driven.h>
 #include <google/protobuf/generated_message_util.h>
-#include <google/protobuf/inlined_string_field.h>
-#include <google/protobuf/metadata.h>
+#include <google/protobuf/metadata_lite.h>
+#include <google/protobuf/generated_message_reflection.h>
 #include <google/protobuf/message.h>
 #include <google/protobuf/repeated_field.h>  // IWYU pragma: export
 #include <google/protobuf/extension_set.h>  // IWYU pragma: export
 #include <google/protobuf/unknown_field_set.h>
 // @@protoc_insertion_point(includes)
-#define PROTOBUF_INTERNAL_EXPORT_protobuf_storage_2dmessage_2eproto 
+#include <google/protobuf/port_def.inc>
+#define PROTOBUF_INTERNAL_EXPORT_storage_2dmessage_2eproto
+PROTOBUF_NAMESPACE_OPEN
+namespace internal {
+class AnyMetadata;
+}  // namespace internal
+PROTOBUF_NAMESPACE_CLOSE
 
-namespace protobuf_storage_2dmessage_2eproto {
 // Internal implementation detail -- do not use these members.
-struct TableStruct {
-  static const ::google::protobuf::internal::ParseTableField entries[];
-  static const ::google::protobuf::internal::AuxillaryParseTableField aux[];
-  static const ::google::protobuf::internal::ParseTable schema[1];
-  static const ::google::protobuf::internal::FieldMetadata field_metadata[];
-  static const ::google::protobuf::internal::SerializationTable serialization_table[];
-  static const ::google::protobuf::uint32 offsets[];
+struct TableStruct_storage_2dmessage_2eproto {
+  static const uint32_t offsets[];
 };
-void AddDescriptors();
-}  // namespace protobuf_storage_2dmessage_2eproto
+extern const ::PROTOBUF_NAMESPACE_ID::internal::DescriptorTable descriptor_table_storage_2dmessage_2eproto;
 namespace proto {
 class StorageMessage;
-class StorageMessageDefaultTypeInternal;
+struct StorageMessageDefaultTypeInternal;
 extern StorageMessageDefaultTypeInternal _StorageMessage_default_instance_;
 }  // namespace proto
-namespace google {
-namespace protobuf {
+PROTOBUF_NAMESPACE_OPEN
 template<> ::proto::StorageMessage* Arena::CreateMaybeMessage<::proto::StorageMessage>(Arena*);
-}  // namespace protobuf
-}  // namespace google
+PROTOBUF_NAMESPACE_CLOSE
 namespace proto {
 
 // ===================================================================
 
-class StorageMessage : public ::google::protobuf::Message /* @@protoc_insertion_point(class_definition:proto.StorageMessage) */ {
+class StorageMessage final :
+    public ::PROTOBUF_NAMESPACE_ID::Message /* @@protoc_insertion_point(class_definition:proto.StorageMessage) */ {
  public:
-  StorageMessage();
-  virtual ~StorageMessage();
+  inline StorageMessage() : StorageMessage(nullptr) {}
+  ~StorageMessage() override;
+  explicit PROTOBUF_CONSTEXPR StorageMessage(::PROTOBUF_NAMESPACE_ID::internal::ConstantInitialized);
 
   StorageMessage(const StorageMessage& from);
-
-  inline StorageMessage& operator=(const StorageMessage& from) {
-    CopyFrom(from);
-    return *this;
-  }
-  #if LANG_CXX11
   StorageMessage(StorageMessage&& from) noexcept
     : StorageMessage() {
     *this = ::std::move(from);
   }
 
+  inline StorageMessage& operator=(const StorageMessage& from) {
+    CopyFrom(from);
+    return *this;
+  }
   inline StorageMessage& operator=(StorageMessage&& from) noexcept {
-    if (GetArenaNoVirtual() == from.GetArenaNoVirtual()) {
-      if (this != &from) InternalSwap(&from);
+    if (this == &from) return *this;
+    if (GetOwningArena() == from.GetOwningArena()
+  #ifdef PROTOBUF_FORCE_COPY_IN_MOVE
+        && GetOwningArena() != nullptr
+  #endif  // !PROTOBUF_FORCE_COPY_IN_MOVE
+    ) {
+      InternalSwap(&from);
     } else {
       CopyFrom(from);
     }
     return *this;
   }
-  #endif
-  inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
-    return _internal_metadata_.unknown_fields();
+
+  inline const ::PROTOBUF_NAMESPACE_ID::UnknownFieldSet& unknown_fields() const {
+    return _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance);
   }
-  inline ::google::protobuf::UnknownFieldSet* mutable_unknown_fields() {
-    return _internal_metadata_.mutable_unknown_fields();
+  inline ::PROTOBUF_NAMESPACE_ID::UnknownFieldSet* mutable_unknown_fields() {
+    return _internal_metadata_.mutable_unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>();
   }
 
-  static const ::google::protobuf::Descriptor* descriptor();
-  static const StorageMessage& default_instance();
-
-  static void InitAsDefaultInstance();  // FOR INTERNAL USE ONLY
+  static const ::PROTOBUF_NAMESPACE_ID::Descriptor* descriptor() {
+    return GetDescriptor();
+  }
+  static const ::PROTOBUF_NAMESPACE_ID::Descriptor* GetDescriptor() {
+    return default_instance().GetMetadata().descriptor;
+  }
+  static const ::PROTOBUF_NAMESPACE_ID::Reflection* GetReflection() {
+    return default_instance().GetMetadata().reflection;
+  }
+  static const StorageMessage& default_instance() {
+    return *internal_default_instance();
+  }
   static inline const StorageMessage* internal_default_instance() {
     return reinterpret_cast<const StorageMessage*>(
                &_StorageMessage_default_instance_);
@@ -103,96 +113,169 @@ class StorageMessage : public ::google::protobuf::Message /* @@protoc_insertion_
   static constexpr int kIndexInFileMessages =
     0;
 
-  void Swap(StorageMessage* other);
   friend void swap(StorageMessage& a, StorageMessage& b) {
     a.Swap(&b);
   }
+  inline void Swap(StorageMessage* other) {
+    if (other == this) return;
+  #ifdef PROTOBUF_FORCE_COPY_IN_SWAP
+    if (GetOwningArena() != nullptr &&
+        GetOwningArena() == other->GetOwningArena()) {
+   #else  // PROTOBUF_FORCE_COPY_IN_SWAP
+    if (GetOwningArena() == other->GetOwningArena()) {
+  #endif  // !PROTOBUF_FORCE_COPY_IN_SWAP
+      InternalSwap(other);
+    } else {
+      ::PROTOBUF_NAMESPACE_ID::internal::GenericSwap(this, other);
+    }
+  }
+  void UnsafeArenaSwap(StorageMessage* other) {
+    if (other == this) return;
+    GOOGLE_DCHECK(GetOwningArena() == other->GetOwningArena());
+    InternalSwap(other);
+  }
 
   // implements Message ----------------------------------------------
 
-  inline StorageMessage* New() const final {
-    return CreateMaybeMessage<StorageMessage>(NULL);
-  }
-
-  StorageMessage* New(::google::protobuf::Arena* arena) const final {
+  StorageMessage* New(::PROTOBUF_NAMESPACE_ID::Arena* arena = nullptr) const final {
     return CreateMaybeMessage<StorageMessage>(arena);
   }
-  void CopyFrom(const ::google::protobuf::Message& from) final;
-  void MergeFrom(const ::google::protobuf::Message& from) final;
+  using ::PROTOBUF_NAMESPACE_ID::Message::CopyFrom;
   void CopyFrom(const StorageMessage& from);
-  void MergeFrom(const StorageMessage& from);
-  void Clear() final;
+  using ::PROTOBUF_NAMESPACE_ID::Message::MergeFrom;
+  void MergeFrom( const StorageMessage& from) {
+    StorageMessage::MergeImpl(*this, from);
+  }
+  private:
+  static void MergeImpl(::PROTOBUF_NAMESPACE_ID::Message& to_msg, const ::PROTOBUF_NAMESPACE_ID::Message& from_msg);
+  public:
+  PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
   bool IsInitialized() const final;
 
   size_t ByteSizeLong() const final;
-  bool MergePartialFromCodedStream(
-      ::google::protobuf::io::CodedInputStream* input) final;
-  void SerializeWithCachedSizes(
-      ::google::protobuf::io::CodedOutputStream* output) const final;
-  ::google::protobuf::uint8* InternalSerializeWithCachedSizesToArray(
-      bool deterministic, ::google::protobuf::uint8* target) const final;
-  int GetCachedSize() const final { return _cached_size_.Get(); }
+  const char* _InternalParse(const char* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ParseContext* ctx) final;
+  uint8_t* _InternalSerialize(
+      uint8_t* target, ::PROTOBUF_NAMESPACE_ID::io::EpsCopyOutputStream* stream) const final;
+  int GetCachedSize() const final { return _impl_._cached_size_.Get(); }
 
   private:
-  void SharedCtor();
+  void SharedCtor(::PROTOBUF_NAMESPACE_ID::Arena* arena, bool is_message_owned);
   void SharedDtor();
   void SetCachedSize(int size) const final;
   void InternalSwap(StorageMessage* other);
+
   private:
-  inline ::google::protobuf::Arena* GetArenaNoVirtual() const {
-    return NULL;
-  }
-  inline void* MaybeArenaPtr() const {
-    return NULL;
+  friend class ::PROTOBUF_NAMESPACE_ID::internal::AnyMetadata;
+  static ::PROTOBUF_NAMESPACE_ID::StringPiece FullMessageName() {
+    return "proto.StorageMessage";
   }
+  protected:
+  explicit StorageMessage(::PROTOBUF_NAMESPACE_ID::Arena* arena,
+                       bool is_message_owned = false);
   public:
 
-  ::google::protobuf::Metadata GetMetadata() const final;
+  static const ClassData _class_data_;
+  const ::PROTOBUF_NAMESPACE_ID::Message::ClassData*GetClassData() const final;
+
+  ::PROTOBUF_NAMESPACE_ID::Metadata GetMetadata() const final;
 
   // nested types ----------------------------------------------------
 
   // accessors -------------------------------------------------------
 
+  enum : int {
+    kCurrentTermFieldNumber = 1,
+    kVotedForFieldNumber = 2,
+    kLastAppliedFieldNumber = 3,
+    kSnapshotIndexFieldNumber = 4,
+    kSnapshotTermFieldNumber = 5,
+  };
   // required int32 current_term = 1;
   bool has_current_term() const;
+  private:
+  bool _internal_has_current_term() const;
+  public:
   void clear_current_term();
-  static const int kCurrentTermFieldNumber = 1;
-  ::google::protobuf::int32 current_term() const;
-  void set_current_term(::google::protobuf::int32 value);
+  int32_t current_term() const;
+  void set_current_term(int32_t value);
+  private:
+  int32_t _internal_current_term() const;
+  void _internal_set_current_term(int32_t value);
+  public:
 
   // required int32 voted_for = 2;
   bool has_voted_for() const;
+  private:
+  bool _internal_has_voted_for() const;
+  public:
   void clear_voted_for();
-  static const int kVotedForFieldNumber = 2;
-  ::google::protobuf::int32 voted_for() const;
-  void set_voted_for(::google::protobuf::int32 value);
+  int32_t voted_for() const;
+  void set_voted_for(int32_t value);
+  private:
+  int32_t _internal_voted_for() const;
+  void _internal_set_voted_for(int32_t value);
+  public:
 
   // required int32 last_applied = 3;
   bool has_last_applied() const;
+  private:
+  bool _internal_has_last_applied() const;
+  public:
   void clear_last_applied();
-  static const int kLastAppliedFieldNumber = 3;
-  ::google::protobuf::int32 last_applied() const;
-  void set_last_applied(::google::protobuf::int32 value);
+  int32_t last_applied() const;
+  void set_last_applied(int32_t value);
+  private:
+  int32_t _internal_last_applied() const;
+  void _internal_set_last_applied(int32_t value);
+  public:
+
+  // optional int32 snapshot_index = 4 [default = 0];
+  bool has_snapshot_index() const;
+  private:
+  bool _internal_has_snapshot_index() const;
+  public:
+  void clear_snapshot_index();
+  int32_t snapshot_index() const;
+  void set_snapshot_index(int32_t value);
+  private:
+  int32_t _internal_snapshot_index() const;
+  void _internal_set_snapshot_index(int32_t value);
+  public:
+
+  // optional int32 snapshot_term = 5 [default = 0];
+  bool has_snapshot_term() const;
+  private:
+  bool _internal_has_snapshot_term() const;
+  public:
+  void clear_snapshot_term();
+  int32_t snapshot_term() const;
+  void set_snapshot_term(int32_t value);
+  private:
+  int32_t _internal_snapshot_term() const;
+  void _internal_set_snapshot_term(int32_t value);
+  public:
 
   // @@protoc_insertion_point(class_scope:proto.StorageMessage)
  private:
-  void set_has_current_term();
-  void clear_has_current_term();
-  void set_has_voted_for();
-  void clear_has_voted_for();
-  void set_has_last_applied();
-  void clear_has_last_applied();
+  class _Internal;
 
   // helper for ByteSizeLong()
   size_t RequiredFieldsByteSizeFallback() const;
 
-  ::google::protobuf::internal::InternalMetadataWithArena _internal_metadata_;
-  ::google::protobuf::internal::HasBits<1> _has_bits_;
-  mutable ::google::protobuf::internal::CachedSize _cached_size_;
-  ::google::protobuf::int32 current_term_;
-  ::google::protobuf::int32 voted_for_;
-  ::google::protobuf::int32 last_applied_;
-  friend struct ::protobuf_storage_2dmessage_2eproto::TableStruct;
+  template <typename T> friend class ::PROTOBUF_NAMESPACE_ID::Arena::InternalHelper;
+  typedef void InternalArenaConstructable_;
+  typedef void DestructorSkippable_;
+  struct Impl_ {
+    ::PROTOBUF_NAMESPACE_ID::internal::HasBits<1> _has_bits_;
+    mutable ::PROTOBUF_NAMESPACE_ID::internal::CachedSize _cached_size_;
+    int32_t current_term_;
+    int32_t voted_for_;
+    int32_t last_applied_;
+    int32_t snapshot_index_;
+    int32_t snapshot_term_;
+  };
+  union { Impl_ _impl_; };
+  friend struct ::TableStruct_storage_2dmessage_2eproto;
 };
 // ===================================================================
 
@@ -206,77 +289,145 @@ class StorageMessage : public ::google::protobuf::Message /* @@protoc_insertion_
 // StorageMessage
 
 // required int32 current_term = 1;
-inline bool StorageMessage::has_current_term() const {
-  return (_has_bits_[0] & 0x00000001u) != 0;
+inline bool StorageMessage::_internal_has_current_term() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000001u) != 0;
+  return value;
 }
-inline void StorageMessage::set_has_current_term() {
-  _has_bits_[0] |= 0x00000001u;
-}
-inline void StorageMessage::clear_has_current_term() {
-  _has_bits_[0] &= ~0x00000001u;
+inline bool StorageMessage::has_current_term() const {
+  return _internal_has_current_term();
 }
 inline void StorageMessage::clear_current_term() {
-  current_term_ = 0;
-  clear_has_current_term();
+  _impl_.current_term_ = 0;
+  _impl_._has_bits_[0] &= ~0x00000001u;
+}
+inline int32_t StorageMessage::_internal_current_term() const {
+  return _impl_.current_term_;
 }
-inline ::google::protobuf::int32 StorageMessage::current_term() const {
+inline int32_t StorageMessage::current_term() const {
   // @@protoc_insertion_point(field_get:proto.StorageMessage.current_term)
-  return current_term_;
+  return _internal_current_term();
 }
-inline void StorageMessage::set_current_term(::google::protobuf::int32 value) {
-  set_has_current_term();
-  current_term_ = value;
+inline void StorageMessage::_internal_set_current_term(int32_t value) {
+  _impl_._has_bits_[0] |= 0x00000001u;
+  _impl_.current_term_ = value;
+}
+inline void StorageMessage::set_current_term(int32_t value) {
+  _internal_set_current_term(value);
   // @@protoc_insertion_point(field_set:proto.StorageMessage.current_term)
 }
 
 // required int32 voted_for = 2;
-inline bool StorageMessage::has_voted_for() const {
-  return (_has_bits_[0] & 0x00000002u) != 0;
+inline bool StorageMessage::_internal_has_voted_for() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000002u) != 0;
+  return value;
 }
-inline void StorageMessage::set_has_voted_for() {
-  _has_bits_[0] |= 0x00000002u;
-}
-inline void StorageMessage::clear_has_voted_for() {
-  _has_bits_[0] &= ~0x00000002u;
+inline bool StorageMessage::has_voted_for() const {
+  return _internal_has_voted_for();
 }
 inline void StorageMessage::clear_voted_for() {
-  voted_for_ = 0;
-  clear_has_voted_for();
+  _impl_.voted_for_ = 0;
+  _impl_._has_bits_[0] &= ~0x00000002u;
+}
+inline int32_t StorageMessage::_internal_voted_for() const {
+  return _impl_.voted_for_;
 }
-inline ::google::protobuf::int32 StorageMessage::voted_for() const {
+inline int32_t StorageMessage::voted_for() const {
   // @@protoc_insertion_point(field_get:proto.StorageMessage.voted_for)
-  return voted_for_;
+  return _internal_voted_for();
 }
-inline void StorageMessage::set_voted_for(::google::protobuf::int32 value) {
-  set_has_voted_for();
-  voted_for_ = value;
+inline void StorageMessage::_internal_set_voted_for(int32_t value) {
+  _impl_._has_bits_[0] |= 0x00000002u;
+  _impl_.voted_for_ = value;
+}
+inline void StorageMessage::set_voted_for(int32_t value) {
+  _internal_set_voted_for(value);
   // @@protoc_insertion_point(field_set:proto.StorageMessage.voted_for)
 }
 
 // required int32 last_applied = 3;
-inline bool StorageMessage::has_last_applied() const {
-  return (_has_bits_[0] & 0x00000004u) != 0;
+inline bool StorageMessage::_internal_has_last_applied() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000004u) != 0;
+  return value;
 }
-inline void StorageMessage::set_has_last_applied() {
-  _has_bits_[0] |= 0x00000004u;
-}
-inline void StorageMessage::clear_has_last_applied() {
-  _has_bits_[0] &= ~0x00000004u;
+inline bool StorageMessage::has_last_applied() const {
+  return _internal_has_last_applied();
 }
 inline void StorageMessage::clear_last_applied() {
-  last_applied_ = 0;
-  clear_has_last_applied();
+  _impl_.last_applied_ = 0;
+  _impl_._has_bits_[0] &= ~0x00000004u;
+}
+inline int32_t StorageMessage::_internal_last_applied() const {
+  return _impl_.last_applied_;
 }
-inline ::google::protobuf::int32 StorageMessage::last_applied() const {
+inline int32_t StorageMessage::last_applied() const {
   // @@protoc_insertion_point(field_get:proto.StorageMessage.last_applied)
-  return last_applied_;
+  return _internal_last_applied();
 }
-inline void StorageMessage::set_last_applied(::google::protobuf::int32 value) {
-  set_has_last_applied();
-  last_applied_ = value;
+inline void StorageMessage::_internal_set_last_applied(int32_t value) {
+  _impl_._has_bits_[0] |= 0x00000004u;
+  _impl_.last_applied_ = value;
+}
+inline void StorageMessage::set_last_applied(int32_t value) {
+  _internal_set_last_applied(value);
   // @@protoc_insertion_point(field_set:proto.StorageMessage.last_applied)
 }
 
+// optional int32 snapshot_index = 4 [default = 0];
+inline bool StorageMessage::_internal_has_snapshot_index() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000008u) != 0;
+  return value;
+}
+inline bool StorageMessage::has_snapshot_index() const {
+  return _internal_has_snapshot_index();
+}
+inline void StorageMessage::clear_snapshot_index() {
+  _impl_.snapshot_index_ = 0;
+  _impl_._has_bits_[0] &= ~0x00000008u;
+}
+inline int32_t StorageMessage::_internal_snapshot_index() const {
+  return _impl_.snapshot_index_;
+}
+inline int32_t StorageMessage::snapshot_index() const {
+  // @@protoc_insertion_point(field_get:proto.StorageMessage.snapshot_index)
+  return _internal_snapshot_index();
+}
+inline void StorageMessage::_internal_set_snapshot_index(int32_t value) {
+  _impl_._has_bits_[0] |= 0x00000008u;
+  _impl_.snapshot_index_ = value;
+}
+inline void StorageMessage::set_snapshot_index(int32_t value) {
+  _internal_set_snapshot_index(value);
+  // @@protoc_insertion_point(field_set:proto.StorageMessage.snapshot_index)
+}
+
+// optional int32 snapshot_term = 5 [default = 0];
+inline bool StorageMessage::_internal_has_snapshot_term() const {
+  bool value = (_impl_._has_bits_[0] & 0x00000010u) != 0;
+  return value;
+}
+inline bool StorageMessage::has_snapshot_term() const {
+  return _internal_has_snapshot_term();
+}
+inline void StorageMessage::clear_snapshot_term() {
+  _impl_.snapshot_term_ = 0;
+  _impl_._has_bits_[0] &= ~0x00000010u;
+}
+inline int32_t StorageMessage::_internal_snapshot_term() const {
+  return _impl_.snapshot_term_;
+}
+inline int32_t StorageMessage::snapshot_term() const {
+  // @@protoc_insertion_point(field_get:proto.StorageMessage.snapshot_term)
+  return _internal_snapshot_term();
+}
+inline void StorageMessage::_internal_set_snapshot_term(int32_t value) {
+  _impl_._has_bits_[0] |= 0x00000010u;
+  _impl_.snapshot_term_ = value;
+}
+inline void StorageMessage::set_snapshot_term(int32_t value) {
+  _internal_set_snapshot_term(value);
+  // @@protoc_insertion_point(field_set:proto.StorageMessage.snapshot_term)
+}
+
 #ifdef __GNUC__
   #pragma GCC diagnostic pop
 #endif  // __GNUC__
@@ -287,4 +438,5 @@ inline void StorageMessage::set_last_applied(::google::protobuf::int32 value) {
 
 // @@protoc_insertion_point(global_scope)
 
-#endif  // PROTOBUF_INCLUDED_storage_2dmessage_2eproto
+#include <google/protobuf/port_undef.inc>
+#endif  // GOOGLE_PROTOBUF_INCLUDED_GOOGLE_PROTOBUF_INCLUDED_storage_2dmessage_2eproto
@@ -1,6 +1,6 @@
 #include "util.h"
 
-const string Util::ProtoDebugString(::google::protobuf::Message& message) {
+const string Util::ProtoDebugString(const ::google::protobuf::Message& message) {
     string str = message.DebugString();
     // Remove trailing newline
     str = str.substr(0, str.size() - 1);
@@ -68,7 +68,7 @@ bool Util::SyscallErrorInfo(bool syscall_success, const char *error_message_pref
 }
 
 
-bool Util::PersistentFileUpdate(const char * filename, const void * new_contents, int new_contents_len) {
+bool Util::PersistentFileUpdate(const char * filename, const void * new_contents, int new_contents_len, bool sync) {
   // assume old file is safe
   std::string tmp_filename = "tmp_" + std::string(filename);
   debug("tmp name: %s", tmp_filename.c_str());
@@ -79,15 +79,87 @@ bool Util::PersistentFileUpdate(const char * filename, const void * new_contents
     "fwrite of new_contents to tmp_file failed"); //TODO include more info
   bool flushed = SyscallErrorInfo(0 == fflush(tmp_file),
     "Error: fflush failed to push all writes to disk, ");
+  bool synced = !sync || SyncFileData(fileno(tmp_file));
   bool closed = SyscallErrorInfo(0 == fclose(tmp_file), "fclose of tmp_file failed"); //TODO include filename
-  if (opened && written && closed && flushed) {
-    return SyscallErrorInfo(0 == rename(tmp_filename.c_str(), filename),
+  if (opened && written && closed && flushed && synced) {
+    bool renamed = SyscallErrorInfo(0 == rename(tmp_filename.c_str(), filename),
     "rename of tmp_filename to filename failed"); //TODO: include more info
+    return renamed && (!sync || SyncDirectory(filename));
   }
   warn("File Update Failed %s, %s, %d", filename, new_contents, new_contents_len);
   return false;
 }
 
+bool Util::SyncFileData(int fd) {
+#ifdef __APPLE__
+  return SyscallErrorInfo(0 == fcntl(fd, F_FULLFSYNC), "fcntl F_FULLFSYNC failed");
+#else
+  return SyscallErrorInfo(0 == fdatasync(fd), "fdatasync failed");
+#endif
+}
+
+uint32_t Util::Crc32c(uint32_t crc, const void * data, int len) {
+  static uint32_t table[256];
+  static bool table_ready = [] {
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t entry = i;
+      for (int bit = 0; bit < 8; bit++) {
+        entry = (entry >> 1) ^ ((entry & 1) ? 0x82F63B78 : 0); // reversed polynomial
+      }
+      table[i] = entry;
+    }
+    return true;
+  }();
+  (void) table_ready;
+
+  const unsigned char *bytes = (const unsigned char *) data;
+  crc = ~crc;
+  for (int i = 0; i < len; i++) {
+    crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+bool Util::PreallocateFile(int fd, int size) {
+#ifdef __APPLE__
+  // macOS has no posix_fallocate, reserve the space then extend the file
+  fstore_t store = {F_ALLOCATECONTIG, F_PEOFPOSMODE, 0, size, 0};
+  if (fcntl(fd, F_PREALLOCATE, &store) == -1) {
+    store.fst_flags = F_ALLOCATEALL;
+    if (!SyscallErrorInfo(fcntl(fd, F_PREALLOCATE, &store) != -1, "fcntl F_PREALLOCATE failed")) {
+      return false;
+    }
+  }
+  return SyscallErrorInfo(0 == ftruncate(fd, size), "ftruncate failed");
+#else
+  int error = posix_fallocate(fd, 0, size);
+  errno = error; // posix_fallocate returns the error rather than setting errno
+  return SyscallErrorInfo(error == 0, "posix_fallocate failed");
+#endif
+}
+
+bool Util::SyncFile(const char * filename) {
+  int fd = open(filename, O_RDONLY);
+  if (!SyscallErrorInfo(fd != -1, "open of file to sync failed")) {
+    return false;
+  }
+  bool synced = SyncFileData(fd);
+  SafeClose(fd);
+  return synced;
+}
+
+bool Util::SyncDirectory(const char * filename) {
+  // dirname may modify its argument, so give it a copy
+  std::string filename_copy(filename);
+  int dir_fd = open(dirname(&filename_copy[0]), O_RDONLY);
+  if (!SyscallErrorInfo(dir_fd != -1, "open of directory to sync failed")) {
+    return false;
+  }
+  bool synced = SyscallErrorInfo(0 == fsync(dir_fd), "fsync of directory failed");
+  SafeClose(dir_fd);
+  return synced;
+}
+
 void Util::SafeClose(int fd) {
     if (close(fd) == -1) {
         warn("Error closing socket %d (%s)", fd, strerror(errno));
@@ -7,6 +7,9 @@
 #include <algorithm>
 #include <google/protobuf/message.h>
 
+#include <fcntl.h>
+#include <libgen.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <unistd.h>
 #include <errno.h>
@@ -31,7 +34,7 @@ class Util {
          * @param  message The Protocol Buffer message to convert to a string
          * @return  String representation of the Protocol Buffer
          */
-        static const string ProtoDebugString(Message& message);
+        static const string ProtoDebugString(const Message& message);
 
         /**
          * Split the given string str into a vector of strings using the given
@@ -105,12 +108,65 @@ class Util {
          * @param filename - file to be updated
          * @param new_contents - pointer to start of new file contents
          * @param new_contents_len - length of new file contents
+         * @param sync - if true, also fsync the new file before the rename and
+         *      the directory after it, so the update survives a power loss
          * @return bool - whether we successfully updated file to new contents
          *
          * NOTE: creates a whole new file, so new_contents_len should be
          * relatively short.  E.g. don't use for a large log.
          */
-        static bool PersistentFileUpdate(const char * filename, const void * new_contents, int new_contents_len);
+        static bool PersistentFileUpdate(const char * filename,
+            const void * new_contents, int new_contents_len, bool sync = false);
+
+        /*
+         * Force the data of an open file down to the disk itself, not just
+         * the kernel (fdatasync, or F_FULLFSYNC on macOS where fsync alone
+         * doesn't flush the drive's cache).
+         *
+         * @param fd - file descriptor of the file to sync
+         * @return bool - whether the sync succeeded
+         */
+        static bool SyncFileData(int fd);
+
+        /*
+         * Extend a CRC32C (Castagnoli) checksum with len more bytes of data.
+         * Start a new checksum with crc = 0.
+         *
+         * @param crc - checksum of the preceding data
+         * @param data - pointer to the data to add
+         * @param len - length of the data to add
+         * @return uint32_t - checksum of the preceding data followed by data
+         */
+        static uint32_t Crc32c(uint32_t crc, const void * data, int len);
+
+        /*
+         * Allocate disk space for the first size bytes of an open file,
+         * extending it with zeros if it is shorter, so later writes within
+         * that range don't have to grow the file.
+         *
+         * @param fd - file descriptor of the file to preallocate
+         * @param size - number of bytes to allocate
+         * @return bool - whether the space was allocated
+         */
+        static bool PreallocateFile(int fd, int size);
+
+        /*
+         * Force the data of the file at filename down to the disk, see
+         * SyncFileData.
+         *
+         * @param filename - path of the file to sync
+         * @return bool - whether the sync succeeded
+         */
+        static bool SyncFile(const char * filename);
+
+        /*
+         * Fsync the directory containing filename, making a preceding create
+         * or rename of filename durable.
+         *
+         * @param filename - path of a file in the directory to sync
+         * @return bool - whether the sync succeeded
+         */
+        static bool SyncDirectory(const char * filename);
 
         /**
          * Close a file descriptor and print a warning if closing fails.